@@ -0,0 +1,77 @@
+// brdf_lut.cpp
+#include "brdf_lut.h"
+#include "half_float.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const float PI = 3.14159265358979f;
+
+void Hammersley(uint32_t i, uint32_t n, float& u, float& v) {
+    uint32_t bits = i;
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    u = static_cast<float>(i) / static_cast<float>(n);
+    v = static_cast<float>(bits) * 2.3283064365386963e-10f;
+}
+
+// Smith-Schlick visibility with the IBL remapping k = alpha / 2 (alpha = roughness^2)
+static float GeometrySchlick(float NdotX, float k) {
+    return NdotX / (NdotX * (1.0f - k) + k);
+}
+
+// GGX-distributed half vectors around N = +Z for one roughness. Only their X and Z
+// are kept: V lies in the XZ plane, so Y never enters a dot product.
+static void SampleHalfVectors(float roughness, int sampleCount, std::vector<float>& hx, std::vector<float>& hz) {
+    const float alpha = roughness * roughness;
+    hx.resize(sampleCount);
+    hz.resize(sampleCount);
+    for (int i = 0; i < sampleCount; ++i) {
+        float u, v;
+        Hammersley(static_cast<uint32_t>(i), static_cast<uint32_t>(sampleCount), u, v);
+        const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+        const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        hx[i] = sinTheta * std::cos(2.0f * PI * u);
+        hz[i] = cosTheta;
+    }
+}
+
+// Scale and bias for F0 at one N.V, averaged over the row's half vectors
+static void IntegrateBrdf(float NdotV, float k, const std::vector<float>& hx, const std::vector<float>& hz,
+                          float& scale, float& bias) {
+    const float Vx = std::sqrt(1.0f - NdotV * NdotV), Vz = NdotV;
+    const float visibilityV = GeometrySchlick(NdotV, k) / NdotV;
+    scale = 0.0f;
+    bias = 0.0f;
+    for (size_t i = 0; i < hx.size(); ++i) {
+        const float VdotH = std::max(Vx * hx[i] + Vz * hz[i], 0.0f);
+        const float NdotL = 2.0f * VdotH * hz[i] - Vz; // L = reflect(-V, H); only N.L matters
+        if (NdotL <= 0.0f) continue;
+        const float visibility = GeometrySchlick(NdotL, k) * visibilityV * VdotH / hz[i];
+        const float f = 1.0f - VdotH, fresnel = f * f * f * f * f;
+        scale += (1.0f - fresnel) * visibility;
+        bias += fresnel * visibility;
+    }
+    scale /= static_cast<float>(hx.size());
+    bias /= static_cast<float>(hx.size());
+}
+
+void ComputeBrdfLut(int size, int sampleCount, std::vector<uint16_t>& texels) {
+    texels.assign(static_cast<size_t>(size) * size * 2, 0);
+    ParallelFor(static_cast<size_t>(size), [&](size_t begin, size_t end) {
+        std::vector<float> row(static_cast<size_t>(size) * 2), hx, hz;
+        for (size_t y = begin; y < end; ++y) {
+            const float roughness = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+            SampleHalfVectors(roughness, sampleCount, hx, hz);
+            for (int x = 0; x < size; ++x) {
+                const float NdotV = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+                IntegrateBrdf(NdotV, roughness * roughness / 2.0f, hx, hz, row[x * 2], row[x * 2 + 1]);
+            }
+            FloatRowToHalves(row.data(), texels.data() + y * size * 2, row.size());
+        }
+    });
+}
@@ -0,0 +1,24 @@
+// brdf_lut.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Split-sum BRDF integration table
+// ─────
+// The specular IBL integral splits into the prefiltered environment (a GGX
+// lobe per roughness, baked into the mips of a cubemap) and the integral of
+// the BRDF itself over a white environment, which only depends on N.V and
+// roughness (Karis, "Real Shading in Unreal Engine 4"). The second part is
+// this table: a scale and a bias for F0, so basic.frag shades with
+// prefiltered * (F0 * scale + bias) at the cost of one 2D fetch. It is the
+// same for every environment; computed once on the CPU in parallel.
+const int BRDF_LUT_SIZE = 128;
+const int BRDF_LUT_SAMPLES = 512;
+
+// size^2 RG half floats, N.V along x and roughness along y (texel centers), bottom row first
+void ComputeBrdfLut(int size, int sampleCount, std::vector<uint16_t>& texels);
+
+// Low-discrepancy point i of n (i / n and the radical inverse of i); the GGX samples of
+// the LUT and of the environment prefilter (prefilter_ggx.frag, ibl_bake.cpp)
+void Hammersley(uint32_t i, uint32_t n, float& u, float& v);
@@ -0,0 +1,166 @@
+// file_utils.cpp
+#include "file_utils.h"
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference
+    if (view == MAP_FAILED) return false;
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    CloseHandle(static_cast<HANDLE>(file_));
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+    // FNV-1a over 8-byte words (tail bytewise), then a final avalanche
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = 0xcbf29ce484222325ull ^ seed;
+    const uint64_t prime = 0x100000001b3ull;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        h = (h ^ word) * prime;
+    }
+    for (; i < size; ++i)
+        h = (h ^ p[i]) * prime;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t HashFileSampled(const std::string& path) {
+    // Hashing a multi-GB source on every launch would cost as much as parsing it,
+    // so only 16 evenly spaced 64 KiB blocks (plus the size) go into the hash.
+    const size_t BLOCK = 64 * 1024;
+    const int SAMPLES = 16;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return 0;
+    uint64_t size = static_cast<uint64_t>(file.tellg());
+
+    uint64_t h = HashBytes(&size, sizeof(size));
+    std::vector<char> block(BLOCK);
+    for (int s = 0; s < SAMPLES; ++s) {
+        uint64_t offset = size > BLOCK ? (size - BLOCK) * s / (SAMPLES - 1) : 0;
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(block.data(), BLOCK);
+        h = HashBytes(block.data(), static_cast<size_t>(file.gcount()), h);
+        file.clear();
+        if (size <= BLOCK) break;
+    }
+    return h;
+}
+
+bool WriteFileAtomic(const std::string& path, const std::vector<FileChunk>& chunks) {
+    std::string tmpPath = path + ".tmp";
+    bool written;
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Cannot write file: " << tmpPath << std::endl;
+            return false;
+        }
+        for (const FileChunk& chunk : chunks)
+            out.write(static_cast<const char*>(chunk.data), static_cast<std::streamsize>(chunk.size));
+        written = static_cast<bool>(out);
+    }
+
+    std::error_code ec;
+    if (!written) {
+        std::cerr << "Short write: " << tmpPath << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::cerr << "Cannot replace " << path << ": " << ec.message() << std::endl;
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool PatchFile(const std::string& path, size_t offset, const void* data, size_t size) {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (!file.is_open()) return false;
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
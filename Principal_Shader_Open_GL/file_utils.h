@@ -0,0 +1,48 @@
+// file_utils.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// MappedFile: read-only memory mapping of a whole file
+// ─────
+// Lets loaders hand file contents straight to the GPU (or a parser) without
+// copying them into a heap buffer first. Closed automatically on destruction.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0); // 64-bit FNV-1a style hash
+uint64_t HashFileSampled(const std::string& path); // hashes size + evenly spaced blocks, no full read
+
+// One contiguous piece of an output file; lets writers stream header + payload
+// arrays without first concatenating them into a single buffer.
+struct FileChunk {
+    const void* data;
+    size_t size;
+};
+bool WriteFileAtomic(const std::string& path, const std::vector<FileChunk>& chunks); // temp file + rename
+// Overwrites `size` bytes at `offset` in place (no temp file); for refreshing a cache header.
+// Fails while the file is mapped on Windows, so close any MappedFile of it first.
+bool PatchFile(const std::string& path, size_t offset, const void* data, size_t size);
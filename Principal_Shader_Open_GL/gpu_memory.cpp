@@ -0,0 +1,187 @@
+// gpu_memory.cpp
+#include "gpu_memory.h"
+#include "file_utils.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+struct GpuResource {
+    size_t bytes = 0;
+    std::string label;
+    std::string state;
+};
+
+static const int KIND_COUNT = static_cast<int>(GpuMemoryKind::Count);
+
+// Textures and buffers have separate name spaces, so the kind is part of the key
+static std::map<std::pair<int, GLuint>, GpuResource> g_resources;
+static GpuMemoryStats g_memory = [] {
+    GpuMemoryStats stats;
+    size_t megabytes = 1024;
+    if (const char* env = std::getenv("PBR_GPU_MEMORY_MB")) // small-memory machines
+        megabytes = static_cast<size_t>(std::max(1, std::atoi(env)));
+    stats.budget = megabytes << 20;
+    return stats;
+}();
+
+const char* GpuMemoryKindName(GpuMemoryKind kind) {
+    switch (kind) {
+    case GpuMemoryKind::MaterialTexture: return "material textures";
+    case GpuMemoryKind::Environment: return "environment";
+    case GpuMemoryKind::MeshBuffer: return "mesh buffers";
+    case GpuMemoryKind::Count: break;
+    }
+    return "?";
+}
+
+void TrackGpuMemory(GpuMemoryKind kind, GLuint name, size_t bytes, const std::string& label, const std::string& state) {
+    if (!name) return;
+    const int k = static_cast<int>(kind);
+    auto inserted = g_resources.emplace(std::make_pair(k, name), GpuResource());
+    GpuResource& resource = inserted.first->second;
+    if (inserted.second) ++g_memory.resources[k];
+    g_memory.bytes[k] += bytes - resource.bytes; // unsigned wrap-around works out for shrinking too
+    g_memory.total += bytes - resource.bytes;
+    g_memory.peak = std::max(g_memory.peak, g_memory.total);
+    resource.bytes = bytes;
+    resource.label = label;
+    resource.state = state;
+}
+
+void SetGpuMemoryState(GpuMemoryKind kind, GLuint name, const std::string& state) {
+    auto it = g_resources.find(std::make_pair(static_cast<int>(kind), name));
+    if (it != g_resources.end()) it->second.state = state;
+}
+
+void UntrackGpuMemory(GpuMemoryKind kind, GLuint name) {
+    auto it = g_resources.find(std::make_pair(static_cast<int>(kind), name));
+    if (it == g_resources.end()) return;
+    const int k = static_cast<int>(kind);
+    g_memory.bytes[k] -= it->second.bytes;
+    g_memory.total -= it->second.bytes;
+    --g_memory.resources[k];
+    g_resources.erase(it);
+}
+
+size_t TrackTextureMemory(GpuMemoryKind kind, GLenum target, GLuint texture, const std::string& label) {
+    const bool cube = target == GL_TEXTURE_CUBE_MAP;
+    const GLenum levelTarget = cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+    GLint previous = 0;
+    glGetIntegerv(cube ? GL_TEXTURE_BINDING_CUBE_MAP : GL_TEXTURE_BINDING_2D, &previous);
+    glBindTexture(target, texture);
+
+    GLint maxLevel = 0;
+    glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+    size_t bytes = 0;
+    for (GLint level = 0; level <= std::min(maxLevel, 15); ++level) {
+        GLint width = 0, height = 0, compressed = 0;
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+        if (width == 0 || height == 0) break; // never defined
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &compressed);
+        size_t levelBytes = 0;
+        if (compressed) {
+            GLint size = 0;
+            glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+            levelBytes = static_cast<size_t>(size);
+        } else {
+            // Bits per texel from the channel sizes the driver actually allocated
+            static const GLenum SIZE_QUERIES[] = { GL_TEXTURE_RED_SIZE, GL_TEXTURE_GREEN_SIZE, GL_TEXTURE_BLUE_SIZE,
+                                                   GL_TEXTURE_ALPHA_SIZE, GL_TEXTURE_DEPTH_SIZE };
+            GLint bits = 0;
+            for (GLenum query : SIZE_QUERIES) {
+                GLint channelBits = 0;
+                glGetTexLevelParameteriv(levelTarget, level, query, &channelBits);
+                bits += channelBits;
+            }
+            levelBytes = static_cast<size_t>(width) * height * ((bits + 7) / 8);
+        }
+        bytes += levelBytes * (cube ? 6 : 1);
+    }
+    glBindTexture(target, static_cast<GLuint>(previous));
+    TrackGpuMemory(kind, texture, bytes, label);
+    return bytes;
+}
+
+void DeleteTrackedTexture(GpuMemoryKind kind, GLuint& texture) {
+    if (!texture) return;
+    UntrackGpuMemory(kind, texture);
+    glDeleteTextures(1, &texture);
+    texture = 0;
+}
+
+size_t GpuMemoryBudget() {
+    return g_memory.budget;
+}
+
+void SetGpuMemoryBudget(size_t bytes) {
+    g_memory.budget = bytes;
+}
+
+size_t GpuMemoryOverBudget() {
+    return g_memory.total > g_memory.budget ? g_memory.total - g_memory.budget : 0;
+}
+
+GpuMemoryStats GetGpuMemoryStats() {
+    return g_memory;
+}
+
+static void AppendJsonString(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+bool WriteGpuMemoryReport(const std::string& path) {
+    std::vector<std::pair<std::pair<int, GLuint>, const GpuResource*>> sorted;
+    for (const auto& resource : g_resources) sorted.push_back({ resource.first, &resource.second });
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.second->bytes > b.second->bytes; });
+
+    std::string json = "{\n";
+    json += "  \"budgetBytes\": " + std::to_string(g_memory.budget) + ",\n";
+    json += "  \"totalBytes\": " + std::to_string(g_memory.total) + ",\n";
+    json += "  \"peakBytes\": " + std::to_string(g_memory.peak) + ",\n";
+    json += "  \"kinds\": {";
+    for (int k = 0; k < KIND_COUNT; ++k) {
+        json += k ? ",\n    " : "\n    ";
+        AppendJsonString(json, GpuMemoryKindName(static_cast<GpuMemoryKind>(k)));
+        json += ": { \"bytes\": " + std::to_string(g_memory.bytes[k]) +
+                ", \"resources\": " + std::to_string(g_memory.resources[k]) + " }";
+    }
+    json += "\n  },\n  \"resources\": [";
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        const GpuResource& resource = *sorted[i].second;
+        json += i ? ",\n    { \"kind\": " : "\n    { \"kind\": ";
+        AppendJsonString(json, GpuMemoryKindName(static_cast<GpuMemoryKind>(sorted[i].first.first)));
+        json += ", \"name\": " + std::to_string(sorted[i].first.second) + ", \"bytes\": " +
+                std::to_string(resource.bytes) + ", \"label\": ";
+        AppendJsonString(json, resource.label);
+        json += ", \"state\": ";
+        AppendJsonString(json, resource.state);
+        json += " }";
+    }
+    json += "\n  ]\n}\n";
+
+    if (!WriteFileAtomic(path, { { json.data(), json.size() } })) {
+        std::cerr << "Failed to write GPU memory report: " << path << std::endl;
+        return false;
+    }
+    std::cout << "GPU memory report written to " << path << std::endl;
+    return true;
+}
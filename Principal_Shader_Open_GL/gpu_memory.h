@@ -0,0 +1,52 @@
+// gpu_memory.h
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ─────────────────────────────────────────────
+// GPU memory accounting
+// ─────
+// Every texture and buffer the tool creates reports its size here, keyed by its
+// GL name, so the totals can be held against a budget (PBR_GPU_MEMORY_MB, 1024 by
+// default, adjustable from the UI). Sizes are what the texels / vertices need;
+// the driver's padding and alignment aren't visible through GL. The texture
+// registry (texture_loader.h) keeps material textures under the budget by
+// evicting idle ones and dropping mip levels of the rest; everything else is
+// only counted. GL thread only.
+enum class GpuMemoryKind : uint8_t {
+    MaterialTexture = 0, // registry-owned 2D maps
+    Environment,         // environment cubemaps and BRDF LUT
+    MeshBuffer,          // vertex and index buffers
+    Count,
+};
+
+const char* GpuMemoryKindName(GpuMemoryKind kind);
+
+// Adds a resource or updates its size / label; `state` is free text for the report ("idle", ...)
+void TrackGpuMemory(GpuMemoryKind kind, GLuint name, size_t bytes, const std::string& label,
+                    const std::string& state = std::string());
+void SetGpuMemoryState(GpuMemoryKind kind, GLuint name, const std::string& state);
+void UntrackGpuMemory(GpuMemoryKind kind, GLuint name);
+
+// Sizes a 2D texture or cubemap from its defined levels (glGetTexLevelParameteriv) and tracks it
+size_t TrackTextureMemory(GpuMemoryKind kind, GLenum target, GLuint texture, const std::string& label);
+// Untracks and deletes a texture tracked that way, and zeroes `texture`
+void DeleteTrackedTexture(GpuMemoryKind kind, GLuint& texture);
+
+size_t GpuMemoryBudget();
+void SetGpuMemoryBudget(size_t bytes);
+size_t GpuMemoryOverBudget(); // bytes above the budget, 0 within it
+
+struct GpuMemoryStats {
+    size_t budget = 0;
+    size_t total = 0;
+    size_t peak = 0;
+    size_t bytes[static_cast<int>(GpuMemoryKind::Count)] = {};
+    size_t resources[static_cast<int>(GpuMemoryKind::Count)] = {};
+};
+GpuMemoryStats GetGpuMemoryStats();
+
+// Budget, totals and every tracked resource (largest first) as JSON
+bool WriteGpuMemoryReport(const std::string& path);
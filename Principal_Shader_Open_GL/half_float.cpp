@@ -0,0 +1,112 @@
+// half_float.cpp
+#include "half_float.h"
+#include "job_system.h"
+#include <cstring>
+
+#if defined(__F16C__) || defined(__AVX2__) // MSVC has no __F16C__; /arch:AVX2 implies it
+#define HALF_F16C 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HALF_SSE2 1
+#include <emmintrin.h>
+#endif
+
+uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) // infinity or NaN (keep NaN a NaN)
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u | (mantissa >> 13) : 0u));
+    int halfExponent = static_cast<int>(exponent) - 127 + 15;
+    if (halfExponent >= 31) return static_cast<uint16_t>(sign | 0x7C00u);
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) return static_cast<uint16_t>(sign); // below the smallest subnormal
+        mantissa |= 0x800000u;
+        const int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) ++half;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) ++half; // may carry into the exponent, which is correct
+    return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value) {
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    uint32_t exponent = (value >> 10) & 0x1Fu;
+    uint32_t mantissa = value & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0x1Fu) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else { // subnormal: normalize
+        exponent = 127 - 15 + 1;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        bits = sign | (exponent << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+#if HALF_SSE2
+// FloatToHalf on four lanes with integer ops: values too small for a normal half are
+// rounded by a float add that lines the mantissa up with the subnormal LSB; normal
+// ones by adding half an LSB (minus one when the kept LSB is even, for ties to even).
+// Returns the halves sign-extended in 32-bit lanes, ready for _mm_packs_epi32.
+static __m128i FloatToHalf4(__m128 value) {
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128 sign = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u))));
+    const __m128 absolute = _mm_xor_ps(value, sign);
+    const __m128i bits = _mm_castps_si128(absolute);
+
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+    const __m128i isFinite = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), bits); // below half overflow
+    const __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+    const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), bits);
+
+    __m128i subnormal = _mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormalMagic)));
+    subnormal = _mm_sub_epi32(subnormal, subnormalMagic);
+    const __m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31); // -1 when the kept LSB is set
+    __m128i normal = _mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(0xFFFu - ((127u - 15u) << 23))));
+    normal = _mm_srli_epi32(_mm_sub_epi32(normal, odd), 13);
+
+    __m128i half = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    half = _mm_or_si128(_mm_and_si128(isFinite, half), _mm_andnot_si128(isFinite, special));
+    return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+#endif
+
+void FloatRowToHalves(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+#if HALF_F16C
+    for (; i + 8 <= count; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#elif HALF_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = FloatToHalf4(_mm_loadu_ps(src + i));
+        __m128i high = FloatToHalf4(_mm_loadu_ps(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; ++i) dst[i] = FloatToHalf(src[i]);
+}
+
+void FloatsToHalves(const float* src, uint16_t* dst, size_t count) {
+    ParallelFor(count, [&](size_t begin, size_t end) {
+        FloatRowToHalves(src + begin, dst + begin, end - begin);
+    }, 0, 1 << 16);
+}
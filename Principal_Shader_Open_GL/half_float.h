@@ -0,0 +1,20 @@
+// half_float.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ─────────────────────────────────────────────
+// Half-precision floats
+// ─────
+// HDR texels are kept as IEEE binary16 on disk (.pbrtex) and uploaded as
+// GL_HALF_FLOAT, which is what GL_RGB16F stores anyway: half the bytes of
+// float data and no conversion in the driver.
+uint16_t FloatToHalf(float value); // round to nearest even; overflow becomes infinity
+float HalfToFloat(uint16_t value);
+
+// Converts `count` floats on the calling thread, 4 or 8 at a time (F16C when the
+// build targets it, an SSE2 emulation otherwise); same rounding as FloatToHalf
+void FloatRowToHalves(const float* src, uint16_t* dst, size_t count);
+
+// The same in parallel, for whole images
+void FloatsToHalves(const float* src, uint16_t* dst, size_t count);
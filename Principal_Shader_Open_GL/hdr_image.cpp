@@ -0,0 +1,214 @@
+// hdr_image.cpp
+#include "hdr_image.h"
+#include "half_float.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HDR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+int DefaultHdrMaxWidth() {
+    static const int maxWidth = [] {
+        const char* env = std::getenv("PBR_HDR_MAX_WIDTH");
+        return env ? std::max(0, std::atoi(env)) : 4096;
+    }();
+    return maxWidth;
+}
+
+// One header line without its newline; false at the end of the data
+static bool ReadLine(const unsigned char* data, size_t size, size_t& pos, std::string& line) {
+    line.clear();
+    while (pos < size && data[pos] != '\n') line += static_cast<char>(data[pos++]);
+    if (pos >= size) return false;
+    ++pos;
+    return true;
+}
+
+// Magic, variables up to the blank line, then the resolution line; `pos` ends at the first scanline
+static bool ParseHeader(const unsigned char* data, size_t size, int& width, int& height, size_t& pos) {
+    std::string line;
+    pos = 0;
+    if (!ReadLine(data, size, pos, line) || (line.compare(0, 10, "#?RADIANCE") != 0 && line.compare(0, 6, "#?RGBE") != 0)) {
+        std::cerr << "Not a Radiance HDR file" << std::endl;
+        return false;
+    }
+    for (;;) {
+        if (!ReadLine(data, size, pos, line)) return false;
+        if (line.empty()) break;
+        if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+            std::cerr << "Unsupported HDR " << line << std::endl;
+            return false;
+        }
+    }
+    if (!ReadLine(data, size, pos, line) || std::sscanf(line.c_str(), "-Y %d +X %d", &height, &width) != 2 ||
+        width <= 0 || height <= 0) {
+        std::cerr << "Unsupported HDR orientation: " << line << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// New-style RLE scanline: 2, 2, width (big-endian), then each component's runs in turn
+static bool IsRunLengthScanline(const unsigned char* p, size_t available, int width) {
+    return width >= 8 && width < 0x8000 && available >= 4 && p[0] == 2 && p[1] == 2 &&
+           ((p[2] << 8) | p[3]) == width;
+}
+
+// Where every scanline starts (RLE scanlines carry no length, so this walks the runs).
+// False on truncated data and on old-style runs (1, 1, 1, count), which need the previous pixel.
+static bool FindScanlines(const unsigned char* data, size_t size, size_t pos, int width, int height,
+                          std::vector<size_t>& starts) {
+    starts.resize(height);
+    for (int y = 0; y < height; ++y) {
+        starts[y] = pos;
+        if (IsRunLengthScanline(data + pos, size - pos, width)) {
+            pos += 4;
+            for (int c = 0; c < 4; ++c) {
+                for (int x = 0; x < width;) {
+                    if (pos >= size) return false;
+                    int count = data[pos];
+                    if (count > 128) {
+                        count -= 128;
+                        pos += 2;
+                    } else {
+                        pos += 1 + count;
+                    }
+                    x += count;
+                    if (count == 0 || x > width) return false;
+                }
+            }
+            if (pos > size) return false;
+        } else {
+            const size_t bytes = static_cast<size_t>(width) * 4;
+            if (bytes > size - pos) return false;
+            for (size_t i = 0; i < bytes; i += 4)
+                if (data[pos + i] == 1 && data[pos + i + 1] == 1 && data[pos + i + 2] == 1) return false;
+            pos += bytes;
+        }
+    }
+    return true;
+}
+
+// Scanline -> planar R, G, B, E bytes (`planes` holds 4 * width)
+static void DecodeScanline(const unsigned char* p, int width, unsigned char* planes) {
+    if (IsRunLengthScanline(p, 4, width)) {
+        p += 4;
+        for (int c = 0; c < 4; ++c) {
+            unsigned char* out = planes + static_cast<size_t>(c) * width;
+            for (int x = 0; x < width;) {
+                int count = *p++;
+                if (count > 128) {
+                    count -= 128;
+                    std::memset(out + x, *p++, count);
+                } else {
+                    std::memcpy(out + x, p, count);
+                    p += count;
+                }
+                x += count;
+            }
+        }
+        return;
+    }
+    for (int x = 0; x < width; ++x)
+        for (int c = 0; c < 4; ++c) planes[static_cast<size_t>(c) * width + x] = p[x * 4 + c];
+}
+
+// Planar RGBE -> planar float R, G, B: mantissa * 2^(E - 136), as stb_image does
+static void RgbeToFloats(const unsigned char* planes, int width, float* rgb) {
+    const unsigned char* exponents = planes + static_cast<size_t>(3) * width;
+    int x = 0;
+#if HDR_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    auto widen = [&](const unsigned char* bytes) {
+        int32_t packed;
+        std::memcpy(&packed, bytes, sizeof(packed));
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    };
+    for (; x + 4 <= width; x += 4) {
+        // The scale's float bits directly; exponents up to 9 (and 0, black) would be
+        // subnormal floats, far below half precision, and become 0
+        const __m128i e = widen(exponents + x);
+        const __m128i normal = _mm_cmpgt_epi32(e, _mm_set1_epi32(9));
+        const __m128 scale = _mm_and_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(e, _mm_set1_epi32(9)), 23)),
+                                        _mm_castsi128_ps(normal));
+        for (int c = 0; c < 3; ++c) {
+            const size_t plane = static_cast<size_t>(c) * width;
+            _mm_storeu_ps(rgb + plane + x, _mm_mul_ps(_mm_cvtepi32_ps(widen(planes + plane + x)), scale));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        const float scale = exponents[x] > 9 ? std::ldexp(1.0f, exponents[x] - 136) : 0.0f;
+        for (int c = 0; c < 3; ++c) {
+            const size_t plane = static_cast<size_t>(c) * width;
+            rgb[plane + x] = planes[plane + x] * scale;
+        }
+    }
+}
+
+bool LoadRadianceHdr(const unsigned char* data, size_t size, int maxWidth, HdrImage& out) {
+    int width = 0, height = 0;
+    size_t pos = 0;
+    std::vector<size_t> starts;
+    if (!ParseHeader(data, size, width, height, pos)) return false;
+    if (!FindScanlines(data, size, pos, width, height, starts)) {
+        std::cerr << "HDR scanlines truncated or old-style run-length encoded" << std::endl;
+        return false;
+    }
+
+    // Power-of-two box filter down to the width limit; partial boxes at the right / bottom edge
+    int shift = 0;
+    while (maxWidth > 0 && ((width + (1 << shift) - 1) >> shift) > maxWidth) ++shift;
+    const int factor = 1 << shift;
+    out.sourceWidth = width;
+    out.sourceHeight = height;
+    out.width = (width + factor - 1) >> shift;
+    out.height = (height + factor - 1) >> shift;
+    out.texels.assign(static_cast<size_t>(out.width) * out.height * 3, 0);
+
+    const size_t outWidth = static_cast<size_t>(out.width);
+    ParallelFor(static_cast<size_t>(out.height), [&](size_t begin, size_t end) {
+        std::vector<unsigned char> planes(static_cast<size_t>(width) * 4);
+        std::vector<float> row(static_cast<size_t>(width) * 3);
+        std::vector<float> sum(factor > 1 ? outWidth * 3 : 0);
+        std::vector<uint16_t> halves(outWidth * 3);
+        for (size_t outY = begin; outY < end; ++outY) {
+            const int y0 = static_cast<int>(outY) << shift;
+            const int rows = std::min(factor, height - y0);
+            std::fill(sum.begin(), sum.end(), 0.0f);
+            for (int y = y0; y < y0 + rows; ++y) {
+                DecodeScanline(data + starts[y], width, planes.data());
+                RgbeToFloats(planes.data(), width, row.data());
+                if (factor == 1) break;
+                for (int c = 0; c < 3; ++c) {
+                    const float* in = row.data() + static_cast<size_t>(c) * width;
+                    float* acc = sum.data() + c * outWidth;
+                    for (int x = 0; x < width; ++x) acc[x >> shift] += in[x];
+                }
+            }
+            if (factor > 1) {
+                for (size_t x = 0; x < outWidth; ++x) {
+                    const int columns = std::min(factor, width - static_cast<int>(x << shift));
+                    const float weight = 1.0f / static_cast<float>(columns * rows);
+                    for (int c = 0; c < 3; ++c) sum[c * outWidth + x] *= weight;
+                }
+            }
+            // Planes to halves, then interleaved into the row's place counted from the bottom
+            const float* source = factor > 1 ? sum.data() : row.data();
+            for (int c = 0; c < 3; ++c)
+                FloatRowToHalves(source + c * outWidth, halves.data() + c * outWidth, outWidth);
+            uint16_t* dst = out.texels.data() + (out.height - 1 - outY) * outWidth * 3;
+            for (size_t x = 0; x < outWidth; ++x)
+                for (int c = 0; c < 3; ++c) dst[x * 3 + c] = halves[c * outWidth + x];
+        }
+    }, 0, 4);
+    return true;
+}
@@ -0,0 +1,30 @@
+// hdr_image.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Radiance (.hdr) reader
+// ─────
+// Decodes RGBE straight to half floats (half_float.h) instead of stbi_loadf's
+// scalar float path, which produced twice the bytes GL_RGB16F keeps. A quick
+// serial pass finds where each scanline starts (RLE scanlines have no length
+// field), then scanlines are run-length decoded and converted in parallel,
+// 4 texels at a time with SSE2. Maps wider than `maxWidth` are box-filtered
+// down by a power of two on the way, so a 16K panorama never exists at full
+// size in memory.
+struct HdrImage {
+    int width = 0;
+    int height = 0;
+    int sourceWidth = 0;
+    int sourceHeight = 0;
+    std::vector<uint16_t> texels; // RGB halves, bottom row first (GL order)
+};
+
+// PBR_HDR_MAX_WIDTH, 4096 by default (plenty for 512^2 cube faces); 0 = no limit
+int DefaultHdrMaxWidth();
+
+// False (with a message) when `data` isn't a Radiance file this reader handles:
+// XYZE data, rotated orientations and old-style run-length scanlines go to stb_image.
+bool LoadRadianceHdr(const unsigned char* data, size_t size, int maxWidth, HdrImage& out);
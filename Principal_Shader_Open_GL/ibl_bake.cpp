@@ -0,0 +1,392 @@
+// ibl_bake.cpp
+#include "ibl_bake.h"
+#include "brdf_lut.h"
+#include "half_float.h"
+#include "job_system.h"
+#include "spherical_harmonics.h"
+#include "texture_mips.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IBL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static const float PI = 3.14159265358979f;
+static const int ROW_BAND = 16;  // rows per resampling job
+static const int TILE_SIZE = 32; // prefilter tiles, texels per side
+
+// ---- RGBA float texels, one SSE register each ----
+#if IBL_SSE2
+typedef __m128 Texel;
+static Texel LoadTexel(const float* p) { return _mm_loadu_ps(p); }
+static Texel MakeTexel(float r, float g, float b) { return _mm_setr_ps(r, g, b, 0.0f); }
+static Texel ZeroTexel() { return _mm_setzero_ps(); }
+static Texel Lerp(Texel a, Texel b, float t) { return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t))); }
+static Texel MulAdd(Texel sum, Texel a, float w) { return _mm_add_ps(sum, _mm_mul_ps(a, _mm_set1_ps(w))); }
+static void StoreTexel(float* p, Texel t) { _mm_storeu_ps(p, t); }
+#else
+struct Texel {
+    float v[4];
+};
+static Texel LoadTexel(const float* p) { return { { p[0], p[1], p[2], p[3] } }; }
+static Texel MakeTexel(float r, float g, float b) { return { { r, g, b, 0.0f } }; }
+static Texel ZeroTexel() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+static Texel Lerp(Texel a, Texel b, float t) {
+    for (int i = 0; i < 4; ++i) a.v[i] += (b.v[i] - a.v[i]) * t;
+    return a;
+}
+static Texel MulAdd(Texel sum, Texel a, float w) {
+    for (int i = 0; i < 4; ++i) sum.v[i] += a.v[i] * w;
+    return sum;
+}
+static void StoreTexel(float* p, Texel t) {
+    for (int i = 0; i < 4; ++i) p[i] = t.v[i];
+}
+#endif
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Every half's float value: each resampled texel converts twelve of them
+static const float* HalfTable() {
+    static const std::vector<float> table = [] {
+        std::vector<float> values(65536);
+        for (uint32_t i = 0; i < 65536; ++i) values[i] = HalfToFloat(static_cast<uint16_t>(i));
+        return values;
+    }();
+    return table.data();
+}
+
+// ---- Equirectangular -> cubemap ----
+static Texel HdrTexel(const HdrImage& hdr, const float* halves, int x, int y) {
+    const uint16_t* p = hdr.texels.data() + (static_cast<size_t>(y) * hdr.width + x) * 3;
+    return MakeTexel(halves[p[0]], halves[p[1]], halves[p[2]]);
+}
+
+// GL_LINEAR with GL_CLAMP_TO_EDGE, as the GL bake samples the equirectangular texture
+static Texel SampleEquirect(const HdrImage& hdr, const float* halves, float u, float v) {
+    const float x = u * hdr.width - 0.5f, y = v * hdr.height - 0.5f;
+    const float x0 = std::floor(x), y0 = std::floor(y);
+    const int xa = std::clamp(static_cast<int>(x0), 0, hdr.width - 1), xb = std::min(xa + 1, hdr.width - 1);
+    const int ya = std::clamp(static_cast<int>(y0), 0, hdr.height - 1), yb = std::min(ya + 1, hdr.height - 1);
+    const Texel bottom = Lerp(HdrTexel(hdr, halves, xa, ya), HdrTexel(hdr, halves, xb, ya), x - x0);
+    const Texel top = Lerp(HdrTexel(hdr, halves, xa, yb), HdrTexel(hdr, halves, xb, yb), x - x0);
+    return Lerp(bottom, top, y - y0);
+}
+
+// equirect_to_cubemap.frag: six `size`^2 RGBA float faces back to back, in parallel over row bands
+static void ResampleToCube(const HdrImage& hdr, int size, std::vector<float>& faces) {
+    faces.assign(static_cast<size_t>(size) * size * 4 * 6, 0.0f);
+    const float* halves = HalfTable();
+    const int bands = (size + ROW_BAND - 1) / ROW_BAND;
+    const float texel = 2.0f / static_cast<float>(size);
+    ParallelFor(static_cast<size_t>(bands) * 6, [&](size_t begin, size_t end) {
+        for (size_t job = begin; job < end; ++job) {
+            const int face = static_cast<int>(job / bands);
+            const int rowBegin = static_cast<int>(job % bands) * ROW_BAND;
+            const int rowEnd = std::min(rowBegin + ROW_BAND, size);
+            for (int row = rowBegin; row < rowEnd; ++row) {
+                const float tc = (row + 0.5f) * texel - 1.0f;
+                float* out = faces.data() + (static_cast<size_t>(face) * size + row) * size * 4;
+                for (int column = 0; column < size; ++column, out += 4) {
+                    float x, y, z;
+                    CubeFaceDirection(face, (column + 0.5f) * texel - 1.0f, tc, x, y, z);
+                    const float inverseLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+                    const float theta = std::acos(std::clamp(y * inverseLength, -1.0f, 1.0f)); // from +Y
+                    float u = std::atan2(z, x) / (2.0f * PI) + 0.5f;
+                    u -= std::floor(u);
+                    StoreTexel(out, SampleEquirect(hdr, halves, u, theta / PI));
+                }
+            }
+        }
+    });
+}
+
+// ---- Cubemap lookups ----
+// Face and [0, 1] face coordinates of a direction, the inverse of CubeFaceDirection
+static void CubeFaceCoordinates(float x, float y, float z, int& face, float& s, float& t) {
+    const float ax = std::fabs(x), ay = std::fabs(y), az = std::fabs(z);
+    float sc, tc, major;
+    if (ax >= ay && ax >= az) {
+        face = x >= 0.0f ? 0 : 1;
+        sc = x >= 0.0f ? -z : z;
+        tc = -y;
+        major = ax;
+    } else if (ay >= az) {
+        face = y >= 0.0f ? 2 : 3;
+        sc = x;
+        tc = y >= 0.0f ? z : -z;
+        major = ay;
+    } else {
+        face = z >= 0.0f ? 4 : 5;
+        sc = z >= 0.0f ? x : -x;
+        tc = -y;
+        major = az;
+    }
+    s = 0.5f * (sc / major + 1.0f);
+    t = 0.5f * (tc / major + 1.0f);
+}
+
+// Bilinear within one face of one level, clamped at its edges
+static Texel SampleFace(const HdrMipChain& chain, int level, int face, float s, float t) {
+    const int size = std::max(chain.width >> level, 1);
+    const float* texels = chain.data.data() + chain.levelOffsets[level] + face * chain.faceSizes[level];
+    const float x = s * size - 0.5f, y = t * size - 0.5f;
+    const float x0 = std::floor(x), y0 = std::floor(y);
+    const int xa = std::clamp(static_cast<int>(x0), 0, size - 1), xb = std::min(xa + 1, size - 1);
+    const int ya = std::clamp(static_cast<int>(y0), 0, size - 1), yb = std::min(ya + 1, size - 1);
+    const float* rowA = texels + static_cast<size_t>(ya) * size * 4;
+    const float* rowB = texels + static_cast<size_t>(yb) * size * 4;
+    const Texel bottom = Lerp(LoadTexel(rowA + xa * 4), LoadTexel(rowA + xb * 4), x - x0);
+    const Texel top = Lerp(LoadTexel(rowB + xa * 4), LoadTexel(rowB + xb * 4), x - x0);
+    return Lerp(bottom, top, y - y0);
+}
+
+// textureLod on the mipmapped environment: trilinear, the lod clamped to the chain
+static Texel SampleCubeLod(const HdrMipChain& chain, float x, float y, float z, float lod) {
+    int face;
+    float s, t;
+    CubeFaceCoordinates(x, y, z, face, s, t);
+    const int maxLevel = static_cast<int>(chain.levelOffsets.size()) - 1;
+    lod = std::clamp(lod, 0.0f, static_cast<float>(maxLevel));
+    const int level = static_cast<int>(lod);
+    const Texel fine = SampleFace(chain, level, face, s, t);
+    if (level >= maxLevel || lod == static_cast<float>(level)) return fine;
+    return Lerp(fine, SampleFace(chain, level + 1, face, s, t), lod - static_cast<float>(level));
+}
+
+// ---- GGX prefilter ----
+// One sample of prefilter_ggx.frag in the texel's tangent frame (N = +Z): the reflected
+// direction L = 2 (N.H) H - N, its N.L weight and the environment lod it reads
+struct GgxSample {
+    float x, y, z;
+    float weight;
+    float lod;
+};
+
+struct PrefilterLevel {
+    int size = 0;
+    size_t offset = 0;          // into IblBake::prefiltered, in halves
+    float inverseWeight = 0.0f; // 1 / the samples' total N.L
+    std::vector<GgxSample> samples;
+};
+
+struct PrefilterTile {
+    int level, face, x, y;
+    size_t cost; // texels * samples
+};
+
+// The same samples and lods as the shader, which only depend on the level
+static void PrepareGgxSamples(float roughness, int sampleCount, float environmentSize, float minLod,
+                              PrefilterLevel& level) {
+    const float alpha = roughness * roughness, alpha2 = alpha * alpha;
+    const float texelSolidAngle = 4.0f * PI / (6.0f * environmentSize * environmentSize);
+    float totalWeight = 0.0f;
+    level.samples.clear();
+    for (int i = 0; i < sampleCount; ++i) {
+        float u, v;
+        Hammersley(static_cast<uint32_t>(i), static_cast<uint32_t>(sampleCount), u, v);
+        const float phi = 2.0f * PI * u;
+        const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha2 - 1.0f) * v));
+        const float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+        const float NdotL = 2.0f * cosTheta * cosTheta - 1.0f;
+        if (NdotL <= 0.0f) continue;
+
+        float lod = minLod;
+        if (alpha > 0.0f) { // roughness 0 is a mirror: one sample, a delta pdf
+            const float denom = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+            const float pdf = alpha2 / (PI * denom * denom) * 0.25f;
+            const float sampleSolidAngle = 1.0f / (static_cast<float>(sampleCount) * pdf + 0.0001f);
+            lod = std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, minLod);
+        }
+        const float reflect = 2.0f * cosTheta * sinTheta;
+        level.samples.push_back({ reflect * std::cos(phi), reflect * std::sin(phi), NdotL, NdotL, lod });
+        totalWeight += NdotL;
+    }
+    level.inverseWeight = 1.0f / std::max(totalWeight, 0.0001f);
+}
+
+static void PrefilterTileTexels(const HdrMipChain& environment, const PrefilterLevel& level,
+                                const PrefilterTile& tile, uint16_t* prefiltered) {
+    const int size = level.size;
+    const int width = std::min(TILE_SIZE, size - tile.x), height = std::min(TILE_SIZE, size - tile.y);
+    const float texel = 2.0f / static_cast<float>(size);
+    float row[TILE_SIZE * 3];
+    for (int y = tile.y; y < tile.y + height; ++y) {
+        const float tc = (y + 0.5f) * texel - 1.0f;
+        for (int x = tile.x; x < tile.x + width; ++x) {
+            float nx, ny, nz;
+            CubeFaceDirection(tile.face, (x + 0.5f) * texel - 1.0f, tc, nx, ny, nz);
+            const float inverseLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz);
+            nx *= inverseLength;
+            ny *= inverseLength;
+            nz *= inverseLength;
+            // tangent = normalize(cross(up, N)), bitangent = cross(N, tangent)
+            float tx, ty, tz;
+            if (std::fabs(nz) < 0.999f) {
+                tx = -ny;
+                ty = nx;
+                tz = 0.0f;
+            } else {
+                tx = 0.0f;
+                ty = -nz;
+                tz = ny;
+            }
+            const float inverseTangent = 1.0f / std::sqrt(tx * tx + ty * ty + tz * tz);
+            tx *= inverseTangent;
+            ty *= inverseTangent;
+            tz *= inverseTangent;
+            const float bx = ny * tz - nz * ty, by = nz * tx - nx * tz, bz = nx * ty - ny * tx;
+
+            Texel sum = ZeroTexel();
+            for (const GgxSample& sample : level.samples) {
+                const float lx = tx * sample.x + bx * sample.y + nx * sample.z;
+                const float ly = ty * sample.x + by * sample.y + ny * sample.z;
+                const float lz = tz * sample.x + bz * sample.y + nz * sample.z;
+                sum = MulAdd(sum, SampleCubeLod(environment, lx, ly, lz, sample.lod), sample.weight);
+            }
+            float rgba[4];
+            StoreTexel(rgba, sum);
+            for (int c = 0; c < 3; ++c) row[(x - tile.x) * 3 + c] = rgba[c] * level.inverseWeight;
+        }
+        const size_t first = level.offset + ((static_cast<size_t>(tile.face) * size + y) * size + tile.x) * 3;
+        FloatRowToHalves(row, prefiltered + first, static_cast<size_t>(width) * 3);
+    }
+}
+
+// PrefilterEnvironment (texture_utils.h) on the CPU: every level's faces in TILE_SIZE
+// tiles, handed out most expensive first to whichever thread is free
+static void PrefilterCube(const HdrMipChain& environment, int size, int levelCount, IblBake& out) {
+    const int environmentMaxLevel = static_cast<int>(environment.levelOffsets.size()) - 1;
+    std::vector<PrefilterLevel> levels(levelCount);
+    std::vector<PrefilterTile> tiles;
+    size_t halves = 0;
+    for (int l = 0; l < levelCount; ++l) {
+        PrefilterLevel& level = levels[l];
+        level.size = std::max(size >> l, 1);
+        level.offset = halves;
+        halves += static_cast<size_t>(level.size) * level.size * 3 * 6;
+        const float minLod = std::log2(static_cast<float>(environment.width) / static_cast<float>(level.size));
+        PrepareGgxSamples(levelCount > 1 ? static_cast<float>(l) / (levelCount - 1) : 0.0f, PREFILTER_SAMPLE_COUNTS[l],
+                          static_cast<float>(environment.width),
+                          std::clamp(minLod, 0.0f, static_cast<float>(environmentMaxLevel)), level);
+        for (int face = 0; face < 6; ++face)
+            for (int y = 0; y < level.size; y += TILE_SIZE)
+                for (int x = 0; x < level.size; x += TILE_SIZE) {
+                    const size_t texels = static_cast<size_t>(std::min(TILE_SIZE, level.size - x)) *
+                                          std::min(TILE_SIZE, level.size - y);
+                    tiles.push_back({ l, face, x, y, texels * std::max<size_t>(level.samples.size(), 1) });
+                }
+    }
+    std::stable_sort(tiles.begin(), tiles.end(),
+                     [](const PrefilterTile& a, const PrefilterTile& b) { return a.cost > b.cost; });
+
+    out.prefiltered.assign(halves, 0);
+    std::atomic<size_t> next(0);
+    ParallelFor(WorkerCount(), [&](size_t, size_t) {
+        for (size_t i = next.fetch_add(1); i < tiles.size(); i = next.fetch_add(1))
+            PrefilterTileTexels(environment, levels[tiles[i].level], tiles[i], out.prefiltered.data());
+    });
+
+    TextureCacheInfo& info = out.data.texture(IblTexture::Prefiltered);
+    info.format = TexelFormat::RGB16F;
+    info.width = info.height = size;
+    info.faces = 6;
+    info.levels.clear();
+    for (const PrefilterLevel& level : levels) {
+        const size_t faceHalves = static_cast<size_t>(level.size) * level.size * 3;
+        for (int face = 0; face < 6; ++face)
+            info.levels.push_back({ reinterpret_cast<const unsigned char*>(out.prefiltered.data() + level.offset +
+                                                                           face * faceHalves),
+                                    faceHalves * sizeof(uint16_t) });
+    }
+}
+
+// Drops alpha and converts to the RGB halves GL_RGB16F (and the cache) keeps
+static void RgbaToRgbHalves(const float* rgba, size_t texels, uint16_t* rgb) {
+    ParallelFor(texels, [&](size_t begin, size_t end) {
+        const size_t CHUNK = 256;
+        float row[CHUNK * 3];
+        for (size_t i = begin; i < end; i += CHUNK) {
+            const size_t count = std::min(CHUNK, end - i);
+            for (size_t k = 0; k < count; ++k)
+                for (int c = 0; c < 3; ++c) row[k * 3 + c] = rgba[(i + k) * 4 + c];
+            FloatRowToHalves(row, rgb + i * 3, count * 3);
+        }
+    }, 0, 1 << 14);
+}
+
+bool BakeIblEnvironment(const HdrImage& hdr, const std::vector<uint16_t>& brdfLut, IblBake& out,
+                        IblBakeStats* stats) {
+    if (hdr.width <= 0 || hdr.height <= 0 ||
+        hdr.texels.size() != static_cast<size_t>(hdr.width) * hdr.height * 3 ||
+        brdfLut.size() != static_cast<size_t>(BRDF_LUT_SIZE) * BRDF_LUT_SIZE * 2)
+        return false;
+    IblBakeStats local;
+    IblBakeStats& timings = stats ? *stats : local;
+
+    // Environment cubemap, RGBA so every lookup below is one vector load
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<float> faces;
+    ResampleToCube(hdr, ENVIRONMENT_SIZE, faces);
+    timings.cubemapMs = MillisecondsSince(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    const float* facePointers[6];
+    for (int i = 0; i < 6; ++i) facePointers[i] = faces.data() + static_cast<size_t>(ENVIRONMENT_SIZE) * ENVIRONMENT_SIZE * 4 * i;
+    MipOptions options;
+    options.filter = ENVIRONMENT_MIP_FILTER;
+    options.wrap = false;
+    HdrMipChain environment;
+    if (!GenerateHdrMipChain(facePointers, 6, ENVIRONMENT_SIZE, ENVIRONMENT_SIZE, 4, options, environment)) return false;
+    std::vector<float>().swap(faces);
+
+    const size_t environmentTexels = environment.data.size() / 4;
+    out.environment.assign(environmentTexels * 3, 0);
+    RgbaToRgbHalves(environment.data.data(), environmentTexels, out.environment.data());
+    TextureCacheInfo& environmentInfo = out.data.texture(IblTexture::Environment);
+    environmentInfo.format = TexelFormat::RGB16F;
+    environmentInfo.width = environmentInfo.height = ENVIRONMENT_SIZE;
+    environmentInfo.faces = 6;
+    environmentInfo.levels.clear();
+    for (size_t level = 0; level < environment.levelOffsets.size(); ++level)
+        for (int face = 0; face < 6; ++face) {
+            const size_t texel = (environment.levelOffsets[level] + face * environment.faceSizes[level]) / 4;
+            environmentInfo.levels.push_back({ reinterpret_cast<const unsigned char*>(out.environment.data() + texel * 3),
+                                               environment.faceSizes[level] / 4 * 3 * sizeof(uint16_t) });
+        }
+    timings.mipsMs = MillisecondsSince(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    const int levelCount = std::max(1, std::min({ PREFILTER_LEVELS, MipLevelCount(PREFILTER_SIZE, PREFILTER_SIZE),
+                                                  PREFILTER_MAX_LEVELS }));
+    PrefilterCube(environment, PREFILTER_SIZE, levelCount, out);
+    timings.prefilterMs = MillisecondsSince(t0);
+
+    // Irradiance from the first mip at or below IRRADIANCE_SH_FACE_SIZE, as ComputeIrradianceSH
+    t0 = std::chrono::steady_clock::now();
+    const int maxLevel = static_cast<int>(environment.levelOffsets.size()) - 1;
+    int level = 0;
+    while (level < maxLevel && (ENVIRONMENT_SIZE >> level) > IRRADIANCE_SH_FACE_SIZE) ++level;
+    const int levelSize = std::max(ENVIRONMENT_SIZE >> level, 1);
+    const size_t faceTexels = static_cast<size_t>(levelSize) * levelSize;
+    std::vector<float> shFaces(faceTexels * 3 * 6);
+    const float* levelTexels = environment.data.data() + environment.levelOffsets[level];
+    for (size_t i = 0; i < faceTexels * 6; ++i)
+        for (int c = 0; c < 3; ++c) shFaces[i * 3 + c] = levelTexels[i * 4 + c];
+    for (int i = 0; i < 6; ++i) facePointers[i] = shFaces.data() + faceTexels * 3 * i;
+    out.data.irradiance = ProjectIrradianceSH(facePointers, levelSize);
+    timings.irradianceMs = MillisecondsSince(t0);
+
+    TextureCacheInfo& lutInfo = out.data.texture(IblTexture::BrdfLut);
+    lutInfo.format = TexelFormat::RG16F;
+    lutInfo.width = lutInfo.height = BRDF_LUT_SIZE;
+    lutInfo.faces = 1;
+    lutInfo.levels.assign(1, { reinterpret_cast<const unsigned char*>(brdfLut.data()), brdfLut.size() * sizeof(uint16_t) });
+    return true;
+}
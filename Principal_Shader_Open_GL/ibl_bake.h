@@ -0,0 +1,40 @@
+// ibl_bake.h
+#pragma once
+#include "hdr_image.h"
+#include "ibl_cache.h"
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// CPU IBL bake
+// ─────
+// The products of the viewer's GL bake (LoadEnvironment in texture_utils.h), with
+// the same parameters and IblBakeKey, computed without a GL context so .pbribl
+// caches can be filled on GPU-less machines (tools/ibl_baker.cpp): the
+// equirectangular map resampled into the environment cubemap, its box-filtered
+// mips (texture_mips.h), the GGX prefilter with filtered importance sampling (as
+// prefilter_ggx.frag) and the SH projection. Texels are filtered as RGBA float
+// vectors (SSE2 when available). The prefilter cuts every level's faces into
+// tiles that the job system's threads pull from a shared counter, most expensive
+// first, so the rough levels with many samples don't leave threads idle. Cube
+// lookups clamp at face edges where the GPU's seamless filtering blends across;
+// otherwise the results match the GL bake to half-float precision.
+struct IblBakeStats {
+    double cubemapMs = 0.0;
+    double mipsMs = 0.0;
+    double prefilterMs = 0.0;
+    double irradianceMs = 0.0;
+};
+
+// Owns the texels `data` points into (all but the BRDF LUT's)
+struct IblBake {
+    IblCacheData data;
+    std::vector<uint16_t> environment; // RGB halves, level-major, faces back to back
+    std::vector<uint16_t> prefiltered;
+};
+
+// Bakes everything from a decoded HDR. The BrdfLut texture points at `brdfLut`
+// (ComputeBrdfLut at BRDF_LUT_SIZE / BRDF_LUT_SAMPLES, the same for a whole batch),
+// which must outlive `out`. data.contentHash is left to the caller.
+bool BakeIblEnvironment(const HdrImage& hdr, const std::vector<uint16_t>& brdfLut, IblBake& out,
+                        IblBakeStats* stats = nullptr);
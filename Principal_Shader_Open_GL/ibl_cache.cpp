@@ -0,0 +1,202 @@
+// ibl_cache.cpp
+#include "ibl_cache.h"
+#include "brdf_lut.h"
+#include "hdr_image.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// Bump whenever the file layout or a bake's output changes
+static const uint32_t IBL_CACHE_VERSION = 1;
+static const char IBL_CACHE_MAGIC[8] = { 'P', 'B', 'R', 'I', 'B', 'L', '\0', '\0' };
+static const uint32_t IBL_CACHE_MAX_LEVELS = 16;
+
+struct IblCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t textureCount;  // IBL_TEXTURE_COUNT
+    uint64_t bakeKey;       // hash of the bake parameters
+    uint64_t sourceSize;    // the HDR's identity, as in .pbrtex caches
+    int64_t  sourceMTime;
+    uint64_t sourceHash;    // HashFileSampled
+    uint64_t contentHash;   // HashBytes of the whole HDR
+    float irradiance[SH_COEFFICIENT_COUNT][3];
+    uint32_t reserved;
+    // followed by textureCount IblCacheTexture entries, then one region per (texture, level,
+    // face) in that order, level-major within a texture, then the texels
+};
+
+struct IblCacheTexture {
+    uint32_t format; // TexelFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t reserved;
+};
+
+struct IblCacheRegion {
+    uint64_t offset; // from the start of the file, 16-byte aligned
+    uint64_t size;
+};
+
+static bool StatSource(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Whole-file hash of the HDR, for when its size or time changed but maybe not its contents
+static uint64_t HashSource(const std::string& path) {
+    MappedFile source;
+    return source.open(path) ? HashBytes(source.data(), source.size()) : 0;
+}
+
+uint64_t IblBakeKey() {
+    // Everything that changes a bake's output; shader changes bump IBL_CACHE_VERSION instead
+    const int params[] = { ENVIRONMENT_SIZE, PREFILTER_SIZE, PREFILTER_LEVELS, IRRADIANCE_SH_FACE_SIZE,
+                           BRDF_LUT_SIZE, BRDF_LUT_SAMPLES, DefaultHdrMaxWidth(),
+                           static_cast<int>(ENVIRONMENT_MIP_FILTER) };
+    uint64_t key = HashBytes(params, sizeof(params));
+    return HashBytes(PREFILTER_SAMPLE_COUNTS, sizeof(PREFILTER_SAMPLE_COUNTS), key);
+}
+
+std::string IblCachePath(const std::string& hdrPath) {
+    return std::filesystem::path(hdrPath).replace_extension(".pbribl").string();
+}
+
+bool OpenIblCache(const std::string& hdrPath, uint64_t bakeKey, MappedFile& file, IblCacheData& data) {
+    const std::string path = IblCachePath(hdrPath);
+    std::error_code ec;
+    uint64_t sourceSize;
+    int64_t sourceMTime;
+    if (!std::filesystem::exists(path, ec) || !StatSource(hdrPath, sourceSize, sourceMTime)) return false;
+    if (!file.open(path)) {
+        std::cerr << "Cannot map IBL cache: " << path << std::endl;
+        return false;
+    }
+    IblCacheHeader header;
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, IBL_CACHE_MAGIC, sizeof(IBL_CACHE_MAGIC)) != 0 ||
+        header.version != IBL_CACHE_VERSION || header.bakeKey != bakeKey) {
+        std::cout << "IBL cache out of date (version or bake parameters), rebaking: " << path << std::endl;
+        return false;
+    }
+    const uint64_t sourceHash = HashFileSampled(hdrPath);
+    if (header.sourceSize != sourceSize || header.sourceMTime != sourceMTime || header.sourceHash != sourceHash) {
+        if (header.contentHash != HashSource(hdrPath)) {
+            std::cout << "IBL cache out of date (HDR changed), rebaking: " << path << std::endl;
+            return false;
+        }
+        // Same contents (a copied or touched HDR): stamp its new identity into the header so
+        // the next launch passes the quick check instead of hashing the whole file again.
+        // Best effort, e.g. a read-only directory or another process mapping the cache just
+        // means paying the full hash again next time.
+        header.sourceSize = sourceSize;
+        header.sourceMTime = sourceMTime;
+        header.sourceHash = sourceHash;
+        file.close();
+        if (!PatchFile(path, 0, &header, sizeof(header)))
+            std::cout << "Cannot refresh IBL cache header (read-only?): " << path << std::endl;
+        if (!file.open(path) || file.size() < sizeof(header)) {
+            std::cerr << "Cannot map IBL cache: " << path << std::endl;
+            return false;
+        }
+    }
+
+    bool valid = header.textureCount == IBL_TEXTURE_COUNT &&
+                 sizeof(header) + IBL_TEXTURE_COUNT * sizeof(IblCacheTexture) <= file.size();
+    size_t regionOffset = sizeof(header) + IBL_TEXTURE_COUNT * sizeof(IblCacheTexture);
+    for (int t = 0; valid && t < IBL_TEXTURE_COUNT; ++t) {
+        IblCacheTexture entry;
+        std::memcpy(&entry, file.data() + sizeof(header) + t * sizeof(entry), sizeof(entry));
+        TextureCacheInfo& info = data.textures[t];
+        info.format = static_cast<TexelFormat>(entry.format);
+        info.width = static_cast<int>(entry.width);
+        info.height = static_cast<int>(entry.height);
+        info.faces = static_cast<int>(entry.faceCount);
+        info.contentHash = header.contentHash;
+        info.levels.clear();
+        const size_t regionCount = static_cast<size_t>(entry.levelCount) * entry.faceCount;
+        valid = TexelChannels(info.format) != 0 && entry.levelCount >= 1 && entry.levelCount <= IBL_CACHE_MAX_LEVELS &&
+                (entry.faceCount == 1 || entry.faceCount == 6) && entry.width > 0 && entry.height > 0 &&
+                regionOffset + regionCount * sizeof(IblCacheRegion) <= file.size();
+        for (size_t i = 0; valid && i < regionCount; ++i) {
+            IblCacheRegion region;
+            std::memcpy(&region, file.data() + regionOffset + i * sizeof(region), sizeof(region));
+            int level = static_cast<int>(i / entry.faceCount);
+            int w = std::max(info.width >> level, 1), h = std::max(info.height >> level, 1);
+            valid = region.size == TexelLevelSize(info.format, w, h) && region.offset + region.size <= file.size();
+            info.levels.push_back({ file.data() + region.offset, static_cast<size_t>(region.size) });
+        }
+        regionOffset += regionCount * sizeof(IblCacheRegion);
+    }
+    if (!valid) {
+        std::cerr << "IBL cache truncated: " << path << std::endl;
+        return false;
+    }
+    std::memcpy(data.irradiance.coefficients, header.irradiance, sizeof(header.irradiance));
+    data.contentHash = header.contentHash;
+    return true;
+}
+
+bool WriteIblCache(const std::string& hdrPath, uint64_t bakeKey, const IblCacheData& data) {
+    IblCacheHeader header = {};
+    std::memcpy(header.magic, IBL_CACHE_MAGIC, sizeof(IBL_CACHE_MAGIC));
+    header.version = IBL_CACHE_VERSION;
+    header.textureCount = IBL_TEXTURE_COUNT;
+    header.bakeKey = bakeKey;
+    if (!StatSource(hdrPath, header.sourceSize, header.sourceMTime)) return false;
+    header.sourceHash = HashFileSampled(hdrPath);
+    header.contentHash = data.contentHash;
+    std::memcpy(header.irradiance, data.irradiance.coefficients, sizeof(header.irradiance));
+
+    IblCacheTexture entries[IBL_TEXTURE_COUNT] = {};
+    size_t regionCount = 0;
+    for (int t = 0; t < IBL_TEXTURE_COUNT; ++t) {
+        const TextureCacheInfo& info = data.textures[t];
+        const int levelCount = info.levelCount();
+        if (levelCount < 1 || levelCount > static_cast<int>(IBL_CACHE_MAX_LEVELS) ||
+            (info.faces != 1 && info.faces != 6) || info.levels.size() != static_cast<size_t>(levelCount * info.faces))
+            return false;
+        entries[t] = { static_cast<uint32_t>(info.format), static_cast<uint32_t>(info.width),
+                       static_cast<uint32_t>(info.height), static_cast<uint32_t>(info.faces),
+                       static_cast<uint32_t>(levelCount), 0 };
+        regionCount += info.levels.size();
+    }
+
+    static const unsigned char zeros[16] = {};
+    std::vector<IblCacheRegion> regions;
+    regions.reserve(regionCount);
+    std::vector<FileChunk> chunks;
+    chunks.push_back({ &header, sizeof(header) });
+    chunks.push_back({ entries, sizeof(entries) });
+    chunks.push_back({ nullptr, regionCount * sizeof(IblCacheRegion) }); // filled in below
+    uint64_t offset = sizeof(header) + sizeof(entries) + regionCount * sizeof(IblCacheRegion);
+    for (const TextureCacheInfo& info : data.textures) {
+        for (const TextureCacheLevel& level : info.levels) {
+            uint64_t aligned = AlignUp(offset, 16);
+            if (aligned != offset) chunks.push_back({ zeros, static_cast<size_t>(aligned - offset) });
+            regions.push_back({ aligned, level.size });
+            chunks.push_back({ level.data, level.size });
+            offset = aligned + level.size;
+        }
+    }
+    chunks[2].data = regions.data();
+
+    const std::string path = IblCachePath(hdrPath);
+    if (!WriteFileAtomic(path, chunks)) {
+        std::cerr << "Failed to write IBL cache: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+// ibl_cache.h
+#pragma once
+#include "file_utils.h"
+#include "spherical_harmonics.h"
+#include "texture_cache.h"
+#include "texture_mips.h"
+#include <cstdint>
+#include <string>
+
+// ─────────────────────────────────────────────
+// Baked IBL cache (.pbribl)
+// ─────
+// Everything derived from an HDR environment (the mipmapped environment cubemap,
+// the GGX-prefiltered cubemap, the BRDF LUT and the irradiance SH) in one file
+// next to it ("sky.hdr" -> "sky.pbribl"), so a second launch maps it and uploads
+// the textures straight from the mapping without any bake pass. Textures use the
+// .pbrtex region layout (texture_cache.h). The file is keyed by the HDR's content
+// hash and a hash of every bake parameter (`bakeKey`): a quick stat / sampled hash
+// check accepts it, and when that fails (a copied or touched file) the full
+// content hash still can. Bump IBL_CACHE_VERSION when a bake shader changes.
+// Bake parameters, shared by the viewer's GL bake (LoadEnvironment in texture_utils.h)
+// and the CPU baker (ibl_bake.h), so either one's cache serves the other
+const int ENVIRONMENT_SIZE = 512; // environment cubemap faces
+// Box rather than Kaiser for the environment mips: the sinc lobes ring around the sun
+// and other tiny, very bright sources, which shows up as halos in the blurred levels
+const MipFilter ENVIRONMENT_MIP_FILTER = MipFilter::Box;
+const int PREFILTER_SIZE = 256;
+const int PREFILTER_LEVELS = 6;
+// GGX samples per prefiltered mip. Level 0 is the mirror; the environment mip each sample
+// reads (filtered importance sampling) keeps the rougher levels smooth with few samples.
+const int PREFILTER_SAMPLE_COUNTS[] = { 1, 32, 48, 64, 64, 64, 64, 64 };
+const int PREFILTER_MAX_LEVELS = static_cast<int>(sizeof(PREFILTER_SAMPLE_COUNTS) / sizeof(int));
+// The environment mip the irradiance SH is projected from: the first at or below this
+const int IRRADIANCE_SH_FACE_SIZE = 64;
+
+// Hash of the bake parameters above (and the BRDF LUT's and HDR decode's) the cache is keyed by
+uint64_t IblBakeKey();
+
+enum class IblTexture : int {
+    Environment = 0, // RGB16F cubemap, full mip chain
+    Prefiltered,     // RGB16F cubemap, one GGX roughness per mip
+    BrdfLut,         // RG16F 2D
+    Count,
+};
+const int IBL_TEXTURE_COUNT = static_cast<int>(IblTexture::Count);
+
+struct IblCacheData {
+    TextureCacheInfo textures[IBL_TEXTURE_COUNT]; // levels point into the mapping (or the writer's buffers)
+    IrradianceSH irradiance;
+    uint64_t contentHash = 0; // HashBytes of the whole HDR file
+
+    TextureCacheInfo& texture(IblTexture which) { return textures[static_cast<int>(which)]; }
+    const TextureCacheInfo& texture(IblTexture which) const { return textures[static_cast<int>(which)]; }
+};
+
+std::string IblCachePath(const std::string& hdrPath);
+
+// False when missing, from another version or bake, or made from different HDR contents
+bool OpenIblCache(const std::string& hdrPath, uint64_t bakeKey, MappedFile& file, IblCacheData& data);
+bool WriteIblCache(const std::string& hdrPath, uint64_t bakeKey, const IblCacheData& data);
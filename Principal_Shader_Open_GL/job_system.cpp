@@ -0,0 +1,174 @@
+// job_system.cpp
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobPool {
+public:
+    JobPool() {
+        unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+        if (const char* env = std::getenv("PBR_WORKER_THREADS")) // override for benchmarking
+            hw = std::max(1, std::atoi(env));
+        for (unsigned i = 0; i + 1 < hw; ++i)
+            workers_.emplace_back([this] { workerLoop(); });
+    }
+
+    ~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& t : workers_) t.join();
+    }
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    // Background jobs (RunAsync) go to their own queue: a thread helping out in
+    // ParallelFor must never pick up a multi-second load or LOD build.
+    void push(std::function<void()> job, bool background = false) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            (background ? backgroundJobs_ : jobs_).push_back(std::move(job));
+        }
+        wake_.notify_one();
+    }
+
+    // Runs one queued ParallelFor range on the calling thread; false if there was none
+    bool runOne() {
+        std::function<void()> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (jobs_.empty()) return false;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+        return true;
+    }
+
+private:
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stopping_ || !jobs_.empty() || !backgroundJobs_.empty(); });
+                if (stopping_ && jobs_.empty() && backgroundJobs_.empty()) return;
+                // ParallelFor ranges first, someone is waiting on them
+                std::deque<std::function<void()>>& queue = jobs_.empty() ? backgroundJobs_ : jobs_;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> jobs_;
+    std::deque<std::function<void()>> backgroundJobs_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
+
+static JobPool& Pool() {
+    static JobPool pool;
+    return pool;
+}
+
+unsigned WorkerCount() {
+    return Pool().threadCount();
+}
+
+void ParallelFor(size_t count, const std::function<void(size_t, size_t)>& fn, unsigned maxThreads, size_t minRange) {
+    if (count == 0) return;
+
+    JobPool& pool = Pool();
+    size_t threads = pool.threadCount();
+    if (maxThreads > 0) threads = std::min<size_t>(threads, maxThreads);
+    threads = std::min(threads, (count + std::max<size_t>(minRange, 1) - 1) / std::max<size_t>(minRange, 1));
+
+    if (threads <= 1) {
+        fn(0, count);
+        return;
+    }
+
+    // Contiguous ranges, one per thread; the caller takes the first one. `remaining` is only
+    // touched under `doneMutex`, and the caller takes it before returning, so no worker can
+    // still be using this frame's mutex or condition variable once it is gone. An exception
+    // from any range is rethrown here, after every range has finished.
+    size_t remaining = threads - 1;
+    std::exception_ptr failure;
+    std::mutex doneMutex;
+    std::condition_variable done;
+
+    for (size_t t = 1; t < threads; ++t) {
+        size_t begin = count * t / threads;
+        size_t end = count * (t + 1) / threads;
+        pool.push([&, begin, end] {
+            std::exception_ptr error;
+            try {
+                fn(begin, end);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (error && !failure) failure = error;
+            if (--remaining == 0) done.notify_one();
+        });
+    }
+
+    try {
+        fn(0, count / threads);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        if (!failure) failure = std::current_exception();
+    }
+
+    // Help with queued work instead of blocking, then sleep until the last range finishes
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (remaining == 0) break;
+        }
+        if (pool.runOne()) continue;
+        std::unique_lock<std::mutex> lock(doneMutex);
+        done.wait_for(lock, std::chrono::milliseconds(1), [&] { return remaining == 0; });
+    }
+    std::lock_guard<std::mutex> lock(doneMutex);
+    if (failure) std::rethrow_exception(failure);
+}
+
+std::string CaptureJobError(const std::function<void()>& fn) {
+    try {
+        fn();
+    } catch (const std::exception& e) {
+        return e.what()[0] ? e.what() : "unknown error";
+    } catch (...) {
+        return "unknown exception";
+    }
+    return std::string();
+}
+
+void RunAsync(std::function<void()> job) {
+    auto guarded = [job = std::move(job)]() {
+        std::string error = CaptureJobError(job);
+        if (!error.empty()) std::cerr << "Background job failed: " << error << std::endl;
+    };
+    JobPool& pool = Pool();
+    if (pool.threadCount() <= 1) {
+        std::thread(std::move(guarded)).detach(); // single-core machine: don't block the caller
+        return;
+    }
+    pool.push(std::move(guarded), true);
+}
@@ -0,0 +1,50 @@
+// job_system.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// ─────────────────────────────────────────────
+// Job system: one shared pool of worker threads
+// ─────
+// Workers are created once on first use (hardware threads - 1, or
+// PBR_WORKER_THREADS - 1 when that is set; the calling thread always takes part). A thread waiting in ParallelFor runs queued jobs
+// itself, so nested ParallelFor calls from inside a job cannot deadlock.
+unsigned WorkerCount(); // total threads that can run jobs, including the caller
+
+// Splits [0, count) into contiguous ranges and runs fn(begin, end) on each.
+// `maxThreads` caps the parallelism (0 = use every worker); `minRange` keeps
+// ranges from getting so small that scheduling overhead dominates. If `fn` throws,
+// the first exception is rethrown here once every range has finished.
+void ParallelFor(size_t count, const std::function<void(size_t begin, size_t end)>& fn,
+                 unsigned maxThreads = 0, size_t minRange = 1);
+
+// Fire-and-forget job on the pool (used for background work that outlives a frame).
+// An exception escaping `job` would terminate the process, so it is caught and logged;
+// jobs whose owner must learn about the failure catch it themselves (CaptureJobError).
+void RunAsync(std::function<void()> job);
+
+// Runs fn() and returns what() of the exception it threw, or "" when it returned normally
+std::string CaptureJobError(const std::function<void()>& fn);
+
+// Progress and cancellation shared between a background job and its owner.
+// The job splits [0, 1] into stages with beginStage and reports within the current
+// stage; the owner polls `fraction` and may set `cancel` at any time.
+struct JobProgress {
+    std::atomic<float> fraction{ 0.0f };
+    std::atomic<bool> cancel{ false };
+    std::atomic<const char*> stage{ "" }; // string literal naming the current stage
+    float stageBegin = 0.0f;
+    float stageEnd = 1.0f;
+
+    void beginStage(const char* name, float end) {
+        stageBegin = fraction.load(std::memory_order_relaxed);
+        stageEnd = end;
+        stage.store(name, std::memory_order_relaxed);
+    }
+    void report(float stageFraction) {
+        fraction.store(stageBegin + (stageEnd - stageBegin) * stageFraction, std::memory_order_relaxed);
+    }
+    bool canceled() const { return cancel.load(std::memory_order_relaxed); }
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -35,7 +36,11 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 #include "External/tinyobjloader/tiny_obj_loader.h"
 #include "shader_utils.h"
 #include "texture_utils.h"
+#include "texture_loader.h"
+#include "material_pack.h"
 #include "mesh_utils.h"
+#include "gpu_memory.h"
+#include "virtual_texture.h"
 #include "uniforms.h"
 
 // ─────────────────────────────────────────────
@@ -47,23 +52,105 @@ const unsigned int SCR_HEIGHT = 600;
 // globals
 GLuint baseColorTextureID;
 GLuint normalMapTextureID;
-GLuint roughnessTextureID;
-GLuint metallicTextureID;
-GLuint hdrTextureID;
-GLuint aoTextureID;
-
-static void Reload2D(GLuint &tex, const std::string& path) {
-    if (tex) glDeleteTextures(1, &tex);
-    tex = LoadTexture2D(path);
+GLuint roughMetalTextureID; // roughness / metallic packed into R / G
+GLuint occlusionTextureID;
+std::string roughMetalPaths[RM_CHANNEL_COUNT]; // source map per channel ("" = none)
+// The same slots for maps too large to upload whole (virtual_texture.h); `*Virtual` says
+// which of the two the slot's last request went to
+VirtualTexture baseColorVT;
+VirtualTexture normalVT;
+VirtualTexture roughMetalVT;
+VirtualTexture occlusionVT;
+bool baseColorVirtual = false;
+bool normalVirtual = false;
+bool roughMetalVirtual = false;
+bool occlusionVirtual = false;
+
+// Per-slot formats: BC1 color, BC5 normal XY and packed roughness / metallic, BC4 occlusion.
+// Mips are filtered in linear light for color, renormalized for normals, and as alpha^2 for roughness.
+static TextureOptions MapOptions(TextureCompression compression, bool srgb, bool normalMap, int roughnessChannel) {
+    TextureOptions options;
+    options.compression = compression;
+    options.mips.srgb = srgb;
+    options.mips.normalMap = normalMap;
+    options.mips.roughnessChannel = static_cast<int8_t>(roughnessChannel);
+    return options;
 }
-static void ReloadHDR(GLuint &hdrTex, GLuint &envCubemap, GLuint &irradianceMap, const std::string& path) {
-    if (hdrTex) glDeleteTextures(1, &hdrTex);
-    hdrTex = LoadHDRTexture(path);
-    if (envCubemap) glDeleteTextures(1, &envCubemap);
-    envCubemap = EquirectToCubemap(hdrTex, 0, 0, 512);
-    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-    if (irradianceMap) glDeleteTextures(1, &irradianceMap);
-    irradianceMap = ConvolveIrradiance(envCubemap);
+static const TextureOptions BASE_COLOR_OPTIONS = MapOptions(TextureCompression::BC1, true, false, -1);
+static const TextureOptions NORMAL_MAP_OPTIONS = MapOptions(TextureCompression::BC5, false, true, -1);
+static const TextureOptions ROUGH_METAL_OPTIONS = MapOptions(TextureCompression::BC5, false, false, RM_ROUGHNESS);
+static const TextureOptions OCCLUSION_OPTIONS = MapOptions(TextureCompression::BC4, false, false, -1);
+
+// Sends huge maps to the slot's virtual texture (true); otherwise cancels a virtual texture
+// that is still building, and the caller requests a regular one
+static bool RequestVirtual(VirtualTexture& vt, bool& isVirtual, const std::vector<std::string>& paths,
+                           const TextureOptions& options) {
+    isVirtual = WantsVirtualTexture(paths);
+    if (isVirtual)
+        RequestVirtualTexture(vt, paths, options);
+    else if (!vt.ready())
+        ReleaseVirtualTexture(vt);
+    return isVirtual;
+}
+// Frees whichever of the slot's two textures has been replaced, once the replacement shows
+static void SwapWhenShowing(GLuint& tex, VirtualTexture& vt, bool isVirtual) {
+    if (isVirtual && vt.ready() && tex)
+        ReleaseTexture2D(&tex);
+    else if (!isVirtual && tex && (vt.state || vt.pending))
+        ReleaseVirtualTexture(vt);
+}
+static void Reload2D(GLuint &tex, VirtualTexture& vt, bool& isVirtual, const std::string& path,
+                     const TextureOptions& options) {
+    if (RequestVirtual(vt, isVirtual, { path }, options)) return;
+    // Served from the texture registry when resident; otherwise decoded in the
+    // background while `tex` stays bound until the new one is uploaded
+    RequestTexture2D(&tex, path, options);
+}
+// Repacks the roughness / metallic texture after one of its source maps changed (cached per combination)
+static void ReloadRoughMetal() {
+    std::vector<std::string> paths(roughMetalPaths, roughMetalPaths + RM_CHANNEL_COUNT);
+    if (RequestVirtual(roughMetalVT, roughMetalVirtual, paths, ROUGH_METAL_OPTIONS)) return;
+    RequestPackedTexture2D(&roughMetalTextureID, paths, ROUGH_METAL_OPTIONS);
+}
+// Every material picker offers the native containers next to plain images
+static const char* MATERIAL_FILE_FILTER = "Image files{.png,.jpg,.jpeg,.bmp,.tga,.pbrtex,.pbrvt}";
+static bool IsTextureContainer(const std::string& path) {
+    const std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".pbrtex" || extension == ".pbrvt";
+}
+// A picked roughness or metallic map. A .pbrtex / .pbrvt is taken as an already packed
+// texture (R = roughness, G = metallic, e.g. an earlier import's cache) and shown as is
+// for both channels; it can't be split again, so picking a plain image for one channel
+// afterwards leaves the other at its constant.
+static void PickRoughMetal(RoughMetalChannel channel, const std::string& path) {
+    if (IsTextureContainer(path)) {
+        for (std::string& channelPath : roughMetalPaths) channelPath = path;
+        Reload2D(roughMetalTextureID, roughMetalVT, roughMetalVirtual, path, ROUGH_METAL_OPTIONS);
+        return;
+    }
+    for (std::string& channelPath : roughMetalPaths)
+        if (IsTextureContainer(channelPath)) channelPath.clear();
+    roughMetalPaths[channel] = path;
+    ReloadRoughMetal();
+}
+// Counts the environment textures against the GPU memory budget
+static void TrackEnvironment(const EnvironmentMaps& maps) {
+    TrackTextureMemory(GpuMemoryKind::Environment, GL_TEXTURE_CUBE_MAP, maps.environment, "environment cubemap");
+    TrackTextureMemory(GpuMemoryKind::Environment, GL_TEXTURE_CUBE_MAP, maps.prefiltered, "prefiltered environment");
+    TrackTextureMemory(GpuMemoryKind::Environment, GL_TEXTURE_2D, maps.brdfLut, "BRDF LUT");
+}
+static void ReleaseEnvironment(EnvironmentMaps& maps) {
+    DeleteTrackedTexture(GpuMemoryKind::Environment, maps.environment);
+    DeleteTrackedTexture(GpuMemoryKind::Environment, maps.prefiltered);
+    DeleteTrackedTexture(GpuMemoryKind::Environment, maps.brdfLut);
+    maps.prefilteredMaxLevel = 0;
+}
+// From the HDR's baked IBL cache when it has one (texture_utils.h)
+static void ReloadHDR(EnvironmentMaps& maps, GLuint& irradianceBuffer, const std::string& path) {
+    ReleaseEnvironment(maps);
+    if (!LoadEnvironment(path, maps)) return;
+    UploadIrradianceSH(irradianceBuffer, maps.irradiance);
+    TrackEnvironment(maps);
 }
 
 // ---- Mouse Controls ----
@@ -162,49 +249,36 @@ int main() {
     } else {
         std::cout << "Main shader program linked successfully!" << std::endl;
     }
+    glUniformBlockBinding(shader_program, glGetUniformBlockIndex(shader_program, "IrradianceSH"), IRRADIANCE_SH_BINDING);
 
     // Set up object geometry
     Mesh currentMesh;
     bool usingCustomMesh = false;
-    if (std::filesystem::exists("model.obj")) {
-        currentMesh = loadObjModel("model.obj");
-        usingCustomMesh = true;
-    } else {
-        currentMesh = createCube();
-    }
+    bool autoLod = true;         // pick the LOD from projected error every frame
+    float lodPixelError = 1.0f;  // allowed screen-space error of the chosen LOD
+    bool meshletCulling = true;  // skip off-screen clusters on the CPU
+    bool coneCulling = false;    // also skip back-facing clusters (hides the inside of open meshes)
+    MeshletCullStats cullStats;
+    std::shared_ptr<MeshLoad> meshLoad; // in-flight OBJ load; the cube stays up until it is done
+    currentMesh = createCube();
+    if (std::filesystem::exists("model.obj"))
+        meshLoad = startObjModelLoad("model.obj");
     // ---- Load Textures -----
-    baseColorTextureID = LoadTexture2D("textures/GoldPaint_BaseColor.jpg");
-    normalMapTextureID = LoadTexture2D("textures/GoldPaint_Normal.png");
-    roughnessTextureID = LoadTexture2D("textures/GoldPaint_Roughness.jpg");
-    metallicTextureID = LoadTexture2D("textures/GoldPaint_Metallic.jpg");
-    aoTextureID = LoadTexture2D("textures/GoldPaint_AmbientOcclusion.jpg");
-    hdrTextureID = LoadHDRTexture("textures/sky.hdr");
-    std::cout << "HDR texture ID: " << hdrTextureID << std::endl;
-
-    // Debug: Read back a pixel to verify HDR loaded
-    if (hdrTextureID != 0) {
-        int width, height;
-        glBindTexture(GL_TEXTURE_2D, hdrTextureID);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
-        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
-        std::cout << "HDR texture size: " << width << "x" << height << std::endl;
-        
-        // Check for GL errors
-        GLenum err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cout << "OpenGL error after HDR load: " << err << std::endl;
-        }
-    }
-    
-    // Set up Environment Cubemap and Irradiance Map
-    GLuint envCubemap = EquirectToCubemap(hdrTextureID, 0, 0, 512);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);  // CRITICAL!
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // The material maps decode in parallel while the HDR / cubemap work below runs on this thread
+    Reload2D(baseColorTextureID, baseColorVT, baseColorVirtual, "textures/GoldPaint_BaseColor.jpg", BASE_COLOR_OPTIONS);
+    Reload2D(normalMapTextureID, normalVT, normalVirtual, "textures/GoldPaint_Normal.png", NORMAL_MAP_OPTIONS);
+    Reload2D(occlusionTextureID, occlusionVT, occlusionVirtual, "textures/GoldPaint_AmbientOcclusion.jpg", OCCLUSION_OPTIONS);
+    roughMetalPaths[RM_ROUGHNESS] = "textures/GoldPaint_Roughness.jpg";
+    roughMetalPaths[RM_METALLIC] = "textures/GoldPaint_Metallic.jpg";
+    ReloadRoughMetal();
+    // Environment cubemap, specular prefilter, BRDF LUT and diffuse irradiance (spherical harmonics)
+    EnvironmentMaps environment;
+    GLuint irradianceBuffer = 0;
+    ReloadHDR(environment, irradianceBuffer, "textures/sky.hdr");
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
-    GLuint irradianceMap = ConvolveIrradiance(envCubemap);
-    std::cout << "Environment cubemap ID: " << envCubemap << ", Irradiance map ID: " << irradianceMap << std::endl;
+    std::cout << "Environment cubemap ID: " << environment.environment << ", prefiltered map ID: "
+              << environment.prefiltered << std::endl;
+    FlushTextureLoads();
 
     // ----- Compile Skybox Shaders -----
     std::string sbVS = ReadTextFile("shaders/skybox.vert");
@@ -231,6 +305,8 @@ int main() {
     LightingUniforms lightUniforms = getLightingUniforms(shader_program);
     MaterialUniforms matUniforms = getMaterialUniforms(shader_program);
     VertexUniforms vertUniforms = getVertexUniforms(shader_program);
+    GLuint feedbackProgram = InitVirtualTextures();
+    VertexUniforms feedbackUniforms = getVertexUniforms(feedbackProgram);
 
     // ----- ImGui Control Variables -----
     static float roughness = 0.8f;
@@ -258,11 +334,10 @@ int main() {
     glUniform3f(matUniforms.uDielectricF0, 0.04f, 0.04f, 0.04f);
     glUniform1i(matUniforms.uNormalTex, 1);
     glUniform1i(matUniforms.uUseNormalTex, useNormalMap ? 1 : 0);
-    glUniform1i(matUniforms.uRoughnessMap, 2);
+    glUniform1i(matUniforms.uRoughMetalMap, 2);
+    glUniform1i(matUniforms.uOcclusionMap, 3);
     glUniform1i(matUniforms.uUseRoughnessMap, useRoughnessMap ? 1 : 0);
-    glUniform1i(matUniforms.uMetallicMap, 3);
     glUniform1i(matUniforms.uUseMetallicMap, useMetallicMap ? 1 : 0);
-    glUniform1i(matUniforms.uAOMap, 4);
     glUniform1i(matUniforms.uUseAOMap, useAOMap ? 1 : 0);
 
     glUniform1i(lightUniforms.uLightType, 0);
@@ -282,6 +357,8 @@ int main() {
         100.0f
     );
     glUniformMatrix4fv(vertUniforms.projectionMatrix, 1, GL_FALSE, glm::value_ptr(projection));
+    glUseProgram(feedbackProgram);
+    glUniformMatrix4fv(feedbackUniforms.projectionMatrix, 1, GL_FALSE, glm::value_ptr(projection));
 
     // ----- Render Settings -----
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -318,13 +395,43 @@ int main() {
         if (ImGuiFileDialog::Instance()->Display("ChooseObj")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                currentMesh = loadObjModel(path);
-                usingCustomMesh = true;
+                if (meshLoad)
+                    cancelMeshLoad(*meshLoad); // superseded; its worker stops at the next check
+                meshLoad = startObjModelLoad(path);
             }
             ImGuiFileDialog::Instance()->Close();
         }
+        if (meshLoad) {
+            ImGui::Text("Loading %s", meshLoadPath(*meshLoad).c_str());
+            ImGui::ProgressBar(meshLoadProgress(*meshLoad), ImVec2(-1.0f, 0.0f), meshLoadStage(*meshLoad));
+            if (ImGui::Button("Cancel Load"))
+                cancelMeshLoad(*meshLoad);
+        }
+        // Swap in a finished load: GL upload only, the old mesh is freed
+        if (finishObjModelLoad(meshLoad, currentMesh))
+            usingCustomMesh = true;
         ImGui::Separator();
 
+        ImGui::Text("Level of Detail");
+        if (isBuildingMeshLods(currentMesh))
+            ImGui::Text("Building LODs...");
+        ImGui::Checkbox("Auto LOD", &autoLod);
+        ImGui::SliderFloat("LOD Pixel Error", &lodPixelError, 0.25f, 8.0f);
+        if (!autoLod && currentMesh.lods.size() > 1)
+            ImGui::SliderInt("Forced LOD", &currentMesh.currentLod, 0, static_cast<int>(currentMesh.lods.size()) - 1);
+        for (size_t i = 0; i < currentMesh.lods.size(); ++i) {
+            ImGui::Text("%s LOD %d: %u tris, error %.5f", static_cast<int>(i) == currentMesh.currentLod ? ">" : " ",
+                        static_cast<int>(i), currentMesh.lods[i].indexCount / 3, currentMesh.lods[i].error);
+        }
+        ImGui::Checkbox("Meshlet Culling", &meshletCulling);
+        if (meshletCulling) {
+            ImGui::Checkbox("Cone Culling", &coneCulling);
+            ImGui::Text("Meshlets: %d, frustum culled %d, cone culled %d", static_cast<int>(cullStats.total),
+                        static_cast<int>(cullStats.frustumCulled), static_cast<int>(cullStats.coneCulled));
+            ImGui::Text("Drawn: %d tris in %d ranges", static_cast<int>(cullStats.trianglesDrawn),
+                        static_cast<int>(cullStats.drawRanges));
+        }
+
         ImGui::Separator();
         ImGui::Text("Load Texture Maps");
         // --- File pickers ---
@@ -335,63 +442,91 @@ int main() {
             cfg.flags = ImGuiFileDialogFlags_Modal;
             ImGuiFileDialog::Instance()->OpenDialog(
                 "PickBase", "Choose Base Color",
-                "Image files{.png,.jpg,.jpeg,.bmp,.tga}", cfg);
+                MATERIAL_FILE_FILTER, cfg);
         }
 
         if (ImGui::Button("Load Normal")) {
             FileDialogConfig cfg; cfg.path = "."; cfg.countSelectionMax = 1; cfg.flags = ImGuiFileDialogFlags_Modal;
             ImGuiFileDialog::Instance()->OpenDialog(
                 "PickNormal", "Choose Normal Map",
-                "Image files{.png,.jpg,.jpeg,.bmp,.tga}", cfg);
+                MATERIAL_FILE_FILTER, cfg);
         }
 
         if (ImGui::Button("Load Roughness")) {
             FileDialogConfig cfg; cfg.path = "."; cfg.countSelectionMax = 1; cfg.flags = ImGuiFileDialogFlags_Modal;
             ImGuiFileDialog::Instance()->OpenDialog(
                 "PickRough", "Choose Roughness Map",
-                "Image files{.png,.jpg,.jpeg,.bmp,.tga}", cfg);
+                MATERIAL_FILE_FILTER, cfg);
         }
 
         if (ImGui::Button("Load Metallic")) {
             FileDialogConfig cfg; cfg.path = "."; cfg.countSelectionMax = 1; cfg.flags = ImGuiFileDialogFlags_Modal;
             ImGuiFileDialog::Instance()->OpenDialog(
                 "PickMetallic", "Choose Metallic Map",
-                "Image files{.png,.jpg,.jpeg,.bmp,.tga}", cfg);
+                MATERIAL_FILE_FILTER, cfg);
         }
 
         if (ImGui::Button("Load AO")) {
             FileDialogConfig cfg; cfg.path = "."; cfg.countSelectionMax = 1; cfg.flags = ImGuiFileDialogFlags_Modal;
             ImGuiFileDialog::Instance()->OpenDialog(
                 "PickAO", "Choose Ambient Occlusion Map",
-                "Image files{.png,.jpg,.jpeg,.bmp,.tga}", cfg);
+                MATERIAL_FILE_FILTER, cfg);
         }
 
+        if (size_t pending = PendingTextureLoads())
+            ImGui::Text("Loading %zu texture(s)...", pending);
+        TextureCacheStats texStats = GetTextureCacheStats();
+        ImGui::Text("Texture cache: %zu textures, %.1f MB (%.1f MB unused), %.0f%% hits",
+                    texStats.textures, texStats.residentBytes / (1024.0 * 1024.0),
+                    texStats.idleBytes / (1024.0 * 1024.0), texStats.hitRate() * 100.0f);
+        VirtualTextureStats vtStats = GetVirtualTextureStats();
+        if (vtStats.textures)
+            ImGui::Text("Virtual textures: %zu, %zu / %zu pages resident (%.1f MB), %zu loaded, %zu evicted",
+                        vtStats.textures, vtStats.residentPages, vtStats.slots, vtStats.cacheBytes / (1024.0 * 1024.0),
+                        vtStats.pageLoads, vtStats.pageEvictions);
+
+        // --- GPU memory budget ---
+        GpuMemoryStats memStats = GetGpuMemoryStats();
+        int budgetMB = static_cast<int>(memStats.budget >> 20);
+        if (ImGui::SliderInt("GPU Memory Budget (MB)", &budgetMB, 64, 8192))
+            SetGpuMemoryBudget(static_cast<size_t>(budgetMB) << 20);
+        ImGui::ProgressBar(memStats.budget ? static_cast<float>(memStats.total) / memStats.budget : 0.0f,
+                           ImVec2(-1.0f, 0.0f), "");
+        ImGui::Text("GPU memory: %.1f / %.0f MB (peak %.1f MB)", memStats.total / (1024.0 * 1024.0),
+                    memStats.budget / (1024.0 * 1024.0), memStats.peak / (1024.0 * 1024.0));
+        for (int k = 0; k < static_cast<int>(GpuMemoryKind::Count); ++k)
+            ImGui::BulletText("%s: %.1f MB in %zu", GpuMemoryKindName(static_cast<GpuMemoryKind>(k)),
+                              memStats.bytes[k] / (1024.0 * 1024.0), memStats.resources[k]);
+        ImGui::Text("Evicted %zu, downscaled %zu", texStats.evictions, texStats.downscales);
+        if (ImGui::Button("Dump GPU Memory (JSON)"))
+            WriteGpuMemoryReport("gpu_memory.json");
+
         // --- Handle results ---
         if (ImGuiFileDialog::Instance()->Display("PickBase")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                Reload2D(baseColorTextureID, path);
+                Reload2D(baseColorTextureID, baseColorVT, baseColorVirtual, path, BASE_COLOR_OPTIONS);
             }
             ImGuiFileDialog::Instance()->Close();
         }
         if (ImGuiFileDialog::Instance()->Display("PickNormal")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                Reload2D(normalMapTextureID, path);
+                Reload2D(normalMapTextureID, normalVT, normalVirtual, path, NORMAL_MAP_OPTIONS);
             }
             ImGuiFileDialog::Instance()->Close();
         }
         if (ImGuiFileDialog::Instance()->Display("PickRough")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                Reload2D(roughnessTextureID, path);
+                PickRoughMetal(RM_ROUGHNESS, path);
             }
             ImGuiFileDialog::Instance()->Close();
         }
         if (ImGuiFileDialog::Instance()->Display("PickMetallic")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                Reload2D(metallicTextureID, path);
+                PickRoughMetal(RM_METALLIC, path);
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -399,7 +534,7 @@ int main() {
         if (ImGuiFileDialog::Instance()->Display("PickAO")) {
             if (ImGuiFileDialog::Instance()->IsOk()) {
                 std::string path = ImGuiFileDialog::Instance()->GetFilePathName();
-                Reload2D(aoTextureID, path);
+                Reload2D(occlusionTextureID, occlusionVT, occlusionVirtual, path, OCCLUSION_OPTIONS);
             }
             ImGuiFileDialog::Instance()->Close();
         }
@@ -471,26 +606,36 @@ int main() {
         // REMOVED: This was overriding the ImGui slider values!
         // Lines 469-472 have been deleted
         
-        // Bind textures
+        // Stream decoded maps into their textures (bounded per frame), page in what the
+        // last feedback asked for, then bind
+        UpdateTextureStreaming();
+        UpdateVirtualTextures();
+        SwapWhenShowing(baseColorTextureID, baseColorVT, baseColorVirtual);
+        SwapWhenShowing(normalMapTextureID, normalVT, normalVirtual);
+        SwapWhenShowing(roughMetalTextureID, roughMetalVT, roughMetalVirtual);
+        SwapWhenShowing(occlusionTextureID, occlusionVT, occlusionVirtual);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, baseColorTextureID);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, normalMapTextureID);
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, roughnessTextureID);
+        glBindTexture(GL_TEXTURE_2D, roughMetalTextureID);
         glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, metallicTextureID);
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, aoTextureID);  // Fix: 2D texture, not cubemap
+        glBindTexture(GL_TEXTURE_2D, occlusionTextureID);
         glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
+        glBindTexture(GL_TEXTURE_2D, environment.brdfLut);
         glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environment.prefiltered);
+        BindVirtualTexture(baseColorVT, shader_program, "uBaseColorVT", 7);
+        BindVirtualTexture(normalVT, shader_program, "uNormalVT", 9);
+        BindVirtualTexture(roughMetalVT, shader_program, "uRoughMetalVT", 11);
+        BindVirtualTexture(occlusionVT, shader_program, "uOcclusionVT", 13);
         
         // Set IBL uniforms
         glUniform1i(glGetUniformLocation(shader_program, "useIBL"), useIBL ? 1 : 0);
-        glUniform1i(glGetUniformLocation(shader_program, "irradianceMap"), 5);
-        glUniform1i(glGetUniformLocation(shader_program, "environmentMap"), 6);
+        glUniform1i(glGetUniformLocation(shader_program, "brdfLut"), 5);
+        glUniform1i(glGetUniformLocation(shader_program, "prefilteredMap"), 6);
+        glUniform1f(glGetUniformLocation(shader_program, "uPrefilterMaxLod"), static_cast<float>(environment.prefilteredMaxLevel));
 
         // Update time-based lighting
         float time = glfwGetTime();
@@ -515,9 +660,36 @@ int main() {
         glm::mat4 view = glm::lookAt(cameraPos, target, glm::vec3(0.0f, 1.0f, 0.0f));
         glUniformMatrix4fv(vertUniforms.modelMatrix, 1, GL_FALSE, glm::value_ptr(model));
         glUniformMatrix4fv(vertUniforms.viewMatrix, 1, GL_FALSE, glm::value_ptr(view));
+        glUniform3fv(vertUniforms.positionOffset, 1, glm::value_ptr(currentMesh.dequant.positionOffset));
+        glUniform3fv(vertUniforms.positionScale, 1, glm::value_ptr(currentMesh.dequant.positionScale));
+        glUniform4fv(vertUniforms.uvTransform, 1, glm::value_ptr(currentMesh.dequant.uvTransform));
+
+        // LOD from the projected error at the nearest point of the bounding sphere
+        updateMeshLods(currentMesh);
+        if (autoLod && !currentMesh.lods.empty()) {
+            float distance = std::max(cameraZoom - currentMesh.radius, 0.1f);
+            float pixelsPerUnit = h / (2.0f * tanf(glm::radians(45.0f) * 0.5f) * distance);
+            currentMesh.currentLod = SelectLod(currentMesh.lods, currentMesh.currentLod, pixelsPerUnit, lodPixelError);
+        }
 
         // Draw the cube
-        currentMesh.draw();
+        cullStats = MeshletCullStats();
+        if (meshletCulling)
+            drawMeshCulled(currentMesh, model, view, projection, cameraPos, coneCulling, &cullStats);
+        else
+            currentMesh.draw();
+
+        // Virtual texture feedback: the same mesh at 1/8 size, reporting the pages it samples
+        if (VirtualTexturesActive()) {
+            BeginVirtualTextureFeedback(w, h);
+            glUniformMatrix4fv(feedbackUniforms.modelMatrix, 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(feedbackUniforms.viewMatrix, 1, GL_FALSE, glm::value_ptr(view));
+            glUniform3fv(feedbackUniforms.positionOffset, 1, glm::value_ptr(currentMesh.dequant.positionOffset));
+            glUniform3fv(feedbackUniforms.positionScale, 1, glm::value_ptr(currentMesh.dequant.positionScale));
+            glUniform4fv(feedbackUniforms.uvTransform, 1, glm::value_ptr(currentMesh.dequant.uvTransform));
+            currentMesh.draw();
+            EndVirtualTextureFeedback();
+        }
 
         // ----- Render Skybox -----
         glm::mat4 R = glm::rotate(glm::mat4(1.0f), time * 0.25f, glm::vec3(0,1,0));
@@ -529,7 +701,7 @@ int main() {
         glUniformMatrix4fv(sbView, 1, GL_FALSE, glm::value_ptr(viewSky));
         glUniformMatrix4fv(sbProj, 1, GL_FALSE, glm::value_ptr(projection));
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, environment.environment);
         renderCube();
         glDepthFunc(GL_LESS);
 
@@ -546,14 +718,19 @@ int main() {
     glDeleteShader(frag_shader);
     glDeleteProgram(shader_program);
     glDeleteProgram(sbProg);
-    glDeleteTextures(1, &baseColorTextureID);
-    glDeleteTextures(1, &normalMapTextureID);
-    glDeleteTextures(1, &roughnessTextureID);
-    glDeleteTextures(1, &metallicTextureID);
-    glDeleteTextures(1, &aoTextureID);
-    glDeleteTextures(1, &hdrTextureID);
-    glDeleteTextures(1, &envCubemap);
-    glDeleteTextures(1, &irradianceMap);
+    ReleaseTexture2D(&baseColorTextureID);
+    ReleaseTexture2D(&normalMapTextureID);
+    ReleaseTexture2D(&roughMetalTextureID);
+    ReleaseTexture2D(&occlusionTextureID);
+    ReleaseVirtualTexture(baseColorVT);
+    ReleaseVirtualTexture(normalVT);
+    ReleaseVirtualTexture(roughMetalVT);
+    ReleaseVirtualTexture(occlusionVT);
+    ShutdownVirtualTextures();
+    ReleaseEnvironment(environment);
+    glDeleteBuffers(1, &irradianceBuffer);
+    ShutdownEnvironmentBake();
+    ShutdownTextureStreaming();
     currentMesh.cleanup();
     
     ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,54 @@
+// material_pack.cpp
+#include "material_pack.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+
+// Bilinear lookup of channel 0 at normalized (u, v), texel centers aligned
+static unsigned char SampleBilinear(const ChannelSource& source, float u, float v) {
+    float x = std::min(std::max(u * source.width - 0.5f, 0.0f), static_cast<float>(source.width - 1));
+    float y = std::min(std::max(v * source.height - 0.5f, 0.0f), static_cast<float>(source.height - 1));
+    int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    int x1 = std::min(x0 + 1, source.width - 1), y1 = std::min(y0 + 1, source.height - 1);
+    float fx = x - x0, fy = y - y0;
+    auto at = [&](int px, int py) {
+        return static_cast<float>(source.pixels[(static_cast<size_t>(py) * source.width + px) * source.channels]);
+    };
+    float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+    float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+    return static_cast<unsigned char>(std::lround(top + (bottom - top) * fy));
+}
+
+bool PackChannels(const ChannelSource* sources, int count, std::vector<unsigned char>& packed, int& width, int& height) {
+    if (count < 1 || count > 4) return false;
+    width = 0;
+    height = 0;
+    for (int c = 0; c < count; ++c) {
+        if (!sources[c].pixels) continue;
+        if (sources[c].width <= 0 || sources[c].height <= 0 || sources[c].channels < 1) return false;
+        width = std::max(width, sources[c].width);
+        height = std::max(height, sources[c].height);
+    }
+    if (width == 0) width = height = 1; // no maps at all: a single texel of fill values
+
+    packed.resize(static_cast<size_t>(width) * height * count);
+    ParallelFor(static_cast<size_t>(height), [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            unsigned char* row = packed.data() + y * width * count;
+            for (int c = 0; c < count; ++c) {
+                const ChannelSource& source = sources[c];
+                if (!source.pixels) {
+                    for (int x = 0; x < width; ++x) row[x * count + c] = source.fill;
+                } else if (source.width == width && source.height == height) {
+                    const unsigned char* src = source.pixels + y * width * source.channels;
+                    for (int x = 0; x < width; ++x) row[x * count + c] = src[x * source.channels];
+                } else {
+                    float v = (y + 0.5f) / height;
+                    for (int x = 0; x < width; ++x)
+                        row[x * count + c] = SampleBilinear(source, (x + 0.5f) / width, v);
+                }
+            }
+        }
+    }, 0, 16);
+    return true;
+}
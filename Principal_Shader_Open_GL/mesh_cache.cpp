@@ -0,0 +1,222 @@
+// mesh_cache.cpp
+#include "mesh_cache.h"
+#include "file_utils.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// Bump whenever the file layout or the Vertex struct changes
+static const uint32_t MESH_CACHE_VERSION = 8; // 2: vec4 tangent with handedness, 3: optimized index order, 4: LOD chain, 5: meshlets, 6: upload layout (packed vertices, 16-bit indices), 7: optimize flag, 8: dequant scale for normalized fetch
+static const char MESH_CACHE_MAGIC[8] = { 'P', 'B', 'R', 'M', 'E', 'S', 'H', '\0' };
+
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexStride;   // sizeof(Vertex) or sizeof(PackedVertex) at write time
+    uint32_t vertexFormat;   // VertexFormat
+    uint32_t indexSize;      // bytes per index, 2 or 4
+    uint64_t sourceSize;
+    int64_t  sourceMTime;    // filesystem clock ticks
+    uint64_t sourceHash;     // HashFileSampled(source)
+    uint64_t pathHash;       // hash of the absolute source path
+    uint64_t vertexCount;
+    uint64_t indexCount;     // every LOD, back to back
+    uint64_t lodCount;
+    uint64_t vertexOffset;   // byte offsets from the start of the file, 16-byte aligned
+    uint64_t indexOffset;
+    uint64_t lodOffset;      // MeshLod table
+    uint64_t meshletCount;
+    uint64_t meshletOffset;  // Meshlet table
+    float positionOffset[3]; // VertexDequantization
+    float positionScale[3];
+    float uvTransform[4];
+    float radius;
+    uint32_t optimized;      // 1 when OptimizeMesh ran
+};
+
+struct MeshCacheKey {
+    uint64_t sourceSize = 0;
+    int64_t sourceMTime = 0;
+    uint64_t sourceHash = 0;
+    uint64_t pathHash = 0;
+};
+
+static bool MakeMeshCacheKey(const std::string& objPath, MeshCacheKey& key) {
+    std::error_code ec;
+    std::filesystem::path absPath = std::filesystem::absolute(objPath, ec);
+    if (ec) return false;
+
+    key.sourceSize = std::filesystem::file_size(objPath, ec);
+    if (ec) return false;
+    key.sourceMTime = static_cast<int64_t>(std::filesystem::last_write_time(objPath, ec).time_since_epoch().count());
+    if (ec) return false;
+
+    std::string absString = absPath.lexically_normal().string();
+    key.pathHash = HashBytes(absString.data(), absString.size());
+    key.sourceHash = HashFileSampled(objPath);
+    return true;
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t VertexStride(VertexFormat format) {
+    return format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+std::string MeshCachePath(const std::string& objPath) {
+    return std::filesystem::path(objPath).replace_extension(".pbrmesh").string();
+}
+
+bool OpenMeshCache(const std::string& objPath, VertexFormat format, bool optimized, MappedFile& file,
+                   MeshCacheData& data) {
+    std::string cachePath = MeshCachePath(objPath);
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec)) return false;
+
+    MeshCacheKey key;
+    if (!MakeMeshCacheKey(objPath, key)) return false;
+
+    if (!file.open(cachePath)) {
+        std::cerr << "Cannot map mesh cache: " << cachePath << std::endl;
+        return false;
+    }
+    MeshCacheHeader header;
+    if (file.size() < sizeof(MeshCacheHeader)) return false;
+
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+        header.version != MESH_CACHE_VERSION ||
+        header.vertexFormat != static_cast<uint32_t>(format) ||
+        header.vertexStride != VertexStride(format) ||
+        header.optimized != (optimized ? 1u : 0u)) {
+        std::cout << "Mesh cache out of date (format), rebuilding: " << cachePath << std::endl;
+        return false;
+    }
+    if (header.sourceSize != key.sourceSize || header.sourceMTime != key.sourceMTime ||
+        header.sourceHash != key.sourceHash || header.pathHash != key.pathHash) {
+        std::cout << "Mesh cache out of date (source changed), rebuilding: " << cachePath << std::endl;
+        return false;
+    }
+
+    const size_t expectedIndexSize = CanUse16BitIndices(static_cast<size_t>(header.vertexCount)) ? sizeof(uint16_t)
+                                                                                                 : sizeof(unsigned int);
+    uint64_t vertexBytes = header.vertexCount * header.vertexStride;
+    uint64_t indexBytes = header.indexCount * header.indexSize;
+    uint64_t lodBytes = header.lodCount * sizeof(MeshLod);
+    uint64_t meshletBytes = header.meshletCount * sizeof(Meshlet);
+    if (header.indexSize != expectedIndexSize ||
+        header.vertexOffset + vertexBytes > file.size() || header.indexOffset + indexBytes > file.size() ||
+        header.lodOffset + lodBytes > file.size() || header.meshletOffset + meshletBytes > file.size() ||
+        header.lodCount == 0) {
+        std::cerr << "Mesh cache truncated: " << cachePath << std::endl;
+        return false;
+    }
+
+    // Every table is used in place: 16-byte aligned offsets into a page-aligned mapping
+    data.lods = reinterpret_cast<const MeshLod*>(file.data() + header.lodOffset);
+    data.lodCount = static_cast<size_t>(header.lodCount);
+    data.meshlets = reinterpret_cast<const Meshlet*>(file.data() + header.meshletOffset);
+    data.meshletCount = static_cast<size_t>(header.meshletCount);
+    for (size_t i = 0; i < data.meshletCount; ++i) {
+        const Meshlet& meshlet = data.meshlets[i];
+        if (static_cast<uint64_t>(meshlet.indexOffset) + meshlet.indexCount > header.indexCount) {
+            std::cerr << "Mesh cache has a bad meshlet table: " << cachePath << std::endl;
+            return false;
+        }
+    }
+    for (size_t i = 0; i < data.lodCount; ++i) {
+        const MeshLod& lod = data.lods[i];
+        if (static_cast<uint64_t>(lod.indexOffset) + lod.indexCount > header.indexCount ||
+            static_cast<uint64_t>(lod.meshletOffset) + lod.meshletCount > header.meshletCount) {
+            std::cerr << "Mesh cache has a bad LOD table: " << cachePath << std::endl;
+            return false;
+        }
+    }
+
+    // No copies: the loader uploads these straight from the mapping, the OS pages them in once
+    data.format = format;
+    data.vertices = file.data() + header.vertexOffset;
+    data.vertexCount = static_cast<size_t>(header.vertexCount);
+    data.dequant.positionOffset = glm::vec3(header.positionOffset[0], header.positionOffset[1], header.positionOffset[2]);
+    data.dequant.positionScale = glm::vec3(header.positionScale[0], header.positionScale[1], header.positionScale[2]);
+    data.dequant.uvTransform = glm::vec4(header.uvTransform[0], header.uvTransform[1], header.uvTransform[2],
+                                         header.uvTransform[3]);
+    data.radius = header.radius;
+    data.optimized = optimized;
+    data.indices = file.data() + header.indexOffset;
+    data.indexCount = static_cast<size_t>(header.indexCount);
+    data.indexSize = header.indexSize;
+
+    std::cout << "Mapped mesh cache: " << cachePath << " (" << data.vertexCount << " vertices, "
+              << data.lods[0].indexCount / 3 << " triangles, " << data.lodCount << " LODs, "
+              << data.meshletCount << " meshlets)" << std::endl;
+    return true;
+}
+
+bool WriteMeshCache(const std::string& objPath, const MeshCacheData& data) {
+    MeshCacheKey key;
+    if (!MakeMeshCacheKey(objPath, key)) return false;
+
+    MeshCacheHeader header = {};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexStride = static_cast<uint32_t>(VertexStride(data.format));
+    header.vertexFormat = static_cast<uint32_t>(data.format);
+    header.indexSize = static_cast<uint32_t>(data.indexSize);
+    header.sourceSize = key.sourceSize;
+    header.sourceMTime = key.sourceMTime;
+    header.sourceHash = key.sourceHash;
+    header.pathHash = key.pathHash;
+    header.vertexCount = data.vertexCount;
+    header.indexCount = data.indexCount;
+    for (int c = 0; c < 3; ++c) {
+        header.positionOffset[c] = data.dequant.positionOffset[c];
+        header.positionScale[c] = data.dequant.positionScale[c];
+    }
+    for (int c = 0; c < 4; ++c) header.uvTransform[c] = data.dequant.uvTransform[c];
+    header.radius = data.radius;
+    header.optimized = data.optimized ? 1 : 0;
+
+    // No chain yet: a single level covering every index
+    MeshLod single;
+    const MeshLod* table = data.lods;
+    header.lodCount = data.lodCount;
+    if (data.lodCount == 0) {
+        single.indexCount = static_cast<uint32_t>(data.indexCount);
+        table = &single;
+        header.lodCount = 1;
+    }
+    header.meshletCount = data.meshletCount;
+
+    uint64_t vertexBytes = data.vertexCount * header.vertexStride;
+    uint64_t indexBytes = data.indexCount * data.indexSize;
+    uint64_t lodBytes = header.lodCount * sizeof(MeshLod);
+    uint64_t meshletBytes = data.meshletCount * sizeof(Meshlet);
+    header.vertexOffset = AlignUp(sizeof(MeshCacheHeader), 16);
+    header.indexOffset = AlignUp(header.vertexOffset + vertexBytes, 16);
+    header.lodOffset = AlignUp(header.indexOffset + indexBytes, 16);
+    header.meshletOffset = AlignUp(header.lodOffset + lodBytes, 16);
+
+    static const unsigned char padding[16] = {};
+    std::vector<FileChunk> chunks = {
+        { &header, sizeof(header) },
+        { padding, static_cast<size_t>(header.vertexOffset - sizeof(header)) },
+        { data.vertices, static_cast<size_t>(vertexBytes) },
+        { padding, static_cast<size_t>(header.indexOffset - header.vertexOffset - vertexBytes) },
+        { data.indices, static_cast<size_t>(indexBytes) },
+        { padding, static_cast<size_t>(header.lodOffset - header.indexOffset - indexBytes) },
+        { table, static_cast<size_t>(lodBytes) },
+        { padding, static_cast<size_t>(header.meshletOffset - header.lodOffset - lodBytes) },
+        { data.meshlets, static_cast<size_t>(meshletBytes) },
+    };
+
+    std::string cachePath = MeshCachePath(objPath);
+    if (!WriteFileAtomic(cachePath, chunks)) return false;
+    std::cout << "Wrote mesh cache: " << cachePath << std::endl;
+    return true;
+}
@@ -0,0 +1,42 @@
+// mesh_cache.h
+#pragma once
+#include "file_utils.h"
+#include "mesh_utils.h"
+#include <string>
+#include <cstddef>
+
+// ─────────────────────────────────────────────
+// Binary mesh cache (.pbrmesh)
+// ─────
+// Stores the final, upload-ready arrays of a processed OBJ next to the source file
+// ("model.obj" -> "model.pbrmesh"): the vertices in the layout the viewer uploads
+// (PackedVertex with its dequantization, or float Vertex), the indices already
+// narrowed to 16 bits when the vertex count allows, the LOD table and meshlets. A
+// hit is uploaded as-is, with no packing pass. A cache is only used when the
+// source path, size, modification time and sampled content hash all match, so
+// editing or replacing the OBJ silently triggers a rebuild.
+std::string MeshCachePath(const std::string& objPath);
+
+// The arrays point into the mapping (which must stay open until they are uploaded)
+// or, for WriteMeshCache, the writer's buffers
+struct MeshCacheData {
+    VertexFormat format = VERTEX_FORMAT_FLOAT;
+    const void* vertices = nullptr;          // Vertex or PackedVertex, per `format`
+    size_t vertexCount = 0;
+    VertexDequantization dequant;            // identity unless packed
+    float radius = 0.0f;                     // bounding sphere around the model origin
+    bool optimized = true;                   // indices in OptimizeMesh order, not the OBJ's
+    const void* indices = nullptr;           // every LOD back to back
+    size_t indexCount = 0;
+    size_t indexSize = sizeof(unsigned int); // sizeof(uint16_t) when CanUse16BitIndices allows
+    const MeshLod* lods = nullptr;           // none = a single level covering every index
+    size_t lodCount = 0;
+    const Meshlet* meshlets = nullptr;       // the clusters the LOD table points into
+    size_t meshletCount = 0;
+};
+
+// CPU only, so a loader thread can map and validate it. False on a miss, which
+// includes a cache stored in another vertex format or index order than asked for.
+bool OpenMeshCache(const std::string& objPath, VertexFormat format, bool optimized, MappedFile& file,
+                   MeshCacheData& data);
+bool WriteMeshCache(const std::string& objPath, const MeshCacheData& data);
@@ -0,0 +1,391 @@
+// mesh_lod.cpp
+#include "mesh_lod.h"
+#include "mesh_optimize.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+static const uint32_t NO_VERTEX = 0xFFFFFFFFu;
+static const double BORDER_WEIGHT = 10.0;   // how strongly open borders and seams hold their shape
+static const double ATTRIBUTE_WEIGHT = 0.1; // normal change, in squared edge lengths
+
+// Symmetric 4x4 plane quadric; `area` is the summed face area, so
+// Evaluate(p) / area is the mean squared distance to the original surface.
+struct Quadric {
+    double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+    double b0 = 0, b1 = 0, b2 = 0, c = 0;
+    double area = 0;
+
+    void addPlane(const glm::vec3& n, double d, double weight) {
+        a00 += weight * n.x * n.x; a11 += weight * n.y * n.y; a22 += weight * n.z * n.z;
+        a01 += weight * n.x * n.y; a02 += weight * n.x * n.z; a12 += weight * n.y * n.z;
+        b0 += weight * n.x * d; b1 += weight * n.y * d; b2 += weight * n.z * d;
+        c += weight * d * d;
+    }
+
+    void add(const Quadric& o) {
+        a00 += o.a00; a11 += o.a11; a22 += o.a22; a01 += o.a01; a02 += o.a02; a12 += o.a12;
+        b0 += o.b0; b1 += o.b1; b2 += o.b2; c += o.c;
+        area += o.area;
+    }
+
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z
+                 + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                 + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return std::max(e, 0.0);
+    }
+};
+
+enum LodVertexKind : uint8_t {
+    LOD_MANIFOLD, // interior vertex with a single wedge: collapses onto any neighbour
+    LOD_BORDER,   // on an open border: collapses along the border only
+    LOD_SEAM,     // two wedges along a UV/normal seam: collapses along the seam, both wedges together
+    LOD_LOCKED    // corners, seam ends, non-manifold: never moves
+};
+
+struct LodCollapse {
+    uint32_t from, to;   // wedge being removed and where its triangles go
+    uint32_t from2, to2; // the other wedge of a seam collapse (NO_VERTEX otherwise)
+    float cost;
+};
+
+struct LodSimplifier {
+    const std::vector<Vertex>& vertices;
+    std::vector<uint32_t> posId;        // first vertex index with the same position
+    std::vector<Quadric> quadrics;      // per posId
+    std::vector<unsigned int> triangles;
+    double maxCost = 0.0;               // largest collapse cost applied so far
+
+    explicit LodSimplifier(const std::vector<Vertex>& v) : vertices(v) {}
+};
+
+static uint64_t EdgeKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+// Exact position equality: vertices were split by the dedup pass only where an attribute differs
+static void BuildPositionIds(const std::vector<Vertex>& vertices, std::vector<uint32_t>& posId) {
+    std::vector<uint32_t> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](uint32_t a, uint32_t b) {
+        int c = std::memcmp(&vertices[a].position, &vertices[b].position, sizeof(glm::vec3));
+        return c != 0 ? c < 0 : a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    posId.resize(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        bool same = i > 0 && std::memcmp(&vertices[order[i]].position, &vertices[order[i - 1]].position, sizeof(glm::vec3)) == 0;
+        posId[order[i]] = same ? posId[order[i - 1]] : order[i];
+    }
+}
+
+// Directed edges without a twin are open: mesh borders, or seams where the two sides use different wedges
+static void FindOpenEdges(const std::vector<unsigned int>& tris, std::vector<uint64_t>& open) {
+    std::vector<uint64_t> edges;
+    edges.reserve(tris.size());
+    for (size_t t = 0; t + 2 < tris.size(); t += 3)
+        for (int k = 0; k < 3; ++k)
+            edges.push_back(EdgeKey(tris[t + k], tris[t + (k + 1) % 3]));
+    std::vector<uint64_t> sorted = edges;
+    std::sort(sorted.begin(), sorted.end());
+
+    open.clear();
+    for (uint64_t e : edges) {
+        uint64_t twin = (e << 32) | (e >> 32);
+        if (!std::binary_search(sorted.begin(), sorted.end(), twin)) open.push_back(e);
+    }
+}
+
+static void InitQuadrics(LodSimplifier& s) {
+    const std::vector<Vertex>& vertices = s.vertices;
+    s.quadrics.assign(vertices.size(), Quadric());
+
+    for (size_t t = 0; t + 2 < s.triangles.size(); t += 3) {
+        const glm::vec3& p0 = vertices[s.triangles[t]].position;
+        glm::vec3 n = glm::cross(vertices[s.triangles[t + 1]].position - p0, vertices[s.triangles[t + 2]].position - p0);
+        float len = glm::length(n);
+        if (len <= 0.0f) continue;
+        n = n / len;
+        double area = 0.5 * len;
+        for (int k = 0; k < 3; ++k) {
+            Quadric& q = s.quadrics[s.posId[s.triangles[t + k]]];
+            q.addPlane(n, -glm::dot(n, p0), area);
+            q.area += area;
+        }
+    }
+
+    // Planes through each open edge, perpendicular to its face, keep borders and seams in place
+    std::vector<uint64_t> open;
+    FindOpenEdges(s.triangles, open);
+    std::sort(open.begin(), open.end());
+    for (size_t t = 0; t + 2 < s.triangles.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = s.triangles[t + k], b = s.triangles[t + (k + 1) % 3];
+            if (!std::binary_search(open.begin(), open.end(), EdgeKey(a, b))) continue;
+
+            const glm::vec3& pa = vertices[a].position;
+            const glm::vec3& pb = vertices[b].position;
+            const glm::vec3& pc = vertices[s.triangles[t + (k + 2) % 3]].position;
+            glm::vec3 edge = pb - pa;
+            glm::vec3 faceNormal = glm::cross(edge, pc - pa);
+            glm::vec3 n = glm::cross(edge, faceNormal);
+            float len = glm::length(n);
+            if (len <= 0.0f) continue;
+            n = n / len;
+            double weight = BORDER_WEIGHT * glm::dot(edge, edge);
+            s.quadrics[s.posId[a]].addPlane(n, -glm::dot(n, pa), weight);
+            s.quadrics[s.posId[b]].addPlane(n, -glm::dot(n, pa), weight);
+        }
+    }
+}
+
+static float CollapseCost(const LodSimplifier& s, uint32_t from, uint32_t to) {
+    const Quadric& q = s.quadrics[s.posId[from]];
+    const Vertex& a = s.vertices[from];
+    const Vertex& b = s.vertices[to];
+    double distance2 = q.evaluate(b.position) / std::max(q.area, 1e-30);
+    glm::vec3 edge = b.position - a.position;
+    glm::vec3 dn = b.normal - a.normal;
+    return static_cast<float>(distance2 + ATTRIBUTE_WEIGHT * glm::dot(edge, edge) * glm::dot(dn, dn));
+}
+
+// Moving `from` onto `to` must not fold any surviving triangle over
+static bool CollapseFlips(const LodSimplifier& s, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency,
+                          uint32_t from, uint32_t to) {
+    const glm::vec3& target = s.vertices[to].position;
+    for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a) {
+        const unsigned int* tri = &s.triangles[adjacency[a] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to) continue; // this one disappears
+
+        glm::vec3 p[3], q[3];
+        for (int k = 0; k < 3; ++k) {
+            p[k] = s.vertices[tri[k]].position;
+            q[k] = tri[k] == from ? target : p[k];
+        }
+        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+        glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+        if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after)) return true;
+    }
+    return false;
+}
+
+// One round of independent collapses (no two touch the same 1-ring); returns how many were applied
+static size_t CollapsePass(LodSimplifier& s, size_t targetTriangles) {
+    const size_t vertexCount = s.vertices.size();
+    std::vector<unsigned int>& tris = s.triangles;
+    size_t triCount = tris.size() / 3;
+
+    // Vertex -> triangle adjacency for the current triangles
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (unsigned int v : tris) ++offsets[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(tris.size());
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < tris.size(); ++i) adjacency[cursor[tris[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // Open edge topology
+    std::vector<uint64_t> open;
+    FindOpenEdges(tris, open);
+    std::vector<uint8_t> openOut(vertexCount, 0), openIn(vertexCount, 0);
+    std::vector<uint32_t> openNext(vertexCount, NO_VERTEX), openPrev(vertexCount, NO_VERTEX);
+    for (uint64_t e : open) {
+        uint32_t a = static_cast<uint32_t>(e >> 32), b = static_cast<uint32_t>(e);
+        if (openOut[a] < 255) ++openOut[a];
+        if (openIn[b] < 255) ++openIn[b];
+        openNext[a] = b;
+        openPrev[b] = a;
+    }
+
+    // Live wedges per position
+    std::vector<uint32_t> wedgeHead(vertexCount, NO_VERTEX), wedgeNext(vertexCount, NO_VERTEX);
+    std::vector<uint8_t> wedgeCount(vertexCount, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (offsets[v + 1] == offsets[v]) continue;
+        uint32_t p = s.posId[v];
+        wedgeNext[v] = wedgeHead[p];
+        wedgeHead[p] = v;
+        if (wedgeCount[p] < 255) ++wedgeCount[p];
+    }
+    auto otherWedge = [&](uint32_t v) {
+        for (uint32_t w = wedgeHead[s.posId[v]]; w != NO_VERTEX; w = wedgeNext[w])
+            if (w != v) return w;
+        return NO_VERTEX;
+    };
+    auto onSingleOpenLoop = [&](uint32_t v) {
+        return openOut[v] == 1 && openIn[v] == 1 && s.posId[openNext[v]] != s.posId[openPrev[v]];
+    };
+
+    std::vector<uint8_t> kind(vertexCount, LOD_LOCKED);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        if (offsets[v + 1] == offsets[v]) continue;
+        uint8_t wedges = wedgeCount[s.posId[v]];
+        if (wedges == 1)
+            kind[v] = (openOut[v] == 0 && openIn[v] == 0) ? LOD_MANIFOLD : (onSingleOpenLoop(v) ? LOD_BORDER : LOD_LOCKED);
+        else if (wedges == 2 && onSingleOpenLoop(v) && onSingleOpenLoop(otherWedge(v)))
+            kind[v] = LOD_SEAM;
+    }
+
+    auto alongOpenEdge = [&](uint32_t a, uint32_t b) { return openNext[a] == b || openPrev[a] == b; };
+
+    // Fills `c` if from -> to is a legal collapse
+    auto tryCollapse = [&](uint32_t from, uint32_t to, LodCollapse& c) {
+        c.from = from; c.to = to; c.from2 = c.to2 = NO_VERTEX;
+        switch (kind[from]) {
+        case LOD_MANIFOLD:
+            c.cost = CollapseCost(s, from, to);
+            return true;
+        case LOD_BORDER:
+            if (!alongOpenEdge(from, to) || (kind[to] != LOD_BORDER && kind[to] != LOD_LOCKED)) return false;
+            c.cost = CollapseCost(s, from, to);
+            return true;
+        case LOD_SEAM: {
+            if (!alongOpenEdge(from, to) || (kind[to] != LOD_SEAM && kind[to] != LOD_LOCKED)) return false;
+            uint32_t from2 = otherWedge(from);
+            uint32_t to2 = NO_VERTEX;
+            if (openNext[from2] != NO_VERTEX && s.posId[openNext[from2]] == s.posId[to]) to2 = openNext[from2];
+            else if (openPrev[from2] != NO_VERTEX && s.posId[openPrev[from2]] == s.posId[to]) to2 = openPrev[from2];
+            if (to2 == NO_VERTEX) return false;
+            c.from2 = from2;
+            c.to2 = to2;
+            c.cost = std::max(CollapseCost(s, from, to), CollapseCost(s, from2, to2));
+            return true;
+        }
+        default:
+            return false;
+        }
+    };
+
+    std::vector<LodCollapse> candidates;
+    candidates.reserve(tris.size() / 2);
+    for (size_t t = 0; t < tris.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint32_t a = tris[t + k], b = tris[t + (k + 1) % 3];
+            if (a > b && openNext[a] != b) continue; // interior edges are seen twice
+            LodCollapse ab, ba;
+            bool okAB = tryCollapse(a, b, ab);
+            bool okBA = tryCollapse(b, a, ba);
+            if (okAB && (!okBA || ab.cost <= ba.cost)) candidates.push_back(ab);
+            else if (okBA) candidates.push_back(ba);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const LodCollapse& x, const LodCollapse& y) {
+        return x.cost < y.cost || (x.cost == y.cost && x.from < y.from);
+    });
+
+    std::vector<uint32_t> remap(vertexCount);
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::vector<char> locked(vertexCount, 0);
+    auto lockRing = [&](uint32_t v) {
+        for (uint32_t a = offsets[v]; a < offsets[v + 1]; ++a) {
+            const unsigned int* tri = &tris[adjacency[a] * 3];
+            locked[tri[0]] = locked[tri[1]] = locked[tri[2]] = 1;
+        }
+    };
+    auto removedTriangles = [&](uint32_t from, uint32_t to) {
+        size_t removed = 0;
+        for (uint32_t a = offsets[from]; a < offsets[from + 1]; ++a) {
+            const unsigned int* tri = &tris[adjacency[a] * 3];
+            removed += (tri[0] == to || tri[1] == to || tri[2] == to) ? 1 : 0;
+        }
+        return removed;
+    };
+
+    size_t collapses = 0;
+    for (const LodCollapse& c : candidates) {
+        if (triCount <= targetTriangles) break;
+        bool seam = c.from2 != NO_VERTEX;
+        if (locked[c.from] || locked[c.to]) continue;
+        if (seam && (locked[c.from2] || locked[c.to2])) continue;
+        if (CollapseFlips(s, offsets, adjacency, c.from, c.to)) continue;
+        if (seam && CollapseFlips(s, offsets, adjacency, c.from2, c.to2)) continue;
+
+        remap[c.from] = c.to;
+        triCount -= removedTriangles(c.from, c.to);
+        lockRing(c.from);
+        if (seam) {
+            remap[c.from2] = c.to2;
+            triCount -= removedTriangles(c.from2, c.to2);
+            lockRing(c.from2);
+        }
+        if (s.posId[c.from] != s.posId[c.to])
+            s.quadrics[s.posId[c.to]].add(s.quadrics[s.posId[c.from]]);
+        s.maxCost = std::max(s.maxCost, static_cast<double>(c.cost));
+        ++collapses;
+    }
+
+    // Targets were locked, so one remap hop is enough; drop the triangles that collapsed
+    size_t write = 0;
+    for (size_t t = 0; t < tris.size(); t += 3) {
+        unsigned int a = remap[tris[t]], b = remap[tris[t + 1]], c = remap[tris[t + 2]];
+        if (s.posId[a] == s.posId[b] || s.posId[b] == s.posId[c] || s.posId[a] == s.posId[c]) continue;
+        tris[write++] = a;
+        tris[write++] = b;
+        tris[write++] = c;
+    }
+    tris.resize(write);
+    return collapses;
+}
+
+void BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                   std::vector<unsigned int>& chain, std::vector<MeshLod>& lods, const LodChainSettings& settings) {
+    chain = indices;
+    lods.assign(1, MeshLod());
+    lods[0].indexCount = static_cast<uint32_t>(indices.size());
+    if (indices.size() / 3 <= settings.minTriangles || vertices.empty()) return;
+
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    for (const Vertex& v : vertices) {
+        minPos = glm::min(minPos, v.position);
+        maxPos = glm::max(maxPos, v.position);
+    }
+    const float errorLimit = settings.maxError * 0.5f * glm::length(maxPos - minPos);
+
+    LodSimplifier s(vertices);
+    s.triangles = indices;
+    BuildPositionIds(vertices, s.posId);
+    InitQuadrics(s);
+
+    size_t lastTriangles = indices.size() / 3;
+    while (static_cast<int>(lods.size()) < settings.maxLevels && lastTriangles > settings.minTriangles) {
+        size_t target = std::max(static_cast<size_t>(lastTriangles * settings.reduction), settings.minTriangles);
+        bool stuck = false;
+        while (s.triangles.size() / 3 > target && !stuck)
+            stuck = CollapsePass(s, target) == 0;
+
+        // Not worth a level (and nothing more to gain) when simplification has stalled,
+        // or when what is left (locked corners, UV fans) could only go by wrecking the shape
+        size_t triangles = s.triangles.size() / 3;
+        float error = static_cast<float>(std::sqrt(s.maxCost));
+        if (triangles == 0 || triangles > lastTriangles * 0.9 || error > errorLimit) break;
+
+        std::vector<unsigned int> level = s.triangles;
+        OptimizeVertexCache(level, vertices.size());
+
+        MeshLod lod;
+        lod.indexOffset = static_cast<uint32_t>(chain.size());
+        lod.indexCount = static_cast<uint32_t>(level.size());
+        lod.error = error;
+        chain.insert(chain.end(), level.begin(), level.end());
+        lods.push_back(lod);
+
+        lastTriangles = triangles;
+        if (stuck) break;
+    }
+}
+
+int SelectLod(const std::vector<MeshLod>& lods, int current, float pixelsPerUnit, float maxPixelError, float hysteresis) {
+    int best = 0;
+    for (int i = 1; i < static_cast<int>(lods.size()); ++i) {
+        float budget = i > current ? maxPixelError * (1.0f - hysteresis) : maxPixelError;
+        if (lods[i].error * pixelsPerUnit > budget) break; // errors only grow along the chain
+        best = i;
+    }
+    return best;
+}
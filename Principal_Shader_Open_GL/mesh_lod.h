@@ -0,0 +1,45 @@
+// mesh_lod.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Mesh LOD chain
+// ─────
+// Quadric error metric simplification (Garland & Heckbert) restricted to
+// collapsing a vertex onto one of its neighbours, so every LOD indexes the
+// same vertex buffer and a LOD is just a range of one shared index buffer.
+//   - UV seams and normal splits (vertices sharing a position) only collapse
+//     along the seam, with all wedges moving together, so texture charts
+//     stay closed
+//   - open borders are held in place by extra constraint planes
+//   - normal differences add to the cost, so creases go last
+// LODs are snapshots of a single collapse sequence, which makes the error
+// monotonic across the chain.
+struct MeshLod {
+    uint32_t indexOffset = 0; // first index in the shared index buffer
+    uint32_t indexCount = 0;
+    float error = 0.0f;       // object-space deviation from LOD 0 (RMS distance to the original planes)
+    uint32_t meshletOffset = 0; // clusters covering this level, see meshlets.h (count 0: none built)
+    uint32_t meshletCount = 0;
+};
+
+struct LodChainSettings {
+    float reduction = 0.5f;    // triangle ratio between consecutive levels
+    size_t minTriangles = 256; // stop once a level is this small
+    int maxLevels = 8;         // including LOD 0
+    float maxError = 0.05f;    // relative to the bounding radius; coarser levels are dropped
+};
+
+// `chain` receives LOD 0 (a copy of `indices`) followed by each simplified level
+void BuildLodChain(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                   std::vector<unsigned int>& chain, std::vector<MeshLod>& lods,
+                   const LodChainSettings& settings = LodChainSettings());
+
+// Coarsest level whose error, projected at `pixelsPerUnit`, stays under `maxPixelError`.
+// Switching to a coarser level needs (1 - hysteresis) of the budget, so the choice
+// doesn't flicker when the camera sits on a threshold.
+int SelectLod(const std::vector<MeshLod>& lods, int current, float pixelsPerUnit,
+              float maxPixelError, float hysteresis = 0.25f);
@@ -0,0 +1,337 @@
+// mesh_optimize.cpp
+#include "mesh_optimize.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Vertex -> triangle adjacency in CSR form
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets;   // vertexCount + 1
+    std::vector<uint32_t> triangles; // triangles using each vertex, in index order
+};
+
+static TriangleAdjacency BuildAdjacency(const std::vector<unsigned int>& indices, size_t vertexCount) {
+    TriangleAdjacency adj;
+    adj.offsets.assign(vertexCount + 1, 0);
+    for (unsigned int v : indices) ++adj.offsets[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v) adj.offsets[v + 1] += adj.offsets[v];
+
+    adj.triangles.resize(indices.size());
+    std::vector<uint32_t> cursor(adj.offsets.begin(), adj.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adj.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    return adj;
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    if (indices.empty()) return stats;
+
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    std::vector<char> used(vertexCount, 0);
+    unsigned int timestamp = cacheSize + 1;
+    size_t misses = 0, unique = 0;
+
+    for (unsigned int v : indices) {
+        if (timestamp - loadedAt[v] > cacheSize) {
+            loadedAt[v] = timestamp++;
+            ++misses;
+        }
+        if (!used[v]) {
+            used[v] = 1;
+            ++unique;
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = unique ? static_cast<float>(misses) / static_cast<float>(unique) : 0.0f;
+    return stats;
+}
+
+std::vector<size_t> OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize) {
+    std::vector<size_t> clusters;
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0) return clusters;
+
+    TriangleAdjacency adj = BuildAdjacency(indices, vertexCount);
+
+    std::vector<uint32_t> live(vertexCount);     // triangles not yet emitted, per vertex
+    for (size_t v = 0; v < vertexCount; ++v) live[v] = adj.offsets[v + 1] - adj.offsets[v];
+
+    std::vector<unsigned int> cachedAt(vertexCount, 0);
+    std::vector<char> emitted(triCount, 0);
+    std::vector<uint32_t> deadEnd;               // recently used vertices, for cheap restarts
+    std::vector<uint32_t> candidates;
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    deadEnd.reserve(indices.size());
+
+    unsigned int timestamp = cacheSize + 1;
+    size_t cursor = 0;                           // scan position for restarts once deadEnd runs dry
+    int64_t fanning = 0;
+    while (fanning < static_cast<int64_t>(vertexCount) && live[fanning] == 0) ++fanning;
+    clusters.push_back(0);
+
+    while (fanning >= 0 && fanning < static_cast<int64_t>(vertexCount)) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t a = adj.offsets[fanning]; a < adj.offsets[fanning + 1]; ++a) {
+            uint32_t t = adj.triangles[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[t * 3 + k];
+                out.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (timestamp - cachedAt[v] > cacheSize) cachedAt[v] = timestamp++;
+            }
+        }
+
+        // Next fanning vertex: a neighbour that will still be in cache after
+        // its remaining triangles are emitted, preferring the oldest entry. A live
+        // neighbour that would not fit (priority 0) is not taken: that is a dead end,
+        // resolved from the dead-end stack below and starting a new cluster.
+        int64_t best = -1;
+        int bestPriority = 0;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int priority = 0;
+            if (timestamp - cachedAt[v] + 2 * live[v] <= cacheSize) priority = static_cast<int>(timestamp - cachedAt[v]);
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        if (best < 0) {
+            // Dead end: restart from recently touched geometry, else the next unfinished vertex
+            while (!deadEnd.empty()) {
+                uint32_t d = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[d] > 0) {
+                    best = d;
+                    break;
+                }
+            }
+            if (best < 0) {
+                while (cursor < vertexCount && live[cursor] == 0) ++cursor;
+                if (cursor < vertexCount) best = static_cast<int64_t>(cursor);
+            }
+            if (best >= 0 && out.size() / 3 > clusters.back())
+                clusters.push_back(out.size() / 3);
+        }
+        fanning = best;
+    }
+
+    indices.swap(out);
+    return clusters;
+}
+
+// Splits Tipsify clusters further wherever restarting the cache there costs less
+// than `threshold` times the cluster's own ACMR, so the sort has enough pieces
+// to work with on well-connected meshes that produce very few dead ends.
+static std::vector<size_t> SoftClusterBoundaries(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                                 const std::vector<size_t>& hard, float threshold) {
+    const size_t triCount = indices.size() / 3;
+    std::vector<size_t> soft;
+    std::vector<unsigned int> cachedAt(vertexCount, 0);
+    unsigned int timestamp = VERTEX_CACHE_SIZE + 1;
+
+    auto simulate = [&](size_t t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            unsigned int v = indices[t * 3 + k];
+            if (timestamp - cachedAt[v] > VERTEX_CACHE_SIZE) {
+                cachedAt[v] = timestamp++;
+                ++misses;
+            }
+        }
+        return misses;
+    };
+    auto flushCache = [&] { timestamp += VERTEX_CACHE_SIZE + 1; };
+
+    for (size_t c = 0; c < hard.size(); ++c) {
+        size_t begin = hard[c];
+        size_t end = c + 1 < hard.size() ? hard[c + 1] : triCount;
+
+        flushCache();
+        size_t clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t) clusterMisses += simulate(t);
+        float target = static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+        flushCache();
+        soft.push_back(begin);
+        size_t start = begin, misses = 0;
+        for (size_t t = begin; t < end; ++t) {
+            misses += simulate(t);
+            size_t count = t + 1 - start;
+            if (t + 1 < end && static_cast<float>(misses) <= threshold * target * count) {
+                soft.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                flushCache();
+            }
+        }
+    }
+    return soft;
+}
+
+size_t OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& hardClusters) {
+    const size_t triCount = indices.size() / 3;
+    if (triCount == 0 || hardClusters.empty()) return 0;
+
+    std::vector<size_t> clusters = SoftClusterBoundaries(indices, vertices.size(), hardClusters, 1.05f);
+
+    // Area-weighted centroid and normal per cluster
+    struct ClusterInfo {
+        glm::vec3 centroid = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);
+        float area = 0.0f;
+        float score = 0.0f;
+    };
+    std::vector<ClusterInfo> info(clusters.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triCount;
+        ClusterInfo& ci = info[c];
+        for (size_t t = clusters[c]; t < end; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0); // length = 2 * area
+            float area = glm::length(n);
+            ci.normal += n;
+            ci.centroid += (p0 + p1 + p2) * (area / 3.0f);
+            ci.area += area;
+        }
+        meshCentroid += ci.centroid;
+        meshArea += ci.area;
+        if (ci.area > 0.0f) ci.centroid = ci.centroid / ci.area;
+    }
+    if (meshArea > 0.0f) meshCentroid = meshCentroid / meshArea;
+
+    // Clusters far out along their own normal occlude the rest: draw them first
+    for (ClusterInfo& ci : info) {
+        float len = glm::length(ci.normal);
+        ci.score = len > 0.0f ? glm::dot(ci.centroid - meshCentroid, ci.normal / len) : 0.0f;
+    }
+
+    std::vector<size_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return info[a].score > info[b].score; });
+
+    std::vector<unsigned int> out;
+    out.reserve(indices.size());
+    for (size_t c : order) {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triCount;
+        out.insert(out.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    indices.swap(out);
+    return clusters.size();
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    const unsigned int UNUSED = 0xFFFFFFFFu;
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<Vertex> out;
+    out.reserve(vertices.size());
+
+    // First-use order; vertices no triangle references are dropped
+    for (unsigned int& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<unsigned int>(out.size());
+            out.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(out);
+}
+
+float AnalyzeOverdraw(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int resolution) {
+    if (vertices.empty() || indices.size() < 3) return 0.0f;
+
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    for (const Vertex& v : vertices) {
+        minPos = glm::min(minPos, v.position);
+        maxPos = glm::max(maxPos, v.position);
+    }
+    glm::vec3 size = maxPos - minPos;
+    float extent = std::max(size.x, std::max(size.y, size.z));
+    if (extent <= 0.0f) return 0.0f;
+    const float scale = (resolution - 1) / extent;
+
+    std::vector<float> depth(static_cast<size_t>(resolution) * resolution);
+    size_t shaded = 0, covered = 0;
+
+    // Orthographic views down +-X, +-Y, +-Z with a LESS depth test, no culling (as in main.cpp)
+    for (int axis = 0; axis < 3; ++axis) {
+        int ua = (axis + 1) % 3, va = (axis + 2) % 3;
+        for (float dir : { 1.0f, -1.0f }) {
+            std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                float x[3], y[3], z[3];
+                for (int k = 0; k < 3; ++k) {
+                    const glm::vec3& p = vertices[indices[i + k]].position;
+                    x[k] = (p[ua] - minPos[ua]) * scale;
+                    y[k] = (p[va] - minPos[va]) * scale;
+                    z[k] = p[axis] * dir;
+                }
+
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (area == 0.0f) continue;
+                float invArea = 1.0f / area;
+
+                int x0 = std::max(0, static_cast<int>(std::floor(std::min(x[0], std::min(x[1], x[2])))));
+                int x1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(x[0], std::max(x[1], x[2])))));
+                int y0 = std::max(0, static_cast<int>(std::floor(std::min(y[0], std::min(y[1], y[2])))));
+                int y1 = std::min(resolution - 1, static_cast<int>(std::ceil(std::max(y[0], std::max(y[1], y[2])))));
+
+                for (int py = y0; py <= y1; ++py) {
+                    for (int px = x0; px <= x1; ++px) {
+                        float sx = px + 0.5f, sy = py + 0.5f;
+                        float w0 = ((x[1] - sx) * (y[2] - sy) - (x[2] - sx) * (y[1] - sy)) * invArea;
+                        float w1 = ((x[2] - sx) * (y[0] - sy) - (x[0] - sx) * (y[2] - sy)) * invArea;
+                        float w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                        float zf = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                        float& d = depth[static_cast<size_t>(py) * resolution + px];
+                        if (zf < d) {
+                            d = zf;
+                            ++shaded;
+                        }
+                    }
+                }
+            }
+
+            for (float d : depth)
+                if (d != FLT_MAX) ++covered;
+        }
+    }
+    return covered ? static_cast<float>(shaded) / static_cast<float>(covered) : 0.0f;
+}
+
+MeshOptimizeReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool measureOverdraw) {
+    MeshOptimizeReport report;
+    report.before = AnalyzeVertexCache(indices, vertices.size());
+    if (measureOverdraw) report.overdrawBefore = AnalyzeOverdraw(vertices, indices);
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<size_t> clusters = OptimizeVertexCache(indices, vertices.size());
+    report.clusters = OptimizeOverdraw(indices, vertices, clusters);
+    OptimizeVertexFetch(vertices, indices);
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    report.after = AnalyzeVertexCache(indices, vertices.size());
+    if (measureOverdraw) report.overdrawAfter = AnalyzeOverdraw(vertices, indices);
+    return report;
+}
@@ -0,0 +1,46 @@
+// mesh_optimize.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Index/vertex order optimization
+// ─────
+// Runs between index building and upload. Nothing here changes the rendered
+// image, only the order the GPU sees triangles and vertices in:
+//   1. Tipsify (Sander et al. 2007) reorders triangles for post-transform
+//      vertex cache hits; its dead-end restarts split the mesh into clusters
+//   2. clusters are sorted outside-in so the expensive basic.frag runs less
+//      often on occluded surfaces (overdraw)
+//   3. vertices are renumbered in first-use order for pre-transform fetch locality
+// All metrics are computed on the CPU so the gain can be checked offline.
+
+// ACMR = transformed vertices per triangle (lower is better, ~0.5 is ideal)
+// ATVR = transformed vertices per unique vertex (1.0 is ideal)
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    float overdrawBefore = 0.0f; // shaded fragments per covered pixel, 6 axis views
+    float overdrawAfter = 0.0f;
+    size_t clusters = 0;
+    double seconds = 0.0;        // optimization passes only, not the analysis
+};
+
+const unsigned VERTEX_CACHE_SIZE = 16; // FIFO size used for simulation and Tipsify
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+float AnalyzeOverdraw(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int resolution = 256);
+
+// Returns the cluster start offsets (in triangles) that Tipsify produced
+std::vector<size_t> OptimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, unsigned cacheSize = VERTEX_CACHE_SIZE);
+size_t OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusters); // returns clusters sorted
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// All three passes; `measureOverdraw` adds the (slower) raster-based overdraw metric
+MeshOptimizeReport OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool measureOverdraw = false);
@@ -1,5 +1,11 @@
 // mesh_utils.cpp
 #include "mesh_utils.h"
+#include "mesh_cache.h"
+#include "vertex_dedup.h"
+#include "obj_parser.h"
+#include "tangents.h"
+#include "mesh_optimize.h"
+#include "job_system.h"
 #include "External/tinyobjloader/tiny_obj_loader.h"
 #include <glad/glad.h>
 #include <cstddef>
@@ -8,33 +14,22 @@
 #include <string>
 #include <iostream>
 #include <filesystem>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cfloat>
+
+
+Mesh createMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, VertexFormat format) {
+    return createMesh(vertices.data(), vertices.size(), indices.data(), indices.size(), format);
+}
 
-
-Mesh createMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
-    Mesh mesh;
-    mesh.vertexCount = vertices.size();
-    mesh.indexCount = indices.size();
-    
-    glGenVertexArrays(1, &mesh.VAO); // generate 1 VAO
-    glGenBuffers(1, &mesh.VBO); // create 1 buffer ID
-    glGenBuffers(1, &mesh.EBO); 
-
-
-    // VAO
-    glBindVertexArray(mesh.VAO); // bind it (make it active)
-    
-    // VBO
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO); // bind the buffer (target = array buffer)
-    glBufferData(GL_ARRAY_BUFFER, 
-        vertices.size() * sizeof(Vertex), 
-        vertices.data(), GL_STATIC_DRAW);
-    
-    // EBO
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO); // bind the buffer (target = array buffer)
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            indices.size() * sizeof(unsigned int),   // not sizeof(Vertex)
-            indices.data(), GL_STATIC_DRAW);
-
+// Float layout: one attribute per Vertex member, exactly as stored on the CPU
+static void SetupFloatAttributes() {
     // position attribute (location = 0)
     glVertexAttribPointer(
         0,                                  // index (matches "layout (location = 0)" in shader)
@@ -68,81 +63,136 @@ Mesh createMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned
     );
     glEnableVertexAttribArray(2); // enable that vertex attribute
 
-    // tangent attribute (location = 3)
+    // tangent attribute (location = 3): xyz = tangent, w = bitangent sign
     glVertexAttribPointer(
         3,                                  // index (matches "layout (location = 3)" in shader)
-        3,                                  // size 
+        4,                                  // size 
         GL_FLOAT,                           // type
         GL_FALSE,                           // normalize?
         sizeof(Vertex),                     // stride (size of 1 Vertex)
         (void*)offsetof(Vertex, tangent)   // offset (start at beginning of array)
     );
     glEnableVertexAttribArray(3); // enable that vertex attribute
+}
 
-    glBindVertexArray(0); // unbinds VAO to prevent accidntal modification elswhere
-    return mesh;
+// Packed layout: same locations, the GL normalizes everything to [0,1] / [-1,1] on fetch
+static void SetupPackedAttributes() {
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoord));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, tangent));
+    glEnableVertexAttribArray(3);
 }
 
-void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
-    // Loop through each triangle (3 indices at a time)
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        // fetch triangle vertex data
-        Vertex& v0 = vertices[indices[i]];
-        Vertex& v1 = vertices[indices[i + 1]];
-        Vertex& v2 = vertices[indices[i + 2]];
-
-        // World Positions
-        glm::vec3 pos0 = v0.position;
-        glm::vec3 pos1 = v1.position;
-        glm::vec3 pos2 = v2.position;
-
-        // Texture coordinates
-        glm::vec2 uv0 = v0.texCoord;
-        glm::vec2 uv1 = v1.texCoord;
-        glm::vec2 uv2 = v2.texCoord;
-
-        // Vector Edges of the triangle (in model space)
-        glm::vec3 edge1 = pos1 - pos0;
-        glm::vec3 edge2 = pos2 - pos0;
-
-        // UV deltas (in texture space) - UV space edges
-        glm::vec2 deltaUV1 = uv1 - uv0;
-        glm::vec2 deltaUV2 = uv2 - uv0;
-
-        float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-        glm::vec3 tangent;
-        tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-        tangent = glm::normalize(tangent);
-
-        // Accumulate tangent per vertex (in case of sharing)
-        v0.tangent += tangent;
-        v1.tangent += tangent;
-        v2.tangent += tangent;
+// EBO contents: 16-bit indices whenever the vertex count allows, half the index bandwidth.
+// `indexSize` is sizeof(uint16_t) for indices that are already narrowed (a mesh cache).
+// Expects the mesh VAO to be bound; returns the uploaded size in bytes.
+static size_t UploadIndices(Mesh& mesh, const void* indices, size_t indexCount, size_t indexSize = sizeof(unsigned int)) {
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO); // bind the buffer (target = array buffer)
+    std::vector<uint16_t> indices16;
+    if (indexSize == sizeof(unsigned int) && CanUse16BitIndices(static_cast<size_t>(mesh.vertexCount))) {
+        PackIndices16(static_cast<const unsigned int*>(indices), indexCount, indices16);
+        indices = indices16.data();
+        indexSize = sizeof(uint16_t);
     }
+    mesh.indexType = indexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+            indexCount * indexSize,   // not sizeof(Vertex)
+            indices, GL_STATIC_DRAW);
+    TrackGpuMemory(GpuMemoryKind::MeshBuffer, mesh.EBO, indexCount * indexSize, "mesh indices");
+    return indexCount * indexSize;
+}
 
-    // Normalize the accumulated tangents
-    for (Vertex& v : vertices) {
-        v.tangent = glm::normalize(v.tangent);
-    }
+// Everything createMesh computes before touching GL, so a loader thread can do it off the render thread
+struct PreparedVertices {
+    VertexFormat format = VERTEX_FORMAT_FLOAT;
+    std::vector<PackedVertex> packed; // VERTEX_FORMAT_PACKED only
+    VertexDequantization dequant;
+    VertexPackingReport report;
+    bool measured = false; // report errors are valid (packed here, not read from a cache)
+    float radius = 0.0f;
+};
+
+static void PrepareVertices(const Vertex* vertices, size_t vertexCount, VertexFormat format, PreparedVertices& prepared) {
+    prepared.format = format;
+    prepared.radius = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i)
+        prepared.radius = std::max(prepared.radius, glm::length(vertices[i].position));
+
+    prepared.report = VertexPackingReport();
+    prepared.report.vertexBytesBefore = prepared.report.vertexBytesAfter = vertexCount * sizeof(Vertex);
+    prepared.measured = true;
+    if (format == VERTEX_FORMAT_PACKED)
+        PackVertices(vertices, vertexCount, prepared.packed, prepared.dequant, &prepared.report);
+}
+
+// GL half of createMesh. `vertices` is in prepared.format's layout and `indexSize` as for UploadIndices.
+static Mesh UploadMesh(const void* vertices, size_t vertexCount, const void* indices, size_t indexCount,
+                       size_t indexSize, PreparedVertices& prepared) {
+    Mesh mesh;
+    mesh.vertexCount = static_cast<int>(vertexCount);
+    mesh.indexCount = static_cast<int>(indexCount);
+    mesh.format = prepared.format;
+    mesh.dequant = prepared.dequant;
+    mesh.radius = prepared.radius;
+    
+    glGenVertexArrays(1, &mesh.VAO); // generate 1 VAO
+    glGenBuffers(1, &mesh.VBO); // create 1 buffer ID
+    glGenBuffers(1, &mesh.EBO); 
+
+
+    // VAO
+    glBindVertexArray(mesh.VAO); // bind it (make it active)
+    
+    // VBO
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO); // bind the buffer (target = array buffer)
+    glBufferData(GL_ARRAY_BUFFER, 
+        prepared.report.vertexBytesAfter, 
+        vertices, GL_STATIC_DRAW);
+    TrackGpuMemory(GpuMemoryKind::MeshBuffer, mesh.VBO, prepared.report.vertexBytesAfter, "mesh vertices");
+    
+    // EBO
+    prepared.report.indexBytesBefore = indexCount * sizeof(unsigned int);
+    prepared.report.indexBytesAfter = UploadIndices(mesh, indices, indexCount, indexSize);
+
+    if (prepared.format == VERTEX_FORMAT_PACKED)
+        SetupPackedAttributes();
+    else
+        SetupFloatAttributes();
+
+    // Only worth a line for real assets, not the built-in cube/quad; a cache hit was reported when it was packed
+    if (vertexCount > 1024 && prepared.measured)
+        PrintVertexPackingReport(prepared.report);
+
+    glBindVertexArray(0); // unbinds VAO to prevent accidntal modification elswhere
+    return mesh;
+}
+
+// Pointer form lets callers upload straight from memory they don't own (e.g. a mapped mesh cache)
+Mesh createMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, VertexFormat format) {
+    PreparedVertices prepared;
+    PrepareVertices(vertices, vertexCount, format, prepared);
+    const void* uploaded = format == VERTEX_FORMAT_PACKED ? static_cast<const void*>(prepared.packed.data()) : vertices;
+    return UploadMesh(uploaded, vertexCount, indices, indexCount, sizeof(unsigned int), prepared);
 }
 
 Mesh createQuad() {
     //each Vertex has vec of position, normal, texCoord and tangent 
     std::vector<Vertex> vertices = {
         // Bottom-left
-        { glm::vec3(-1.0f, -1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
+        { glm::vec3(-1.0f, -1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
 
         // Bottom-right
-        { glm::vec3( 1.0f, -1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
+        { glm::vec3( 1.0f, -1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
 
         // Top-left
-        { glm::vec3(-1.0f,  1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3(-1.0f,  1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Top-right
-        { glm::vec3( 1.0f,  1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3( 1.0f,  1.0f, 0.0f),  glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
     };
 
     std::vector<unsigned int> indices = {
@@ -206,6 +256,7 @@ void renderCube() {
         glGenBuffers(1, &cubeVBO);
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        TrackGpuMemory(GpuMemoryKind::MeshBuffer, cubeVBO, sizeof(vertices), "skybox cube");
         glBindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
@@ -220,40 +271,40 @@ Mesh createCube() {
     // 24 vertices total (4 per face, 6 faces)
     std::vector<Vertex> vertices = {
         // Front face (Z+)
-        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Back face (Z-)
-        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Left face (X-)
-        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Right face (X+)
-        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Bottom face (Y-)
-        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) },
+        { glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) },
 
         // Top face (Y+)
-        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec3(0.0f) },
-        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec3(0.0f) },
-        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec3(0.0f) }
+        { glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f,  0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec4(0.0f) },
+        { glm::vec3( 0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec4(0.0f) },
+        { glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.0f, 1.0f), glm::vec4(0.0f) }
     };
 
     std::vector<unsigned int> indices = {
@@ -275,61 +326,87 @@ Mesh createCube() {
     return createMesh(vertices, indices);
 }
 
-Mesh loadObjModel(const std::string& path) {
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
+static Vertex MakeObjVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& idx) {
+    Vertex vert;
+    vert.position = {
+        attrib.vertices[3 * idx.vertex_index + 0],
+        attrib.vertices[3 * idx.vertex_index + 1],
+        attrib.vertices[3 * idx.vertex_index + 2]
+    };
 
-    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+    vert.normal = glm::vec3(0.0f);
+    if (idx.normal_index >= 0 && !attrib.normals.empty()) {
+        vert.normal = {
+            attrib.normals[3 * idx.normal_index + 0],
+            attrib.normals[3 * idx.normal_index + 1],
+            attrib.normals[3 * idx.normal_index + 2]
+        };
+    }
 
-    if (!warn.empty()) std::cout << "tinyobj warning: " << warn << std::endl;
-    if (!err.empty()) std::cerr << "tinyobj error: " << err << std::endl;
-    if (!success) {
-        std::cerr << "Failed to load OBJ: " << path << std::endl;
-        return createCube(); // fallback
+    vert.texCoord = glm::vec2(0.0f);
+    if (idx.texcoord_index >= 0 && !attrib.texcoords.empty()) {
+        vert.texCoord = {
+            attrib.texcoords[2 * idx.texcoord_index + 0],
+            attrib.texcoords[2 * idx.texcoord_index + 1]
+        };
     }
 
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    vert.tangent = glm::vec4(0.0f); // to be calculated
+    return vert;
+}
 
-    std::unordered_map<std::string, unsigned int> uniqueVertexMap;
+static size_t CountObjCorners(const std::vector<tinyobj::shape_t>& shapes) {
+    size_t corners = 0;
+    for (const auto& shape : shapes)
+        corners += shape.mesh.indices.size();
+    return corners;
+}
+
+static void DedupObjCorners(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                            std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    // Every corner produces one index; unique vertices are usually close to the position count
+    size_t corners = CountObjCorners(shapes);
+    size_t expectedUnique = std::max(attrib.vertices.size() / 3, size_t(1));
+    indices.reserve(corners);
+    vertices.reserve(expectedUnique);
+
+    CornerHashTable table(expectedUnique);
 
     for (const auto& shape : shapes) {
         size_t index_offset = 0;
         for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++) {
             int fv = shape.mesh.num_face_vertices[f];
             for (int v = 0; v < fv; v++) {
-                tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
-
-                glm::vec3 pos = {
-                    attrib.vertices[3 * idx.vertex_index + 0],
-                    attrib.vertices[3 * idx.vertex_index + 1],
-                    attrib.vertices[3 * idx.vertex_index + 2]
+                const tinyobj::index_t& idx = shape.mesh.indices[index_offset + v];
+                CornerKey key = {
+                    static_cast<uint32_t>(idx.vertex_index + 1),
+                    static_cast<uint32_t>(idx.normal_index + 1),
+                    static_cast<uint32_t>(idx.texcoord_index + 1)
                 };
 
-                glm::vec3 normal = glm::vec3(0.0f);
-                if (idx.normal_index >= 0 && !attrib.normals.empty()) {
-                    normal = {
-                        attrib.normals[3 * idx.normal_index + 0],
-                        attrib.normals[3 * idx.normal_index + 1],
-                        attrib.normals[3 * idx.normal_index + 2]
-                    };
-                }
+                bool inserted;
+                uint32_t vertex = table.findOrInsert(key, static_cast<uint32_t>(vertices.size()), inserted);
+                if (inserted)
+                    vertices.push_back(MakeObjVertex(attrib, idx));
+                indices.push_back(vertex);
+            }
+            index_offset += fv;
+        }
+    }
+}
 
-                glm::vec2 uv = glm::vec2(0.0f);
-                if (idx.texcoord_index >= 0 && !attrib.texcoords.empty()) {
-                    uv = {
-                        attrib.texcoords[2 * idx.texcoord_index + 0],
-                        attrib.texcoords[2 * idx.texcoord_index + 1]
-                    };
-                }
+// Previous implementation (string keys in an unordered_map), kept only as the
+// "before" side of the timing mode below.
+static void DedupObjCornersStringKeyed(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes,
+                                       std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    std::unordered_map<std::string, unsigned int> uniqueVertexMap;
 
-                Vertex vert;
-                vert.position = pos;
-                vert.normal = normal;
-                vert.texCoord = uv;
-                vert.tangent = glm::vec3(0.0f); // to be calculated
+    for (const auto& shape : shapes) {
+        size_t index_offset = 0;
+        for (size_t f = 0; f < shape.mesh.num_face_vertices.size(); f++) {
+            int fv = shape.mesh.num_face_vertices[f];
+            for (int v = 0; v < fv; v++) {
+                tinyobj::index_t idx = shape.mesh.indices[index_offset + v];
 
                 std::string key = std::to_string(idx.vertex_index) + "/" +
                                   std::to_string(idx.normal_index) + "/" +
@@ -337,7 +414,7 @@ Mesh loadObjModel(const std::string& path) {
 
                 if (uniqueVertexMap.count(key) == 0) {
                     uniqueVertexMap[key] = static_cast<unsigned int>(vertices.size());
-                    vertices.push_back(vert);
+                    vertices.push_back(MakeObjVertex(attrib, idx));
                 }
 
                 indices.push_back(uniqueVertexMap[key]);
@@ -345,21 +422,381 @@ Mesh loadObjModel(const std::string& path) {
             index_offset += fv;
         }
     }
+}
 
-    ComputeTangents(vertices, indices);
+// Timing mode: set the environment variable PBR_MESH_TIMING=1 to print per-stage
+// timings for every OBJ load. On the tinyobjloader path it also runs both dedup
+// implementations and prints corners per second for each.
+static bool MeshTimingEnabled() {
+    const char* env = std::getenv("PBR_MESH_TIMING");
+    return env && env[0] != '\0' && env[0] != '0';
+}
+
+// Imported models use the packed layout; PBR_VERTEX_FORMAT=float restores full floats for comparison
+static VertexFormat ObjVertexFormat() {
+    const char* env = std::getenv("PBR_VERTEX_FORMAT");
+    return env && std::string(env) == "float" ? VERTEX_FORMAT_FLOAT : VERTEX_FORMAT_PACKED;
+}
+
+// Imported models are reordered by OptimizeMesh; PBR_MESH_OPTIMIZE=0 keeps the OBJ's own order for comparison
+static bool MeshOptimizeEnabled() {
+    const char* env = std::getenv("PBR_MESH_OPTIMIZE");
+    return !env || env[0] != '0';
+}
+
+static void ReportDedupTiming(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes) {
+    using Clock = std::chrono::steady_clock;
+    const double corners = static_cast<double>(CountObjCorners(shapes));
+
+    std::vector<Vertex> vertsBefore, vertsAfter;
+    std::vector<unsigned int> idxBefore, idxAfter;
+
+    auto t0 = Clock::now();
+    DedupObjCornersStringKeyed(attrib, shapes, vertsBefore, idxBefore);
+    auto t1 = Clock::now();
+    DedupObjCorners(attrib, shapes, vertsAfter, idxAfter);
+    auto t2 = Clock::now();
+
+    double before = std::chrono::duration<double>(t1 - t0).count();
+    double after = std::chrono::duration<double>(t2 - t1).count();
+    std::cout << "[mesh timing] " << static_cast<size_t>(corners) << " corners -> "
+              << vertsAfter.size() << " unique vertices\n"
+              << "[mesh timing]   string-keyed map : " << before * 1000.0 << " ms ("
+              << (before > 0.0 ? corners / before / 1e6 : 0.0) << " M corners/s)\n"
+              << "[mesh timing]   packed-key table : " << after * 1000.0 << " ms ("
+              << (after > 0.0 ? corners / after / 1e6 : 0.0) << " M corners/s)\n"
+              << "[mesh timing]   speedup          : " << (after > 0.0 ? before / after : 0.0) << "x" << std::endl;
+
+    if (vertsBefore.size() != vertsAfter.size() || idxBefore != idxAfter)
+        std::cerr << "[mesh timing] WARNING: dedup paths disagree" << std::endl;
+}
+
+static void ReportObjParseStats(const ObjParseStats& stats) {
+    double total = stats.parseSeconds + stats.mergeSeconds + stats.assembleSeconds;
+    std::cout << "[mesh timing] parallel OBJ parse: " << stats.bytes / (1024.0 * 1024.0) << " MB, "
+              << stats.chunks << " chunks on " << stats.threads << " threads\n"
+              << "[mesh timing]   parse    : " << stats.parseSeconds * 1000.0 << " ms\n"
+              << "[mesh timing]   merge    : " << stats.mergeSeconds * 1000.0 << " ms\n"
+              << "[mesh timing]   assemble : " << stats.assembleSeconds * 1000.0 << " ms ("
+              << (stats.assembleSeconds > 0.0 ? stats.corners / stats.assembleSeconds / 1e6 : 0.0) << " M corners/s)\n"
+              << "[mesh timing]   total    : " << total * 1000.0 << " ms ("
+              << (total > 0.0 ? stats.bytes / total / (1024.0 * 1024.0) : 0.0) << " MB/s)" << std::endl;
+}
+
+// Single-threaded tinyobjloader path; used when the parallel parser rejects a file
+static bool LoadObjTinyObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, err;
+
+    bool success = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str());
+
+    if (!warn.empty()) std::cout << "tinyobj warning: " << warn << std::endl;
+    if (!err.empty()) std::cerr << "tinyobj error: " << err << std::endl;
+    if (!success) return false;
+
+    if (MeshTimingEnabled())
+        ReportDedupTiming(attrib, shapes);
+
+    DedupObjCorners(attrib, shapes, vertices, indices);
+    return true;
+}
 
-    // Calculate bounding box center
-    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
-    for (const auto& v : vertices) {
-        minPos = glm::min(minPos, v.position);
-        maxPos = glm::max(maxPos, v.position);
+// Result of the background LOD job; the GL upload happens on the render thread in updateMeshLods
+struct MeshLodBuild {
+    std::atomic<bool> done{ false };
+    std::vector<unsigned int> chain;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    double seconds = 0.0;
+    std::string error; // what the job threw; reported and dropped by updateMeshLods
+};
+
+// The LOD job's input: the float mesh it simplifies and the upload-ready vertices the cache stores
+struct MeshLodInput {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    PreparedVertices prepared;
+    bool optimized = true;
+};
+
+// The LOD job: simplify, cluster, then write the cache
+static void BuildLods(MeshLodBuild& build, const MeshLodInput& input, const std::string& path) {
+    auto t0 = std::chrono::steady_clock::now();
+    BuildLodChain(input.vertices, input.indices, build.chain, build.lods);
+    for (MeshLod& lod : build.lods) {
+        lod.meshletOffset = static_cast<uint32_t>(build.meshlets.size());
+        lod.meshletCount = static_cast<uint32_t>(BuildMeshlets(input.vertices, build.chain.data() + lod.indexOffset,
+                                                               lod.indexCount, lod.indexOffset, build.meshlets));
+    }
+    build.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // Cached exactly as uploaded, so a hit skips packing: the same vertex layout and index width
+    const PreparedVertices& prepared = input.prepared;
+    MeshCacheData cache;
+    cache.format = prepared.format;
+    cache.vertices = prepared.format == VERTEX_FORMAT_PACKED ? static_cast<const void*>(prepared.packed.data())
+                                                             : input.vertices.data();
+    cache.vertexCount = input.vertices.size();
+    cache.dequant = prepared.dequant;
+    cache.radius = prepared.radius;
+    cache.optimized = input.optimized;
+    std::vector<uint16_t> chain16;
+    cache.indices = build.chain.data();
+    cache.indexCount = build.chain.size();
+    if (CanUse16BitIndices(input.vertices.size())) {
+        PackIndices16(build.chain.data(), build.chain.size(), chain16);
+        cache.indices = chain16.data();
+        cache.indexSize = sizeof(uint16_t);
     }
-    glm::vec3 center = (minPos + maxPos) * 0.5f;
+    cache.lods = build.lods.data();
+    cache.lodCount = build.lods.size();
+    cache.meshlets = build.meshlets.data();
+    cache.meshletCount = build.meshlets.size();
+    WriteMeshCache(path, cache);
+}
+
+static std::shared_ptr<MeshLodBuild> StartLodBuild(const std::string& path, std::vector<Vertex> vertices, std::vector<unsigned int> indices,
+                                                   PreparedVertices prepared, bool optimized) {
+    auto build = std::make_shared<MeshLodBuild>();
+    auto input = std::make_shared<MeshLodInput>();
+    input->vertices = std::move(vertices);
+    input->indices = std::move(indices);
+    input->prepared = std::move(prepared);
+    input->optimized = optimized;
+    RunAsync([build, input, path]() {
+        build->error = CaptureJobError([&]() { BuildLods(*build, *input, path); });
+        build->done.store(true, std::memory_order_release);
+    });
+    return build;
+}
+
+// CPU side of an OBJ load. Filled by RunMeshLoad on a worker; FinishMeshLoad uploads it
+// on the GL thread.
+struct MeshLoad {
+    std::string path;
+    JobProgress progress;
+    std::atomic<bool> done{ false };
+    bool ok = false;        // the fields below are valid (written before `done`)
+    bool fromCache = false; // `cached` is valid: lods/meshlets came with it, no LOD build needed
+    bool optimized = true;  // OptimizeMesh reordered the indices (PBR_MESH_OPTIMIZE)
+    MappedFile cacheFile;   // kept open until the upload reads the arrays `cached` points to
+    MeshCacheData cached;
+    std::vector<Vertex> vertices; // parsed, on a cache miss
+    std::vector<unsigned int> indices;
+    PreparedVertices prepared;
+    double seconds = 0.0;
+    std::string error;      // what the job threw; finishObjModelLoad reports it
+};
+
+static void RunMeshLoad(MeshLoad& load) {
+    auto t0 = std::chrono::steady_clock::now();
+    JobProgress& progress = load.progress;
+    VertexFormat format = ObjVertexFormat();
+    load.optimized = MeshOptimizeEnabled();
+
+    // Reopening a model we have already processed: one mapped read, no parse
+    progress.beginStage("Reading cache", 0.05f);
+    load.fromCache = OpenMeshCache(load.path, format, load.optimized, load.cacheFile, load.cached);
+    if (!load.fromCache) {
+        load.cacheFile.close(); // the LOD build rewrites the file
+        progress.beginStage("Parsing", 0.7f);
+        ObjParseStats stats;
+        if (ParseObjParallel(load.path, load.vertices, load.indices, 0, &stats, &progress)) {
+            if (MeshTimingEnabled())
+                ReportObjParseStats(stats);
+        } else if (progress.canceled()) {
+            return;
+        } else {
+            std::cerr << "Parallel OBJ parser failed, falling back to tinyobjloader: " << load.path << std::endl;
+            if (!LoadObjTinyObj(load.path, load.vertices, load.indices)) {
+                std::cerr << "Failed to load OBJ: " << load.path << std::endl;
+                return;
+            }
+        }
 
-    // Center the mesh
-    for (auto& v : vertices) {
-        v.position -= center;
+        if (progress.canceled()) return;
+        progress.beginStage("Computing tangents", 0.8f);
+        ComputeTangents(load.vertices, load.indices);
+
+        // Calculate bounding box center
+        glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+        for (const auto& v : load.vertices) {
+            minPos = glm::min(minPos, v.position);
+            maxPos = glm::max(maxPos, v.position);
+        }
+        glm::vec3 center = (minPos + maxPos) * 0.5f;
+
+        // Center the mesh
+        for (auto& v : load.vertices) {
+            v.position -= center;
+        }
+
+        // Reorder for the post-transform cache, overdraw and fetch locality (image is unchanged)
+        if (progress.canceled()) return;
+        if (load.optimized) {
+            progress.beginStage("Optimizing", 0.95f);
+            MeshOptimizeReport opt = OptimizeMesh(load.vertices, load.indices);
+            std::cout << "Mesh optimize: ACMR " << opt.before.acmr << " -> " << opt.after.acmr
+                      << ", ATVR " << opt.before.atvr << " -> " << opt.after.atvr
+                      << " (" << opt.clusters << " clusters, " << opt.seconds * 1000.0 << " ms)" << std::endl;
+        } else {
+            VertexCacheStats stats = AnalyzeVertexCache(load.indices, load.vertices.size());
+            std::cout << "Mesh optimize: off (PBR_MESH_OPTIMIZE=0), ACMR " << stats.acmr << ", ATVR " << stats.atvr << std::endl;
+        }
     }
 
-    return createMesh(vertices, indices);
+    if (progress.canceled()) return;
+    if (load.fromCache) {
+        // Already in the upload layout
+        load.prepared.format = load.cached.format;
+        load.prepared.dequant = load.cached.dequant;
+        load.prepared.radius = load.cached.radius;
+        load.prepared.report.vertexBytesBefore = load.cached.vertexCount * sizeof(Vertex);
+        load.prepared.report.vertexBytesAfter =
+            load.cached.vertexCount * (load.cached.format == VERTEX_FORMAT_PACKED ? sizeof(PackedVertex) : sizeof(Vertex));
+    } else {
+        progress.beginStage("Packing", 1.0f);
+        PrepareVertices(load.vertices.data(), load.vertices.size(), format, load.prepared);
+    }
+    progress.report(1.0f);
+    load.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    load.ok = true;
+}
+
+// GL thread: only buffer uploads here. A fresh load then starts its LOD chain in the background.
+static Mesh FinishMeshLoad(MeshLoad& load) {
+    Mesh mesh;
+    if (load.fromCache) {
+        const MeshCacheData& cached = load.cached;
+        mesh = UploadMesh(cached.vertices, cached.vertexCount, cached.indices, cached.indexCount, cached.indexSize,
+                          load.prepared);
+        mesh.indexCount = static_cast<int>(cached.lods[0].indexCount);
+        mesh.lods.assign(cached.lods, cached.lods + cached.lodCount);
+        mesh.meshlets.assign(cached.meshlets, cached.meshlets + cached.meshletCount);
+        load.cacheFile.close();
+    } else {
+        const void* vertices = load.prepared.format == VERTEX_FORMAT_PACKED
+                                   ? static_cast<const void*>(load.prepared.packed.data()) : load.vertices.data();
+        mesh = UploadMesh(vertices, load.vertices.size(), load.indices.data(), load.indices.size(), sizeof(unsigned int),
+                          load.prepared);
+        // Full detail goes up now; the LOD chain (and the cache, which stores it) follows in the background
+        mesh.lodBuild = StartLodBuild(load.path, std::move(load.vertices), std::move(load.indices), std::move(load.prepared),
+                                      load.optimized);
+    }
+    return mesh;
+}
+
+std::shared_ptr<MeshLoad> startObjModelLoad(const std::string& path) {
+    auto load = std::make_shared<MeshLoad>();
+    load->path = path;
+    RunAsync([load]() {
+        load->error = CaptureJobError([&]() { RunMeshLoad(*load); });
+        if (!load->error.empty()) load->ok = false;
+        load->done.store(true, std::memory_order_release);
+    });
+    return load;
+}
+
+float meshLoadProgress(const MeshLoad& load) {
+    return load.progress.fraction.load(std::memory_order_relaxed);
+}
+
+const char* meshLoadStage(const MeshLoad& load) {
+    return load.progress.stage.load(std::memory_order_relaxed);
+}
+
+const std::string& meshLoadPath(const MeshLoad& load) {
+    return load.path;
+}
+
+void cancelMeshLoad(MeshLoad& load) {
+    load.progress.cancel.store(true, std::memory_order_relaxed);
+}
+
+bool finishObjModelLoad(std::shared_ptr<MeshLoad>& load, Mesh& mesh) {
+    if (!load || !load->done.load(std::memory_order_acquire))
+        return false;
+    std::shared_ptr<MeshLoad> finished = std::move(load);
+    if (finished->progress.canceled()) {
+        std::cout << "Model load canceled: " << finished->path << std::endl;
+        return false;
+    }
+    if (!finished->error.empty()) {
+        std::cerr << "Model load failed: " << finished->path << ": " << finished->error << std::endl;
+        return false;
+    }
+    if (!finished->ok)
+        return false; // already reported; keep showing the current mesh
+
+    Mesh loaded = FinishMeshLoad(*finished);
+    mesh.cleanup(); // the old mesh's GL objects would leak otherwise
+    mesh = std::move(loaded);
+    std::cout << "Loaded " << finished->path << " in " << finished->seconds * 1000.0 << " ms (off the render thread)" << std::endl;
+    return true;
+}
+
+bool isBuildingMeshLods(const Mesh& mesh) {
+    return mesh.lodBuild != nullptr;
+}
+
+bool updateMeshLods(Mesh& mesh) {
+    if (!mesh.lodBuild || !mesh.lodBuild->done.load(std::memory_order_acquire))
+        return false;
+    std::shared_ptr<MeshLodBuild> build = std::move(mesh.lodBuild);
+    if (!build->error.empty()) {
+        std::cerr << "Mesh LOD build failed, keeping full detail only: " << build->error << std::endl;
+        return false;
+    }
+
+    // Same vertex buffer, so only the index buffer grows to hold every level
+    glBindVertexArray(mesh.VAO);
+    UploadIndices(mesh, build->chain.data(), build->chain.size());
+    glBindVertexArray(0);
+    mesh.lods = std::move(build->lods);
+    mesh.meshlets = std::move(build->meshlets);
+    mesh.currentLod = 0;
+
+    std::cout << "Mesh LODs ready in " << build->seconds * 1000.0 << " ms:" << std::endl;
+    for (size_t i = 0; i < mesh.lods.size(); ++i)
+        std::cout << "  LOD " << i << ": " << mesh.lods[i].indexCount / 3 << " triangles, "
+                  << mesh.lods[i].meshletCount << " meshlets, error " << mesh.lods[i].error << std::endl;
+    return true;
+}
+
+void drawMeshCulled(const Mesh& mesh, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
+                    const glm::vec3& cameraPos, bool coneCulling, MeshletCullStats* stats) {
+    if (mesh.lods.empty() || mesh.lods[mesh.currentLod].meshletCount == 0) {
+        mesh.draw();
+        return;
+    }
+    const MeshLod& lod = mesh.lods[mesh.currentLod];
+
+    // Meshlet bounds are in model space: cull against model-space planes and camera
+    glm::vec4 planes[6];
+    ExtractFrustumPlanes(projection * view * model, planes);
+    glm::vec3 localCamera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPos, 1.0f));
+
+    static std::vector<uint32_t> rangeOffsets, rangeCounts;
+    static std::vector<GLsizei> counts;
+    static std::vector<const void*> offsets;
+    rangeOffsets.clear();
+    rangeCounts.clear();
+    MeshletCullStats frameStats;
+    CullMeshlets(mesh.meshlets.data() + lod.meshletOffset, lod.meshletCount, planes, localCamera, coneCulling,
+                 rangeOffsets, rangeCounts, frameStats);
+    if (stats) *stats = frameStats;
+    if (rangeCounts.empty()) return;
+
+    size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    counts.resize(rangeCounts.size());
+    offsets.resize(rangeCounts.size());
+    for (size_t i = 0; i < rangeCounts.size(); ++i) {
+        counts[i] = static_cast<GLsizei>(rangeCounts[i]);
+        offsets[i] = (const void*)(rangeOffsets[i] * indexSize);
+    }
+
+    glBindVertexArray(mesh.VAO);
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), mesh.indexType, offsets.data(), static_cast<GLsizei>(counts.size()));
 }
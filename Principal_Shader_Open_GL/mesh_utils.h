@@ -10,16 +10,16 @@
 #include <iostream>
 #include <cstddef>
 #include <filesystem>
-// ─────────────────────────────────────────────
-// Vertex struct: holds per-vertex data
-// ─────
-// Needed to send position, normal, UV, and tangent to the GPU.
-struct Vertex {
-    glm::vec3 position;
-    glm::vec3 normal;
-    glm::vec2 texCoord;
-    glm::vec3 tangent = glm::vec3(0.0);
-};
+#include <vector>
+#include "vertex.h"
+#include "vertex_packing.h"
+#include "mesh_lod.h"
+#include "meshlets.h"
+#include <memory>
+#include "tangents.h"
+#include "gpu_memory.h"
+
+struct MeshLodBuild; // background LOD generation, see updateMeshLods
 
 // ─────────────────────────────────────────────
 // Mesh struct: holds GPU handle info and helpers
@@ -30,24 +30,62 @@ struct Mesh {
     GLuint EBO;
     int vertexCount;
     int indexCount;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when every index fits
+    VertexFormat format = VERTEX_FORMAT_FLOAT;
+    VertexDequantization dequant;       // identity unless format is VERTEX_FORMAT_PACKED
+    float radius = 0.0f;                // bounding sphere around the model origin
+
+    std::vector<MeshLod> lods;          // ranges of the EBO, lods[0] = full detail (empty: single level)
+    int currentLod = 0;
+    std::shared_ptr<MeshLodBuild> lodBuild;
+    std::vector<Meshlet> meshlets;      // every level's clusters, indexed by MeshLod::meshletOffset/Count
 
     void draw() const {
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        if (lods.empty()) {
+            glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+            return;
+        }
+        const MeshLod& lod = lods[currentLod];
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), indexType, (void*)(lod.indexOffset * indexSize));
     }
 
     void cleanup() const {
+        UntrackGpuMemory(GpuMemoryKind::MeshBuffer, VBO);
+        UntrackGpuMemory(GpuMemoryKind::MeshBuffer, EBO);
         glDeleteVertexArrays(1, &VAO);
         glDeleteBuffers(1, &VBO);
         glDeleteBuffers(1, &EBO);
     }
 };
 
-void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices); // calculate tangent vectors for each vertex to support nomal mapping
 Mesh createQuad();
-Mesh createMesh(); // generic function for any obj passed in 
+Mesh createMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                VertexFormat format = VERTEX_FORMAT_FLOAT); // generic function for any obj passed in 
+Mesh createMesh(const Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount,
+                VertexFormat format = VERTEX_FORMAT_FLOAT);
 Mesh createCube();
-Mesh loadObjModel(const std::string& path);
+
+// Asynchronous OBJ load: cache read or parse, tangents, optimization and vertex packing
+// all run on a worker; only the buffer upload happens on the GL thread. A cache hit is
+// uploaded straight from its mapping; otherwise LODs arrive later from a background job,
+// see updateMeshLods.
+struct MeshLoad;
+std::shared_ptr<MeshLoad> startObjModelLoad(const std::string& path);
+float meshLoadProgress(const MeshLoad& load); // 0..1
+const char* meshLoadStage(const MeshLoad& load);
+const std::string& meshLoadPath(const MeshLoad& load);
+void cancelMeshLoad(MeshLoad& load);
+// Once per frame: when the job has finished, uploads the result, frees the old `mesh` and
+// replaces it (true). `load` is reset once the job is over, also after a failure or cancel.
+bool finishObjModelLoad(std::shared_ptr<MeshLoad>& load, Mesh& mesh);
+bool updateMeshLods(Mesh& mesh);             // once per frame: uploads a finished LOD chain, true when it did
+bool isBuildingMeshLods(const Mesh& mesh);
+// Draws the current LOD with frustum (and optionally normal-cone) culled meshlets in one
+// glMultiDrawElements; falls back to Mesh::draw when the level has no meshlets
+void drawMeshCulled(const Mesh& mesh, const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection,
+                    const glm::vec3& cameraPos, bool coneCulling, MeshletCullStats* stats = nullptr);
 void renderCube();
 
 
@@ -0,0 +1,201 @@
+// meshlets.cpp
+#include "meshlets.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+static const float CONE_WEIGHT = 2.0f;        // facing coherence vs. shared vertices when growing a cluster
+static const float CONE_MIN_SPREAD_DOT = 0.1f; // wider cones (~84 deg half-angle) are never culled
+
+static glm::vec3 TriangleNormal(const std::vector<Vertex>& vertices, const unsigned int* tri) {
+    const glm::vec3& p0 = vertices[tri[0]].position;
+    glm::vec3 n = glm::cross(vertices[tri[1]].position - p0, vertices[tri[2]].position - p0);
+    float len = glm::length(n);
+    return len > 0.0f ? n / len : glm::vec3(0.0f);
+}
+
+static Meshlet ComputeMeshletBounds(const std::vector<Vertex>& vertices, const unsigned int* indices, size_t indexCount) {
+    Meshlet m;
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    glm::vec3 axis(0.0f);
+    for (size_t i = 0; i < indexCount; i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            minPos = glm::min(minPos, vertices[indices[i + k]].position);
+            maxPos = glm::max(maxPos, vertices[indices[i + k]].position);
+        }
+        axis += TriangleNormal(vertices, indices + i);
+    }
+
+    m.center = (minPos + maxPos) * 0.5f;
+    m.radius = 0.0f;
+    for (size_t i = 0; i < indexCount; ++i)
+        m.radius = std::max(m.radius, glm::length(vertices[indices[i]].position - m.center));
+
+    float axisLen = glm::length(axis);
+    m.coneAxis = axisLen > 0.0f ? axis / axisLen : glm::vec3(0.0f, 0.0f, 1.0f);
+    float minDot = axisLen > 0.0f ? 1.0f : -1.0f;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        glm::vec3 n = TriangleNormal(vertices, indices + i);
+        if (glm::dot(n, n) > 0.0f) minDot = std::min(minDot, glm::dot(n, m.coneAxis));
+    }
+    m.coneCutoff = minDot <= CONE_MIN_SPREAD_DOT ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    m.indexOffset = 0;
+    m.indexCount = static_cast<uint32_t>(indexCount);
+    return m;
+}
+
+size_t BuildMeshlets(const std::vector<Vertex>& vertices, unsigned int* indices, size_t indexCount,
+                     uint32_t indexBase, std::vector<Meshlet>& meshlets) {
+    const size_t triCount = indexCount / 3;
+    const size_t vertexCount = vertices.size();
+    if (triCount == 0) return 0;
+
+    // Vertex -> triangle adjacency (CSR)
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triCount * 3; ++i) ++offsets[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(triCount * 3);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triCount * 3; ++i) adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<glm::vec3> normals(triCount);
+    for (size_t t = 0; t < triCount; ++t) normals[t] = TriangleNormal(vertices, indices + t * 3);
+
+    std::vector<char> used(triCount, 0);
+    std::vector<uint32_t> candidateStamp(triCount, 0);  // == stamp once queued for the current meshlet
+    std::vector<uint32_t> vertexStamp(vertexCount, 0);  // == stamp while the vertex is in the current meshlet
+    uint32_t stamp = 0;
+
+    std::vector<uint32_t> order;                         // triangles in meshlet order
+    order.reserve(triCount);
+    std::vector<size_t> starts;                          // first triangle of each meshlet in `order`
+    std::vector<uint32_t> candidates;
+    size_t seed = 0;
+
+    while (true) {
+        while (seed < triCount && used[seed]) ++seed;
+        if (seed == triCount) break;
+
+        // Grow one meshlet from the first unused triangle (input order is cache-optimized, so seeds stay local)
+        ++stamp;
+        size_t meshletStart = order.size();
+        size_t meshletVertices = 0;
+        glm::vec3 normalSum(0.0f);
+        candidates.clear();
+
+        uint32_t next = static_cast<uint32_t>(seed);
+        while (next != UINT32_MAX) {
+            used[next] = 1;
+            order.push_back(next);
+            normalSum += normals[next];
+            for (int k = 0; k < 3; ++k) {
+                unsigned int v = indices[next * 3 + k];
+                if (vertexStamp[v] == stamp) continue;
+                vertexStamp[v] = stamp;
+                ++meshletVertices;
+                for (uint32_t a = offsets[v]; a < offsets[v + 1]; ++a) {
+                    uint32_t t = adjacency[a];
+                    if (used[t] || candidateStamp[t] == stamp) continue;
+                    candidateStamp[t] = stamp;
+                    candidates.push_back(t);
+                }
+            }
+            if (order.size() - meshletStart >= MESHLET_MAX_TRIANGLES) break;
+
+            // Best neighbour: fewest new vertices, then closest to the meshlet's facing
+            float axisLen = glm::length(normalSum);
+            glm::vec3 axis = axisLen > 0.0f ? normalSum / axisLen : glm::vec3(0.0f);
+            next = UINT32_MAX;
+            float bestScore = FLT_MAX;
+            size_t write = 0;
+            for (uint32_t t : candidates) {
+                if (used[t]) continue;
+                candidates[write++] = t;
+                int newVertices = 0;
+                for (int k = 0; k < 3; ++k) newVertices += vertexStamp[indices[t * 3 + k]] == stamp ? 0 : 1;
+                if (meshletVertices + newVertices > MESHLET_MAX_VERTICES) continue;
+                float score = static_cast<float>(newVertices) + CONE_WEIGHT * (1.0f - glm::dot(normals[t], axis));
+                if (score < bestScore) {
+                    bestScore = score;
+                    next = t;
+                }
+            }
+            candidates.resize(write);
+        }
+
+        // Keep the original (cache-friendly) triangle order inside the meshlet
+        std::sort(order.begin() + meshletStart, order.end());
+        starts.push_back(meshletStart);
+    }
+    starts.push_back(order.size());
+
+    // Rewrite the range in meshlet order and compute bounds
+    std::vector<unsigned int> reordered(triCount * 3);
+    for (size_t i = 0; i < order.size(); ++i)
+        for (int k = 0; k < 3; ++k) reordered[i * 3 + k] = indices[order[i] * 3 + k];
+    std::copy(reordered.begin(), reordered.end(), indices);
+
+    size_t added = starts.size() - 1;
+    meshlets.reserve(meshlets.size() + added);
+    for (size_t m = 0; m < added; ++m) {
+        size_t first = starts[m] * 3, count = (starts[m + 1] - starts[m]) * 3;
+        Meshlet meshlet = ComputeMeshletBounds(vertices, indices + first, count);
+        meshlet.indexOffset = indexBase + static_cast<uint32_t>(first);
+        meshlets.push_back(meshlet);
+    }
+    return added;
+}
+
+void ExtractFrustumPlanes(const glm::mat4& m, glm::vec4 planes[6]) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    planes[0] = row3 + row0; // left
+    planes[1] = row3 - row0; // right
+    planes[2] = row3 + row1; // bottom
+    planes[3] = row3 - row1; // top
+    planes[4] = row3 + row2; // near
+    planes[5] = row3 - row2; // far
+    for (int i = 0; i < 6; ++i) {
+        float len = glm::length(glm::vec3(planes[i]));
+        if (len > 0.0f) planes[i] = planes[i] * (1.0f / len);
+    }
+}
+
+void CullMeshlets(const Meshlet* meshlets, size_t count, const glm::vec4 planes[6], const glm::vec3& cameraPosition,
+                  bool coneCulling, std::vector<uint32_t>& rangeOffsets, std::vector<uint32_t>& rangeCounts,
+                  MeshletCullStats& stats) {
+    stats.total += count;
+    for (size_t i = 0; i < count; ++i) {
+        const Meshlet& m = meshlets[i];
+
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; ++p)
+            outside = glm::dot(glm::vec3(planes[p]), m.center) + planes[p].w < -m.radius;
+        if (outside) {
+            ++stats.frustumCulled;
+            continue;
+        }
+
+        // Every triangle faces away if the view direction lies inside the (radius-padded) back cone
+        if (coneCulling) {
+            glm::vec3 toCenter = m.center - cameraPosition;
+            if (glm::dot(toCenter, m.coneAxis) >= m.coneCutoff * glm::length(toCenter) + m.radius) {
+                ++stats.coneCulled;
+                continue;
+            }
+        }
+
+        stats.trianglesDrawn += m.indexCount / 3;
+        if (!rangeCounts.empty() && rangeOffsets.back() + rangeCounts.back() == m.indexOffset) {
+            rangeCounts.back() += m.indexCount;
+        } else {
+            rangeOffsets.push_back(m.indexOffset);
+            rangeCounts.push_back(m.indexCount);
+        }
+    }
+    stats.drawRanges = rangeCounts.size();
+}
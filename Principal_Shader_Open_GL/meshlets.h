@@ -0,0 +1,49 @@
+// meshlets.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Meshlets (triangle clusters) and CPU cluster culling
+// ─────
+// Each LOD range of the index buffer is reordered into small, spatially and
+// directionally coherent clusters. Per frame, clusters outside the view
+// frustum or facing entirely away from the camera (normal cone test) are
+// skipped, and the visible ones go out as one glMultiDrawElements. Bounds are
+// in model space, so culling runs against the camera moved into model space.
+const size_t MESHLET_MAX_VERTICES = 64;
+const size_t MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet {
+    glm::vec3 center;      // bounding sphere
+    float radius;
+    glm::vec3 coneAxis;    // average facing direction
+    float coneCutoff;      // sin of the cone half-angle; 1 = never cone-culled
+    uint32_t indexOffset;  // range in the mesh index buffer
+    uint32_t indexCount;
+};
+
+// Reorders indices[0, indexCount) cluster by cluster and appends one Meshlet per
+// cluster; `indexBase` is where this range starts in the full index buffer.
+// Returns the number of meshlets added.
+size_t BuildMeshlets(const std::vector<Vertex>& vertices, unsigned int* indices, size_t indexCount,
+                     uint32_t indexBase, std::vector<Meshlet>& meshlets);
+
+struct MeshletCullStats {
+    size_t total = 0;
+    size_t frustumCulled = 0;
+    size_t coneCulled = 0;
+    size_t trianglesDrawn = 0;
+    size_t drawRanges = 0;   // after merging neighbouring visible meshlets
+};
+
+// Six frustum planes (xyz = normal, w = distance) from a model-view-projection matrix
+void ExtractFrustumPlanes(const glm::mat4& modelViewProjection, glm::vec4 planes[6]);
+
+// Appends the index ranges that survive culling, merging meshlets that are
+// adjacent in the index buffer into a single range
+void CullMeshlets(const Meshlet* meshlets, size_t count, const glm::vec4 planes[6], const glm::vec3& cameraPosition,
+                  bool coneCulling, std::vector<uint32_t>& rangeOffsets, std::vector<uint32_t>& rangeCounts,
+                  MeshletCullStats& stats);
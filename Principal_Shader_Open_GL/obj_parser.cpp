@@ -0,0 +1,346 @@
+// obj_parser.cpp
+#include "obj_parser.h"
+#include "file_utils.h"
+#include "job_system.h"
+#include "vertex_dedup.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// A face index that was written relative to the end of the attribute list
+// ("f -1 -2 -3"). It can only be resolved once the chunk's global offset is known.
+struct RelativeIndex {
+    size_t slot;    // position in ObjChunk::corners
+    int64_t local;  // chunk-local attribute index (may point into earlier chunks, i.e. be negative)
+};
+
+struct ObjChunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;
+    std::vector<int64_t> corners;          // (v, vt, vn) per triangle corner, -1 = missing
+    std::vector<RelativeIndex> relative;
+
+    size_t positionBase = 0; // global attribute offsets, filled by the merge stage
+    size_t normalBase = 0;
+    size_t texcoordBase = 0;
+
+    bool ok = true;
+};
+
+static inline bool IsBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char* SkipBlanks(const char* p, const char* end) {
+    while (p < end && IsBlank(*p)) ++p;
+    return p;
+}
+
+static inline const char* NextLine(const char* p, const char* end) {
+    while (p < end && *p != '\n') ++p;
+    return p < end ? p + 1 : end;
+}
+
+static const char* ParseFloat(const char* p, const char* end, float& out) {
+    p = SkipBlanks(p, end);
+    if (p < end && *p == '+') ++p; // from_chars rejects an explicit plus sign
+    auto result = std::from_chars(p, end, out);
+    if (result.ec != std::errc()) return nullptr;
+    return result.ptr;
+}
+
+static const char* ParseInt(const char* p, const char* end, int64_t& out) {
+    if (p < end && *p == '+') ++p;
+    auto result = std::from_chars(p, end, out);
+    if (result.ec != std::errc()) return nullptr;
+    return result.ptr;
+}
+
+struct FaceCorner {
+    int64_t index[3];    // v, vt, vn as written (1-based, negative = relative, 0 = missing)
+};
+
+// Parses one "v/vt/vn" token (vt and vn optional). Returns nullptr on malformed input.
+static const char* ParseFaceCorner(const char* p, const char* end, FaceCorner& corner) {
+    corner.index[0] = corner.index[1] = corner.index[2] = 0;
+    p = ParseInt(p, end, corner.index[0]);
+    if (!p || corner.index[0] == 0) return nullptr;
+
+    for (int attr = 1; attr < 3 && p < end && *p == '/'; ++attr) {
+        ++p;
+        if (p < end && *p == '/') continue; // "v//vn"
+        if (p < end && (IsBlank(*p) || *p == '\n')) break;
+        p = ParseInt(p, end, corner.index[attr]);
+        if (!p) return nullptr;
+    }
+    return p;
+}
+
+static void EmitCorner(ObjChunk& chunk, const FaceCorner& corner, const size_t localCounts[3]) {
+    for (int attr = 0; attr < 3; ++attr) {
+        int64_t value = corner.index[attr];
+        if (value > 0) {
+            chunk.corners.push_back(value - 1);
+        } else if (value < 0) {
+            chunk.relative.push_back({ chunk.corners.size(), static_cast<int64_t>(localCounts[attr]) + value });
+            chunk.corners.push_back(0); // patched in the merge stage
+        } else {
+            chunk.corners.push_back(-1);
+        }
+    }
+}
+
+static void ParseChunk(ObjChunk& chunk) {
+    const char* p = chunk.begin;
+    const char* end = chunk.end;
+    std::vector<FaceCorner> face;
+    face.reserve(8);
+
+    while (p < end) {
+        p = SkipBlanks(p, end);
+        if (p >= end) break;
+
+        if (p[0] == 'v' && p + 1 < end) {
+            if (IsBlank(p[1])) {
+                glm::vec3 v;
+                p += 1;
+                if (!(p = ParseFloat(p, end, v.x)) || !(p = ParseFloat(p, end, v.y)) || !(p = ParseFloat(p, end, v.z))) {
+                    chunk.ok = false;
+                    return;
+                }
+                chunk.positions.push_back(v);
+            } else if (p[1] == 'n' && p + 2 < end && IsBlank(p[2])) {
+                glm::vec3 n;
+                p += 2;
+                if (!(p = ParseFloat(p, end, n.x)) || !(p = ParseFloat(p, end, n.y)) || !(p = ParseFloat(p, end, n.z))) {
+                    chunk.ok = false;
+                    return;
+                }
+                chunk.normals.push_back(n);
+            } else if (p[1] == 't' && p + 2 < end && IsBlank(p[2])) {
+                glm::vec2 t;
+                p += 2;
+                if (!(p = ParseFloat(p, end, t.x))) {
+                    chunk.ok = false;
+                    return;
+                }
+                const char* q = ParseFloat(p, end, t.y); // 1D texcoords are legal
+                if (q) p = q; else t.y = 0.0f;
+                chunk.texcoords.push_back(t);
+            }
+        } else if (p[0] == 'f' && p + 1 < end && IsBlank(p[1])) {
+            face.clear();
+            p += 1;
+            for (;;) {
+                p = SkipBlanks(p, end);
+                if (p >= end || *p == '\n' || *p == '#') break;
+                FaceCorner corner;
+                p = ParseFaceCorner(p, end, corner);
+                if (!p) {
+                    chunk.ok = false;
+                    return;
+                }
+                face.push_back(corner);
+            }
+
+            // Counts *before* this face: relative indices count back from here
+            const size_t localCounts[3] = { chunk.positions.size(), chunk.texcoords.size(), chunk.normals.size() };
+            for (size_t i = 1; i + 1 < face.size(); ++i) {
+                EmitCorner(chunk, face[0], localCounts);
+                EmitCorner(chunk, face[i], localCounts);
+                EmitCorner(chunk, face[i + 1], localCounts);
+            }
+        }
+        p = NextLine(p, end);
+    }
+}
+
+// Resolves a global attribute index into the chunk that owns it without ever
+// concatenating the per-chunk arrays. Lookups are mostly local, so the last hit
+// is checked before falling back to a binary search over the chunk offsets.
+template <typename T>
+class ChunkedAttribute {
+public:
+    ChunkedAttribute(const std::vector<ObjChunk>& chunks, std::vector<T> ObjChunk::* array, size_t ObjChunk::* base)
+        : chunks_(chunks), array_(array) {
+        for (const ObjChunk& c : chunks) {
+            bases_.push_back(c.*base);
+            total_ = c.*base + (c.*array).size();
+        }
+    }
+
+    size_t size() const { return total_; }
+
+    const T& operator[](size_t index) {
+        const ObjChunk& hit = chunks_[last_];
+        if (index < bases_[last_] || index >= bases_[last_] + (hit.*array_).size()) {
+            // last chunk whose base is <= index; empty chunks before it share its base
+            last_ = static_cast<size_t>(std::upper_bound(bases_.begin(), bases_.end(), index) - bases_.begin()) - 1;
+        }
+        return (chunks_[last_].*array_)[index - bases_[last_]];
+    }
+
+private:
+    const std::vector<ObjChunk>& chunks_;
+    std::vector<T> ObjChunk::* array_;
+    std::vector<size_t> bases_;
+    size_t total_ = 0;
+    size_t last_ = 0;
+};
+
+bool ParseObjParallel(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                      unsigned maxThreads, ObjParseStats* stats, JobProgress* progress) {
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Failed to open OBJ: " << path << std::endl;
+        return false;
+    }
+    const char* data = reinterpret_cast<const char*>(file.data());
+    const size_t size = file.size();
+
+    // ----- Stage 1: split at line boundaries -----
+    unsigned threads = maxThreads > 0 ? std::min(maxThreads, WorkerCount()) : WorkerCount();
+    const size_t MIN_CHUNK_BYTES = 1 << 20;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(size_t(threads) * 4, size / MIN_CHUNK_BYTES));
+    if (progress) // finer chunks so progress moves and a cancel is seen quickly
+        chunkCount = std::max<size_t>(chunkCount, std::min<size_t>(32, size / MIN_CHUNK_BYTES));
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* cursor = data;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* target = (i + 1 == chunkCount) ? data + size : data + size * (i + 1) / chunkCount;
+        if (target < cursor) target = cursor;
+        const char* chunkEnd = (i + 1 == chunkCount) ? data + size : NextLine(target, data + size);
+        chunks[i].begin = cursor;
+        chunks[i].end = chunkEnd;
+        cursor = chunkEnd;
+    }
+
+    // ----- Stage 2: parse chunks on every core -----
+    // Parsing is most of the work: it reports the first 80% of the progress range
+    std::atomic<size_t> parsedBytes(0);
+    ParallelFor(chunks.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (progress && progress->canceled()) return;
+            ObjChunk& chunk = chunks[i];
+            // rough per-chunk reservation: ~30 bytes per record line
+            size_t approxLines = static_cast<size_t>(chunk.end - chunk.begin) / 30;
+            chunk.positions.reserve(approxLines / 3);
+            chunk.corners.reserve(approxLines * 3);
+            ParseChunk(chunk);
+            size_t done = parsedBytes.fetch_add(static_cast<size_t>(chunk.end - chunk.begin)) + (chunk.end - chunk.begin);
+            if (progress) progress->report(0.8f * static_cast<float>(done) / std::max<size_t>(size, 1));
+        }
+    }, threads);
+    auto t1 = Clock::now();
+    if (progress && progress->canceled()) return false;
+
+    for (const ObjChunk& chunk : chunks) {
+        if (!chunk.ok) {
+            std::cerr << "Malformed OBJ record in: " << path << std::endl;
+            return false;
+        }
+    }
+
+    // ----- Stage 3: global offsets + relative index fixup -----
+    size_t positionCount = 0, normalCount = 0, texcoordCount = 0, cornerCount = 0;
+    for (ObjChunk& chunk : chunks) {
+        chunk.positionBase = positionCount;
+        chunk.normalBase = normalCount;
+        chunk.texcoordBase = texcoordCount;
+        positionCount += chunk.positions.size();
+        normalCount += chunk.normals.size();
+        texcoordCount += chunk.texcoords.size();
+        cornerCount += chunk.corners.size() / 3;
+    }
+
+    if (positionCount > 0xFFFFFFFEull || cornerCount > 0xFFFFFFFFull) {
+        std::cerr << "OBJ too large for 32-bit indices: " << path << std::endl;
+        return false;
+    }
+
+    ParallelFor(chunks.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ObjChunk& chunk = chunks[i];
+            const size_t bases[3] = { chunk.positionBase, chunk.texcoordBase, chunk.normalBase };
+            for (const RelativeIndex& rel : chunk.relative)
+                chunk.corners[rel.slot] = static_cast<int64_t>(bases[rel.slot % 3]) + rel.local;
+            chunk.relative.clear();
+            chunk.relative.shrink_to_fit();
+        }
+    }, threads);
+    auto t2 = Clock::now();
+
+    // ----- Stage 4: dedup corners into the final arrays -----
+    ChunkedAttribute<glm::vec3> positions(chunks, &ObjChunk::positions, &ObjChunk::positionBase);
+    ChunkedAttribute<glm::vec3> normals(chunks, &ObjChunk::normals, &ObjChunk::normalBase);
+    ChunkedAttribute<glm::vec2> texcoords(chunks, &ObjChunk::texcoords, &ObjChunk::texcoordBase);
+
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(positionCount);
+    indices.reserve(cornerCount);
+    CornerHashTable table(std::max<size_t>(positionCount, 1));
+
+    for (size_t chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex) {
+        if (progress) {
+            if (progress->canceled()) return false;
+            progress->report(0.8f + 0.2f * static_cast<float>(chunkIndex) / chunks.size());
+        }
+        ObjChunk& chunk = chunks[chunkIndex];
+        const int64_t* c = chunk.corners.data();
+        const size_t n = chunk.corners.size();
+        for (size_t i = 0; i < n; i += 3) {
+            int64_t v = c[i], t = c[i + 1], nn = c[i + 2];
+            if (v < 0 || static_cast<size_t>(v) >= positionCount ||
+                t >= static_cast<int64_t>(texcoordCount) || nn >= static_cast<int64_t>(normalCount) ||
+                t < -1 || nn < -1) {
+                std::cerr << "OBJ face index out of range in: " << path << std::endl;
+                return false;
+            }
+
+            CornerKey key = {
+                static_cast<uint32_t>(v + 1),
+                static_cast<uint32_t>(nn + 1),
+                static_cast<uint32_t>(t + 1)
+            };
+            bool inserted;
+            uint32_t vertex = table.findOrInsert(key, static_cast<uint32_t>(vertices.size()), inserted);
+            if (inserted) {
+                Vertex vert;
+                vert.position = positions[static_cast<size_t>(v)];
+                vert.normal = nn >= 0 ? normals[static_cast<size_t>(nn)] : glm::vec3(0.0f);
+                vert.texCoord = t >= 0 ? texcoords[static_cast<size_t>(t)] : glm::vec2(0.0f);
+                vertices.push_back(vert);
+            }
+            indices.push_back(vertex);
+        }
+        // Corner records are consumed; release them while the rest is assembled
+        std::vector<int64_t>().swap(chunk.corners);
+    }
+    auto t3 = Clock::now();
+
+    if (stats) {
+        stats->threads = threads;
+        stats->chunks = chunks.size();
+        stats->bytes = size;
+        stats->positions = positionCount;
+        stats->normals = normalCount;
+        stats->texcoords = texcoordCount;
+        stats->corners = cornerCount * 3;
+        stats->parseSeconds = std::chrono::duration<double>(t1 - t0).count();
+        stats->mergeSeconds = std::chrono::duration<double>(t2 - t1).count();
+        stats->assembleSeconds = std::chrono::duration<double>(t3 - t2).count();
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+// obj_parser.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Parallel OBJ parser
+// ─────
+// Stages:
+//   1. map the file and split it into chunks at line boundaries
+//   2. parse v / vn / vt / f records of every chunk on the job system
+//   3. compute global attribute offsets per chunk (prefix sums) and resolve
+//      negative (relative) face indices
+//   4. dedup corners straight out of the per-chunk attribute arrays into the
+//      final Vertex/index arrays (no merged second copy of the attributes)
+// Polygons are fan-triangulated. Groups, objects and materials are ignored, the
+// same way the tinyobjloader path merges every shape into one mesh.
+struct ObjParseStats {
+    unsigned threads = 0;
+    size_t chunks = 0;
+    size_t bytes = 0;
+    size_t positions = 0;
+    size_t normals = 0;
+    size_t texcoords = 0;
+    size_t corners = 0;            // triangle corners after triangulation
+    double parseSeconds = 0.0;     // stages 1-2
+    double mergeSeconds = 0.0;     // stage 3
+    double assembleSeconds = 0.0;  // stage 4
+};
+
+struct JobProgress;
+
+// Returns false (with a message on stderr) on I/O errors or malformed records so
+// the caller can fall back to tinyobjloader. `maxThreads` = 0 uses every worker.
+// With `progress`, the parse reports into its current stage and returns false
+// (silently) as soon as it sees the cancel flag.
+bool ParseObjParallel(const std::string& path, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                      unsigned maxThreads = 0, ObjParseStats* stats = nullptr, JobProgress* progress = nullptr);
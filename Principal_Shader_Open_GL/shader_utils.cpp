@@ -37,10 +37,9 @@ GLuint CompileShader(GLenum type, const char* src) {
     return shader; 
 }
 
-GLuint LinkProgram(GLuint vertex_shader, GLuint frag_shader) {
+static GLuint LinkShaders(const GLuint* shaders, int count) {
     GLuint program = glCreateProgram();
-    glAttachShader(program, vertex_shader);
-    glAttachShader(program, frag_shader);
+    for (int i = 0; i < count; ++i) glAttachShader(program, shaders[i]);
     glLinkProgram(program);
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
@@ -60,6 +59,16 @@ GLuint LinkProgram(GLuint vertex_shader, GLuint frag_shader) {
     return program;
 }
 
+GLuint LinkProgram(GLuint vertex_shader, GLuint frag_shader) {
+    const GLuint shaders[] = { vertex_shader, frag_shader };
+    return LinkShaders(shaders, 2);
+}
+
+GLuint LinkProgram(GLuint vertex_shader, GLuint geometry_shader, GLuint frag_shader) {
+    const GLuint shaders[] = { vertex_shader, geometry_shader, frag_shader };
+    return LinkShaders(shaders, 3);
+}
+
 GLint  ULoc(GLuint program, const char* name) {  // glGetUniformLocation wrapper
     GLint loc = glGetUniformLocation(program, name);
     if (loc == -1) std::cerr << "Warning: uniform not found: " << name << "\n";
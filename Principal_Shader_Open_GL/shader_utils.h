@@ -5,4 +5,5 @@
 std::string ReadTextFile(const char* path);
 GLuint CompileShader(GLenum type, const char* src);
 GLuint LinkProgram(GLuint vs, GLuint fs);
+GLuint LinkProgram(GLuint vs, GLuint gs, GLuint fs);
 GLint  ULoc(GLuint program, const char* name);  // glGetUniformLocation wrapper
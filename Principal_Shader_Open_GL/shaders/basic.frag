@@ -3,7 +3,7 @@ out vec4 FragColor;
   
 in vec2 texCoord;
 in vec3 worldPos;
-in vec3 fragTangent; 
+in vec4 fragTangent; // w = bitangent sign
 in vec3 fragNormal;
 
 // -- Lighting Uniforms --
@@ -27,16 +27,38 @@ uniform bool useBaseColorTex;
 uniform vec3 baseColorTint;
 uniform sampler2D uNormalTex;
 uniform bool uUseNormalTex;
-uniform sampler2D roughnessMap;
+uniform sampler2D roughMetalMap;   // R = roughness, G = metallic
+uniform sampler2D occlusionMap;
 uniform bool useRoughnessMap;
-uniform sampler2D metallicMap;
 uniform bool useMetallicMap;
-uniform sampler2D aoMap; 
 uniform bool useAOMap;
 
-// IBL - IMPORTANT: Need both maps!
-uniform samplerCube irradianceMap;  // For diffuse (blurry)
-uniform samplerCube environmentMap; // For specular (sharp)
+// -- Virtual textures (virtual_texture.h): maps too large to upload whole --
+struct VirtualTextureInfo {
+    vec4 size;        // width, height, level count (0 = sample the regular map), log2(max(width, height))
+    vec4 layout;      // 1 / page cache size, page size, page border, cache slot size (texels)
+    ivec4 levels[16]; // per level: indirection atlas origin (xy), pages across (zw)
+};
+uniform VirtualTextureInfo uBaseColorVT;
+uniform sampler2D uBaseColorVTPages;
+uniform sampler2D uBaseColorVTIndirection;
+uniform VirtualTextureInfo uNormalVT;
+uniform sampler2D uNormalVTPages;
+uniform sampler2D uNormalVTIndirection;
+uniform VirtualTextureInfo uRoughMetalVT;
+uniform sampler2D uRoughMetalVTPages;
+uniform sampler2D uRoughMetalVTIndirection;
+uniform VirtualTextureInfo uOcclusionVT;
+uniform sampler2D uOcclusionVTPages;
+uniform sampler2D uOcclusionVTIndirection;
+
+// IBL - diffuse from spherical harmonics, specular from the split sum
+layout(std140) uniform IrradianceSH {
+    vec4 uIrradianceSH[9]; // L2 SH of irradiance / pi, RGB (spherical_harmonics.h)
+};
+uniform samplerCube prefilteredMap; // GGX-prefiltered environment, mip i = roughness i / uPrefilterMaxLod
+uniform float uPrefilterMaxLod;     // its last mip level
+uniform sampler2D brdfLut;          // F0 scale and bias by (N.V, roughness) (brdf_lut.h)
 uniform bool useIBL;
 
 // Optional: Add these for more control
@@ -75,38 +97,80 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
     return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
 }
 
+// Diffuse IBL from the nine SH coefficients: same basis order as spherical_harmonics.cpp
+vec3 IrradianceFromSH(vec3 n) {
+    vec3 irradiance = uIrradianceSH[0].rgb * 0.282095
+        + (uIrradianceSH[1].rgb * n.y + uIrradianceSH[2].rgb * n.z + uIrradianceSH[3].rgb * n.x) * 0.488603
+        + (uIrradianceSH[4].rgb * (n.x * n.y) + uIrradianceSH[5].rgb * (n.y * n.z) + uIrradianceSH[7].rgb * (n.x * n.z)) * 1.092548
+        + uIrradianceSH[6].rgb * ((3.0 * n.z * n.z - 1.0) * 0.315392)
+        + uIrradianceSH[8].rgb * ((n.x * n.x - n.y * n.y) * 0.546274);
+    return max(irradiance, vec3(0.0)); // L2 rings slightly negative opposite a strong sun
+}
+
+// The level from the UV footprint (as vt_feedback.frag measures it), the page's cache slot
+// from the indirection atlas (or its nearest resident ancestor's), then one bilinear fetch
+vec4 SampleVirtual(sampler2D pages, sampler2D indirection, VirtualTextureInfo vt, vec2 uv) {
+    float footprint = max(length(dFdx(uv)), length(dFdy(uv)));
+    int level = int(clamp(floor(log2(max(footprint, 1e-9)) + vt.size.w + 0.5), 0.0, vt.size.z - 1.0));
+    uv = fract(uv); // GL_REPEAT
+    ivec4 info = vt.levels[level];
+    ivec2 levelSize = max(ivec2(vt.size.xy) >> level, ivec2(1));
+    ivec2 page = min(ivec2(uv * vec2(levelSize)) / int(vt.layout.y), info.zw - 1);
+    vec4 entry = floor(texelFetch(indirection, info.xy + page, 0) * 255.0 + 0.5);
+
+    vec2 texel = uv * vec2(max(ivec2(vt.size.xy) >> int(entry.z), ivec2(1))); // in the resident level
+    vec2 inPage = texel - floor(texel / vt.layout.y) * vt.layout.y;
+    return textureLod(pages, (entry.xy * vt.layout.w + vt.layout.z + inPage) * vt.layout.x, 0.0);
+}
+
 void main()
 {
     // ========== SURFACE PROPERTIES ==========
-    vec3 texColor = useBaseColorTex ? texture(baseColorTex, texCoord).rgb : vec3(1.0);
+    vec3 texColor = vec3(1.0);
+    if (useBaseColorTex) {
+        texColor = uBaseColorVT.size.z > 0.0
+            ? SampleVirtual(uBaseColorVTPages, uBaseColorVTIndirection, uBaseColorVT, texCoord).rgb
+            : texture(baseColorTex, texCoord).rgb;
+    }
     vec3 baseColor = texColor * baseColorTint;
     
-    // Sample material properties with multiple control options
+    // Sample material properties with multiple control options (one fetch for roughness and metallic)
+    vec2 roughMetal = vec2(1.0);
+    if (useRoughnessMap || useMetallicMap) {
+        roughMetal = uRoughMetalVT.size.z > 0.0
+            ? SampleVirtual(uRoughMetalVTPages, uRoughMetalVTIndirection, uRoughMetalVT, texCoord).rg
+            : texture(roughMetalMap, texCoord).rg;
+    }
     float roughness = uRoughness;
     if (useRoughnessMap) {
-        // Sample the texture
-        float textureRoughness = texture(roughnessMap, texCoord).r;
-        roughness = textureRoughness * uRoughness;
+        roughness = roughMetal.r * uRoughness;
     }
     // Allow full range but ensure numerical stability
     roughness = clamp(roughness, 0.01, 1.0);
     
     float metallic = uMetallic;
     if (useMetallicMap) {
-        float textureMetallic = texture(metallicMap, texCoord).r;
-        metallic = textureMetallic * uMetallic;
+        metallic = roughMetal.g * uMetallic;
     }
     metallic = clamp(metallic, 0.0, 1.0);
     
-    float ao = useAOMap ? texture(aoMap, texCoord).r : 1.0;
+    float ao = 1.0;
+    if (useAOMap) {
+        ao = uOcclusionVT.size.z > 0.0
+            ? SampleVirtual(uOcclusionVTPages, uOcclusionVTIndirection, uOcclusionVT, texCoord).r
+            : texture(occlusionMap, texCoord).r;
+    }
     
     // ========== NORMAL ==========
     vec3 N = normalize(fragNormal);
     if (uUseNormalTex) {
-        vec3 normalSample = texture(uNormalTex, texCoord).rgb * 2.0 - 1.0;
-        normalSample = normalize(normalSample);
-        vec3 T = normalize(fragTangent);
-        vec3 B = normalize(cross(N, T));
+        // Z is rebuilt from XY: two-channel (BC5) maps store no blue, and for RGB maps it is equivalent
+        vec2 normalXY = (uNormalVT.size.z > 0.0
+            ? SampleVirtual(uNormalVTPages, uNormalVTIndirection, uNormalVT, texCoord).rg
+            : texture(uNormalTex, texCoord).rg) * 2.0 - 1.0;
+        vec3 normalSample = vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+        vec3 T = normalize(fragTangent.xyz - N * dot(N, fragTangent.xyz)); // re-orthogonalize after interpolation
+        vec3 B = cross(N, T) * (fragTangent.w < 0.0 ? -1.0 : 1.0); // handedness from the mesh (mirrored UVs flip it)
         mat3 TBN = mat3(T, B, N);
         N = normalize(TBN * normalSample);
     }
@@ -173,23 +237,16 @@ void main()
         vec3 kD_ambient = vec3(1.0) - kS_ambient;
         kD_ambient *= 1.0 - metallic;
         
-        // DIFFUSE IBL: Use irradiance map (blurry)
-        vec3 irradiance = texture(irradianceMap, N).rgb;
+        // DIFFUSE IBL: irradiance from spherical harmonics
+        vec3 irradiance = IrradianceFromSH(N);
         vec3 diffuse_ibl = irradiance * baseColor * kD_ambient;
         
-        // SPECULAR IBL: Sample environment map with LOD based on roughness
+        // SPECULAR IBL (split sum): the prefiltered lobe for this roughness times the
+        // BRDF's integral for this view angle
         vec3 R = reflect(-V, N);
-        
-        // Properly scale LOD based on your cubemap mip levels
-        float MAX_REFLECTION_LOD = 4.0; // Adjust based on your cubemap mip levels
-        float lod = roughness * MAX_REFLECTION_LOD;
-        vec3 prefilteredColor = textureLod(environmentMap, R, lod).rgb;
-        // Apply BRDF approximation for IBL
-        vec3 specular_ibl = prefilteredColor * F_ambient;
-        float iblSpecularAttenuation = pow(1.0 - roughness, 2.0);
-        specular_ibl *= iblSpecularAttenuation;
-        float fresnelFade = pow(1.0 - roughness, 2.0);
-        specular_ibl *= fresnelFade;
+        vec3 prefilteredColor = textureLod(prefilteredMap, R, roughness * uPrefilterMaxLod).rgb;
+        vec2 envBRDF = texture(brdfLut, vec2(NdotV, roughness)).rg;
+        vec3 specular_ibl = prefilteredColor * (F0 * envBRDF.x + envBRDF.y);
         ambient = (diffuse_ibl + specular_ibl) * ao;
     } else {
         // No IBL fallback
@@ -0,0 +1,8 @@
+#version 330 core
+// Full-screen triangle from gl_VertexID (no vertex buffer), for cubemap_layered.geom
+out vec2 screenPos;
+
+void main() {
+    screenPos = vec2(gl_VertexID == 1 ? 3.0 : -1.0, gl_VertexID == 2 ? 3.0 : -1.0);
+    gl_Position = vec4(screenPos, 0.0, 1.0);
+}
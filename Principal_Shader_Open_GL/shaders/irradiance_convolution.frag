@@ -1,35 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-in vec3 localPos;
-
-uniform samplerCube environmentMap;
-
-const float PI = 3.14159265359;
-
-void main()
-{		
-    // the sample direction equals the hemisphere's orientation 
-    vec3 normal = normalize(localPos);
-    vec3 irradiance = vec3(0.0);
-    vec3 up = vec3(0.0, 1.0, 0.0);
-    vec3 right = normalize(cross(up, normal)); // perpendicular vector to up and normal 
-    up = normalize(cross(normal, right));
-  
-    // convolution code
-    float sampleDelta = 0.025; // decreasing/increasing sampel will increase/decrease accuracy of traversed hemisphere
-    float nrSamples = 0.0;
-    for (float phi = 0.0; phi < 2.0 * PI; phi += sampleDelta) {
-        for(float theta = 0.0; theta < 0.5 * PI; theta += sampleDelta) {
-            // spherical to cartesian (in tangent space)
-            vec3 tangentSample = vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
-            // tangent space to world
-            vec3 sampleVec = tangentSample.x * right + tangentSample.y * up + tangentSample.z * normal;
-
-            // note: scale sampled color by cos(theta) due to light being weaker at larger angles and by sin(teta) to account for smaller sample areas in higher hemisphere areas
-            irradiance += texture(environmentMap, sampleVec).rgb * cos(theta) * sin(theta);
-            nrSamples++;
-        }
-    }
-    irradiance = PI * irradiance * (1.0 / float(nrSamples)); // average sampled irradiance
-    FragColor = vec4(irradiance, 1.0);
-}
\ No newline at end of file
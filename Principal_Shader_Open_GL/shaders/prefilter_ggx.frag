@@ -0,0 +1,67 @@
+#version 330 core
+out vec4 FragColor;
+in vec3 localPos;
+
+uniform samplerCube environmentMap; // mipmapped, for filtered importance sampling
+uniform float roughness;            // of the mip being rendered
+uniform int sampleCount;
+uniform float environmentSize;      // face size of environmentMap's level 0
+uniform float minLod;               // environment mip with the face size being rendered
+
+const float PI = 3.14159265359;
+
+// Low-discrepancy point i of n (Hammersley), as in brdf_lut.cpp
+vec2 Hammersley(uint i, uint n) {
+    uint bits = i;
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return vec2(float(i) / float(n), float(bits) * 2.3283064365386963e-10);
+}
+
+float D_GGX(float NdotH, float alpha) {
+    float alpha2 = alpha * alpha;
+    float denom = NdotH * NdotH * (alpha2 - 1.0) + 1.0;
+    return alpha2 / (PI * denom * denom);
+}
+
+// GGX lobe around N with V = R = N (the split-sum assumption): each sample reads the
+// environment mip whose texels are about the solid angle the sample stands for
+// (filtered importance sampling, Krivanek & Colbert), so a few dozen samples per texel
+// come out smooth instead of speckled
+void main()
+{
+    vec3 N = normalize(localPos);
+    vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+    vec3 tangent = normalize(cross(up, N));
+    vec3 bitangent = cross(N, tangent);
+
+    float alpha = roughness * roughness;
+    float texelSolidAngle = 4.0 * PI / (6.0 * environmentSize * environmentSize);
+    vec3 color = vec3(0.0);
+    float totalWeight = 0.0;
+    for (int i = 0; i < sampleCount; ++i) {
+        vec2 xi = Hammersley(uint(i), uint(sampleCount));
+        float phi = 2.0 * PI * xi.x;
+        float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+        float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+        vec3 H = tangent * (sinTheta * cos(phi)) + bitangent * (sinTheta * sin(phi)) + N * cosTheta;
+        vec3 L = 2.0 * dot(N, H) * H - N;
+        float NdotL = dot(N, L);
+        if (NdotL <= 0.0) continue;
+
+        // pdf of L is D * NdotH / (4 VdotH), and NdotH == VdotH here. Roughness 0 is a
+        // mirror: one sample, a delta pdf
+        float lod = minLod;
+        if (alpha > 0.0) {
+            float pdf = D_GGX(cosTheta, alpha) * 0.25;
+            float sampleSolidAngle = 1.0 / (float(sampleCount) * pdf + 0.0001);
+            lod = max(0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0, minLod);
+        }
+        color += textureLod(environmentMap, L, lod).rgb * NdotL;
+        totalWeight += NdotL;
+    }
+    FragColor = vec4(color / max(totalWeight, 0.0001), 1.0);
+}
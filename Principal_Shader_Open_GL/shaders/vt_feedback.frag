@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 texCoord;
+
+uniform float uFeedbackScale; // feedback pixels per framebuffer pixel (1 / VT_FEEDBACK_DIVISOR)
+
+// Virtual texture feedback: which UV each pixel samples and how large a framebuffer
+// pixel is in UV units, measured the way SampleVirtual in basic.frag picks its level.
+// The CPU turns that into pages for every virtual map (virtual_texture.cpp).
+void main()
+{
+    float footprint = max(length(dFdx(texCoord)), length(dFdy(texCoord))) * uFeedbackScale;
+    float logFootprint = log2(max(footprint, 1e-9));
+    FragColor = vec4(fract(texCoord), clamp(-logFootprint / 32.0, 0.0, 1.0), 1.0); // alpha 0 = background
+}
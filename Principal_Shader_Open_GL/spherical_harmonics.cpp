@@ -0,0 +1,108 @@
+// spherical_harmonics.cpp
+#include "spherical_harmonics.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static const double PI = 3.14159265358979323846;
+
+// Real SH basis normalization constants for bands 0..2
+static const float SH_K0 = 0.282095f;  // 1 / (2 sqrt(pi))
+static const float SH_K1 = 0.488603f;  // sqrt(3 / (4 pi))
+static const float SH_K2 = 1.092548f;  // sqrt(15 / (4 pi))
+static const float SH_K20 = 0.315392f; // sqrt(5 / (16 pi))
+static const float SH_K22 = 0.546274f; // sqrt(15 / (16 pi))
+
+// Clamped-cosine convolution per band (pi, 2 pi / 3, pi / 4), divided by pi
+static const float BAND_SCALE[SH_COEFFICIENT_COUNT] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f,
+                                                        0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+static void Basis(float x, float y, float z, float out[SH_COEFFICIENT_COUNT]) {
+    out[0] = SH_K0;
+    out[1] = SH_K1 * y;
+    out[2] = SH_K1 * z;
+    out[3] = SH_K1 * x;
+    out[4] = SH_K2 * x * y;
+    out[5] = SH_K2 * y * z;
+    out[6] = SH_K20 * (3.0f * z * z - 1.0f);
+    out[7] = SH_K2 * x * z;
+    out[8] = SH_K22 * (x * x - y * y);
+}
+
+void CubeFaceDirection(int face, float sc, float tc, float& x, float& y, float& z) {
+    switch (face) {
+    case 0: x = 1.0f; y = -tc; z = -sc; break;
+    case 1: x = -1.0f; y = -tc; z = sc; break;
+    case 2: x = sc; y = 1.0f; z = tc; break;
+    case 3: x = sc; y = -1.0f; z = -tc; break;
+    case 4: x = sc; y = -tc; z = 1.0f; break;
+    default: x = -sc; y = -tc; z = -1.0f; break;
+    }
+}
+
+// One row's weighted radiance per coefficient, plus its total solid angle
+struct RowSum {
+    double rgb[SH_COEFFICIENT_COUNT][3] = {};
+    double weight = 0.0;
+};
+
+IrradianceSH ProjectIrradianceSH(const float* const faces[6], int size) {
+    IrradianceSH sh;
+    if (size <= 0) return sh;
+    const size_t rows = static_cast<size_t>(size) * 6;
+    std::vector<RowSum> sums(rows);
+    const float texel = 2.0f / static_cast<float>(size);
+
+    ParallelFor(rows, [&](size_t begin, size_t end) {
+        float basis[SH_COEFFICIENT_COUNT];
+        for (size_t r = begin; r < end; ++r) {
+            const int face = static_cast<int>(r / size);
+            const int row = static_cast<int>(r % size);
+            const float tc = (row + 0.5f) * texel - 1.0f;
+            const float* pixel = faces[face] + static_cast<size_t>(row) * size * 3;
+            RowSum& sum = sums[r];
+            for (int column = 0; column < size; ++column, pixel += 3) {
+                const float sc = (column + 0.5f) * texel - 1.0f;
+                float x, y, z;
+                CubeFaceDirection(face, sc, tc, x, y, z);
+                // Solid angle of the texel: its area on the face over distance^3
+                const float lengthSq = x * x + y * y + z * z;
+                const float inverseLength = 1.0f / std::sqrt(lengthSq);
+                const float weight = texel * texel * inverseLength / lengthSq;
+                Basis(x * inverseLength, y * inverseLength, z * inverseLength, basis);
+                for (int i = 0; i < SH_COEFFICIENT_COUNT; ++i) {
+                    const float w = basis[i] * weight;
+                    sum.rgb[i][0] += pixel[0] * w;
+                    sum.rgb[i][1] += pixel[1] * w;
+                    sum.rgb[i][2] += pixel[2] * w;
+                }
+                sum.weight += weight;
+            }
+        }
+    }, 0, 16);
+
+    RowSum total;
+    for (const RowSum& sum : sums) {
+        for (int i = 0; i < SH_COEFFICIENT_COUNT; ++i)
+            for (int c = 0; c < 3; ++c) total.rgb[i][c] += sum.rgb[i][c];
+        total.weight += sum.weight;
+    }
+    // The texel solid angles add up to 4 pi only approximately; rescale so a constant
+    // environment projects exactly
+    const double normalize = 4.0 * PI / total.weight;
+    for (int i = 0; i < SH_COEFFICIENT_COUNT; ++i)
+        for (int c = 0; c < 3; ++c)
+            sh.coefficients[i][c] = static_cast<float>(total.rgb[i][c] * normalize) * BAND_SCALE[i];
+    return sh;
+}
+
+void EvaluateIrradianceSH(const IrradianceSH& sh, float x, float y, float z, float rgb[3]) {
+    float basis[SH_COEFFICIENT_COUNT];
+    Basis(x, y, z, basis);
+    for (int c = 0; c < 3; ++c) {
+        float value = 0.0f;
+        for (int i = 0; i < SH_COEFFICIENT_COUNT; ++i) value += sh.coefficients[i][c] * basis[i];
+        rgb[c] = std::max(value, 0.0f);
+    }
+}
@@ -0,0 +1,33 @@
+// spherical_harmonics.h
+#pragma once
+#include <cstddef>
+
+// ─────────────────────────────────────────────
+// Spherical-harmonics irradiance
+// ─────
+// Diffuse lighting from an environment is smooth enough that the first three
+// SH bands (9 coefficients per color channel) reproduce it to within a few
+// percent (Ramamoorthi & Hanrahan). Projecting a small cubemap level takes a
+// millisecond on the CPU, where the irradiance convolution cubemap it replaces
+// cost ~100M texture fetches per environment change, and basic.frag evaluates
+// the result from a uniform block instead of sampling a cubemap.
+const int SH_COEFFICIENT_COUNT = 9;
+
+// Coefficients already convolved with the clamped cosine lobe and divided by pi,
+// so evaluating them at a normal gives what the irradiance cubemap held:
+// irradiance / pi, ready to multiply with the albedo
+struct IrradianceSH {
+    float coefficients[SH_COEFFICIENT_COUNT][3] = {}; // RGB; bands 0, 1 (y, z, x), 2 (xy, yz, 3z^2 - 1, xz, x^2 - y^2)
+};
+
+// Projects six `size`^2 RGB float faces (GL order +X, -X, +Y, -Y, +Z, -Z, rows bottom
+// to top as glGetTexImage returns them), weighting each texel by its solid angle.
+// Rows run in parallel; the sum is reduced in a fixed order, so results are repeatable.
+IrradianceSH ProjectIrradianceSH(const float* const faces[6], int size);
+
+// Evaluates `sh` at the unit vector (x, y, z) into `rgb`, as IrradianceFromSH in basic.frag does
+void EvaluateIrradianceSH(const IrradianceSH& sh, float x, float y, float z, float rgb[3]);
+
+// Direction (not normalized) through face coordinates (sc, tc) in [-1, 1] of cube face
+// `face`, per the GL cube map face table; texel rows run along tc, bottom to top
+void CubeFaceDirection(int face, float sc, float tc, float& x, float& y, float& z);
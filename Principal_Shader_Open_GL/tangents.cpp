@@ -0,0 +1,186 @@
+// tangents.cpp
+#include "tangents.h"
+#include "job_system.h"
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TANGENTS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Squared-length threshold below which a direction is treated as degenerate
+static const float DEGENERATE_EPS = 1e-30f;
+
+// Per-triangle tangent/bitangent directions, structure-of-arrays so four
+// triangles map straight onto one SSE register per component.
+struct TriangleBasis {
+    std::vector<float> tx, ty, tz;
+    std::vector<float> bx, by, bz;
+
+    void resize(size_t n) {
+        tx.resize(n); ty.resize(n); tz.resize(n);
+        bx.resize(n); by.resize(n); bz.resize(n);
+    }
+};
+
+// Scalar reference kernel. The SIMD kernel performs exactly the same IEEE
+// operations in the same order, so both paths produce identical bits.
+static void TriangleBasisScalar(const Vertex* vertices, const unsigned int* tri, TriangleBasis& out, size_t t) {
+    const Vertex& v0 = vertices[tri[0]];
+    const Vertex& v1 = vertices[tri[1]];
+    const Vertex& v2 = vertices[tri[2]];
+
+    // Vector edges of the triangle (model space) and UV deltas (texture space)
+    float e1x = v1.position.x - v0.position.x, e1y = v1.position.y - v0.position.y, e1z = v1.position.z - v0.position.z;
+    float e2x = v2.position.x - v0.position.x, e2y = v2.position.y - v0.position.y, e2z = v2.position.z - v0.position.z;
+    float du1 = v1.texCoord.x - v0.texCoord.x, dv1 = v1.texCoord.y - v0.texCoord.y;
+    float du2 = v2.texCoord.x - v0.texCoord.x, dv2 = v2.texCoord.y - v0.texCoord.y;
+
+    // Only the sign of the UV determinant matters once the result is normalized,
+    // so there is no 1/det (which is where the old code produced inf/NaN).
+    float det = du1 * dv2 - du2 * dv1;
+    float s = (det > 0.0f ? 1.0f : 0.0f) - (det < 0.0f ? 1.0f : 0.0f);
+
+    float tx = (e1x * dv2 - e2x * dv1) * s, ty = (e1y * dv2 - e2y * dv1) * s, tz = (e1z * dv2 - e2z * dv1) * s;
+    float bx = (e2x * du1 - e1x * du2) * s, by = (e2y * du1 - e1y * du2) * s, bz = (e2z * du1 - e1z * du2) * s;
+
+    float tl2 = tx * tx + ty * ty + tz * tz;
+    float bl2 = bx * bx + by * by + bz * bz;
+    float tInv = tl2 > DEGENERATE_EPS ? 1.0f / std::sqrt(tl2) : 0.0f;
+    float bInv = bl2 > DEGENERATE_EPS ? 1.0f / std::sqrt(bl2) : 0.0f;
+
+    out.tx[t] = tx * tInv; out.ty[t] = ty * tInv; out.tz[t] = tz * tInv;
+    out.bx[t] = bx * bInv; out.by[t] = by * bInv; out.bz[t] = bz * bInv;
+}
+
+#ifdef TANGENTS_SSE2
+// Four triangles per call: gathers AoS vertex data into SoA lanes
+static void TriangleBasisSSE(const Vertex* vertices, const unsigned int* tris, TriangleBasis& out, size_t t) {
+    const Vertex* a[4][3];
+    for (int lane = 0; lane < 4; ++lane)
+        for (int c = 0; c < 3; ++c)
+            a[lane][c] = &vertices[tris[lane * 3 + c]];
+
+#define GATHER(corner, member) _mm_setr_ps(a[0][corner]->member, a[1][corner]->member, a[2][corner]->member, a[3][corner]->member)
+    __m128 p0x = GATHER(0, position.x), p0y = GATHER(0, position.y), p0z = GATHER(0, position.z);
+    __m128 e1x = _mm_sub_ps(GATHER(1, position.x), p0x), e1y = _mm_sub_ps(GATHER(1, position.y), p0y), e1z = _mm_sub_ps(GATHER(1, position.z), p0z);
+    __m128 e2x = _mm_sub_ps(GATHER(2, position.x), p0x), e2y = _mm_sub_ps(GATHER(2, position.y), p0y), e2z = _mm_sub_ps(GATHER(2, position.z), p0z);
+    __m128 u0 = GATHER(0, texCoord.x), v0 = GATHER(0, texCoord.y);
+    __m128 du1 = _mm_sub_ps(GATHER(1, texCoord.x), u0), dv1 = _mm_sub_ps(GATHER(1, texCoord.y), v0);
+    __m128 du2 = _mm_sub_ps(GATHER(2, texCoord.x), u0), dv2 = _mm_sub_ps(GATHER(2, texCoord.y), v0);
+#undef GATHER
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 eps = _mm_set1_ps(DEGENERATE_EPS);
+
+    __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+    __m128 s = _mm_sub_ps(_mm_and_ps(_mm_cmpgt_ps(det, zero), one), _mm_and_ps(_mm_cmplt_ps(det, zero), one));
+
+    __m128 tx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1x, dv2), _mm_mul_ps(e2x, dv1)), s);
+    __m128 ty = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1y, dv2), _mm_mul_ps(e2y, dv1)), s);
+    __m128 tz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e1z, dv2), _mm_mul_ps(e2z, dv1)), s);
+    __m128 bx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2x, du1), _mm_mul_ps(e1x, du2)), s);
+    __m128 by = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2y, du1), _mm_mul_ps(e1y, du2)), s);
+    __m128 bz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(e2z, du1), _mm_mul_ps(e1z, du2)), s);
+
+    __m128 tl2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+    __m128 bl2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(bx, bx), _mm_mul_ps(by, by)), _mm_mul_ps(bz, bz));
+    __m128 tInv = _mm_and_ps(_mm_cmpgt_ps(tl2, eps), _mm_div_ps(one, _mm_sqrt_ps(tl2)));
+    __m128 bInv = _mm_and_ps(_mm_cmpgt_ps(bl2, eps), _mm_div_ps(one, _mm_sqrt_ps(bl2)));
+
+    _mm_storeu_ps(&out.tx[t], _mm_mul_ps(tx, tInv));
+    _mm_storeu_ps(&out.ty[t], _mm_mul_ps(ty, tInv));
+    _mm_storeu_ps(&out.tz[t], _mm_mul_ps(tz, tInv));
+    _mm_storeu_ps(&out.bx[t], _mm_mul_ps(bx, bInv));
+    _mm_storeu_ps(&out.by[t], _mm_mul_ps(by, bInv));
+    _mm_storeu_ps(&out.bz[t], _mm_mul_ps(bz, bInv));
+}
+#endif
+
+// Any unit vector perpendicular to n (used when UVs give no usable direction)
+static glm::vec3 OrthogonalTo(const glm::vec3& n) {
+    glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 t = axis - n * glm::dot(n, axis);
+    float len2 = glm::dot(t, t);
+    return len2 > DEGENERATE_EPS ? t / std::sqrt(len2) : glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned maxThreads) {
+    ComputeTangents(vertices.data(), vertices.size(), indices.data(), indices.size(), maxThreads);
+}
+
+void ComputeTangents(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, unsigned maxThreads) {
+    const size_t triCount = indexCount / 3;
+    if (vertexCount == 0) return;
+
+    // ----- Pass 1: per-triangle directions, parallel over triangle ranges -----
+    TriangleBasis basis;
+    basis.resize(triCount);
+    ParallelFor(triCount, [&](size_t begin, size_t end) {
+        size_t t = begin;
+#ifdef TANGENTS_SSE2
+        for (; t + 4 <= end; t += 4) {
+            const unsigned int* tris = indices + t * 3;
+            bool inRange = true;
+            for (int k = 0; k < 12; ++k) inRange &= tris[k] < vertexCount;
+            if (!inRange) break; // rare: let the scalar loop handle (and skip) bad triangles
+            TriangleBasisSSE(vertices, tris, basis, t);
+        }
+#endif
+        for (; t < end; ++t) {
+            const unsigned int* tri = indices + t * 3;
+            if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) {
+                basis.tx[t] = basis.ty[t] = basis.tz[t] = 0.0f;
+                basis.bx[t] = basis.by[t] = basis.bz[t] = 0.0f;
+                continue;
+            }
+            TriangleBasisScalar(vertices, tri, basis, t);
+        }
+    }, maxThreads, 4096);
+
+    // ----- Pass 2: vertex -> triangle adjacency (CSR, triangle order) -----
+    // Gathering per vertex instead of scattering per triangle means no two
+    // threads ever write the same vertex, and the summation order is fixed.
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < triCount * 3; ++i)
+        if (indices[i] < vertexCount) ++offsets[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<uint32_t> adjacency(offsets[vertexCount]);
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triCount * 3; ++i)
+            if (indices[i] < vertexCount) adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // ----- Pass 3: per-vertex sum, Gram-Schmidt and handedness -----
+    ParallelFor(vertexCount, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            glm::vec3 T(0.0f), B(0.0f);
+            for (uint32_t a = offsets[v]; a < offsets[v + 1]; ++a) {
+                uint32_t t = adjacency[a];
+                T += glm::vec3(basis.tx[t], basis.ty[t], basis.tz[t]);
+                B += glm::vec3(basis.bx[t], basis.by[t], basis.bz[t]);
+            }
+
+            glm::vec3 N = vertices[v].normal;
+            float nl2 = glm::dot(N, N);
+            if (nl2 > DEGENERATE_EPS) {
+                N = N / std::sqrt(nl2);
+                T = T - N * glm::dot(N, T); // make T orthogonal to the shading normal
+            }
+
+            float tl2 = glm::dot(T, T);
+            if (tl2 > DEGENERATE_EPS)
+                T = T / std::sqrt(tl2);
+            else
+                T = OrthogonalTo(N);
+
+            float w = glm::dot(glm::cross(N, T), B) < 0.0f ? -1.0f : 1.0f;
+            vertices[v].tangent = glm::vec4(T, w);
+        }
+    }, maxThreads, 4096);
+}
@@ -0,0 +1,18 @@
+// tangents.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Tangent generation
+// ─────
+// Writes Vertex::tangent as (T.xyz, w) where w = +-1 is the bitangent sign,
+// B = w * cross(N, T), following the MikkTSpace convention used by normal map
+// bakers. Per-triangle directions are computed on SIMD lanes in parallel, then
+// each vertex sums its triangles in index-buffer order, so the result does not
+// depend on the thread count. Degenerate UVs or positions contribute nothing,
+// and vertices left without a usable direction get an arbitrary orthonormal
+// tangent instead of NaNs.
+void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned maxThreads = 0); // calculate tangent vectors for each vertex to support nomal mapping
+void ComputeTangents(Vertex* vertices, size_t vertexCount, const unsigned int* indices, size_t indexCount, unsigned maxThreads = 0);
@@ -0,0 +1,266 @@
+// texture_cache.cpp
+#include "texture_cache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+// Bump whenever the file layout or an encoder's output changes
+static const uint32_t TEXTURE_CACHE_VERSION = 3;
+static const char TEXTURE_CACHE_MAGIC[8] = { 'P', 'B', 'R', 'T', 'E', 'X', '\0', '\0' };
+static const uint32_t TEXTURE_CACHE_MAX_LEVELS = 16;
+
+struct TextureCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;         // TexelFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t faceCount;      // 1 or 6
+    uint32_t flipY;
+    uint32_t mipKey;         // MipOptionsKey of the filter that built the chain
+    uint64_t sourceSize;     // image caches only: the source's identity
+    int64_t  sourceMTime;    // filesystem clock ticks
+    uint64_t sourceHash;     // HashFileSampled(source)
+    uint64_t contentHash;    // HashBytes(whole source), the texture registry key
+    // followed by levelCount * faceCount TextureCacheRegion entries (level-major)
+};
+
+struct TextureCacheRegion {
+    uint64_t offset; // from the start of the file, 16-byte aligned
+    uint64_t size;
+};
+
+bool IsCompressedFormat(TexelFormat format) {
+    return format == TexelFormat::BC1 || format == TexelFormat::BC4 || format == TexelFormat::BC5;
+}
+
+bool IsHalfFormat(TexelFormat format) {
+    return format == TexelFormat::R16F || format == TexelFormat::RG16F || format == TexelFormat::RGB16F ||
+           format == TexelFormat::RGBA16F;
+}
+
+int TexelChannels(TexelFormat format) {
+    switch (format) {
+    case TexelFormat::BC4: case TexelFormat::R8: case TexelFormat::R16F: return 1;
+    case TexelFormat::BC5: case TexelFormat::RG8: case TexelFormat::RG16F: return 2;
+    case TexelFormat::BC1: case TexelFormat::RGB8: case TexelFormat::RGB16F: return 3;
+    case TexelFormat::RGBA8: case TexelFormat::RGBA16F: return 4;
+    }
+    return 0;
+}
+
+TexelFormat ByteFormat(int channels) {
+    static const TexelFormat formats[4] = { TexelFormat::R8, TexelFormat::RG8, TexelFormat::RGB8, TexelFormat::RGBA8 };
+    return formats[std::min(std::max(channels, 1), 4) - 1];
+}
+
+TexelFormat HalfFormat(int channels) {
+    static const TexelFormat formats[4] = { TexelFormat::R16F, TexelFormat::RG16F, TexelFormat::RGB16F,
+                                            TexelFormat::RGBA16F };
+    return formats[std::min(std::max(channels, 1), 4) - 1];
+}
+
+static bool IsKnownFormat(uint32_t format) {
+    return TexelChannels(static_cast<TexelFormat>(format)) != 0;
+}
+
+size_t TexelLevelSize(TexelFormat format, int width, int height) {
+    if (IsCompressedFormat(format))
+        return CompressedLevelSize(static_cast<TextureCompression>(format), width, height);
+    size_t texelBytes = static_cast<size_t>(TexelChannels(format)) * (IsHalfFormat(format) ? 2 : 1);
+    return static_cast<size_t>(width) * height * texelBytes;
+}
+
+TextureCacheInfo DescribeTextureImage(const CompressedImage& image) {
+    TextureCacheInfo info;
+    info.format = static_cast<TexelFormat>(image.format);
+    info.width = image.width;
+    info.height = image.height;
+    for (size_t level = 0; level < image.levelSizes.size(); ++level)
+        info.levels.push_back({ image.data.data() + image.levelOffsets[level], image.levelSizes[level] });
+    return info;
+}
+
+TextureCacheInfo DescribeTextureImage(const MipChain& chain) {
+    TextureCacheInfo info;
+    info.format = ByteFormat(chain.channels);
+    info.width = chain.width;
+    info.height = chain.height;
+    for (size_t level = 0; level < chain.levelSizes.size(); ++level)
+        info.levels.push_back({ chain.data.data() + chain.levelOffsets[level], chain.levelSizes[level] });
+    return info;
+}
+
+static bool StatSource(const std::string& imagePath, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(imagePath, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(std::filesystem::last_write_time(imagePath, ec).time_since_epoch().count());
+    return !ec;
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool FormatMatches(uint32_t stored, TextureCompression compression) {
+    TexelFormat format = static_cast<TexelFormat>(stored);
+    return compression == TextureCompression::None ? !IsCompressedFormat(format)
+                                                   : format == static_cast<TexelFormat>(compression);
+}
+
+// Maps `path` and checks the layout; the caller validates the source fields of `header`
+static bool MapTextureCache(const std::string& path, MappedFile& file, TextureCacheHeader& header,
+                            TextureCacheInfo& info) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return false;
+    if (!file.open(path)) {
+        std::cerr << "Cannot map texture file: " << path << std::endl;
+        return false;
+    }
+    if (file.size() < sizeof(header)) return false;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC)) != 0 ||
+        header.version != TEXTURE_CACHE_VERSION) {
+        std::cout << "Texture file out of date (version), rebuilding: " << path << std::endl;
+        return false;
+    }
+
+    const size_t regionCount = static_cast<size_t>(header.levelCount) * header.faceCount;
+    bool valid = IsKnownFormat(header.format) && header.levelCount >= 1 &&
+                 header.levelCount <= TEXTURE_CACHE_MAX_LEVELS && (header.faceCount == 1 || header.faceCount == 6) &&
+                 header.width > 0 && header.height > 0 &&
+                 sizeof(header) + regionCount * sizeof(TextureCacheRegion) <= file.size();
+    info.format = static_cast<TexelFormat>(header.format);
+    info.width = static_cast<int>(header.width);
+    info.height = static_cast<int>(header.height);
+    info.faces = static_cast<int>(header.faceCount);
+    info.contentHash = header.contentHash;
+    info.levels.clear();
+    for (size_t i = 0; valid && i < regionCount; ++i) {
+        TextureCacheRegion region;
+        std::memcpy(&region, file.data() + sizeof(header) + i * sizeof(region), sizeof(region));
+        int level = static_cast<int>(i / header.faceCount);
+        int w = std::max(info.width >> level, 1), h = std::max(info.height >> level, 1);
+        valid = region.size == TexelLevelSize(info.format, w, h) && region.offset + region.size <= file.size();
+        info.levels.push_back({ file.data() + region.offset, static_cast<size_t>(region.size) });
+    }
+    if (!valid) {
+        std::cerr << "Texture file truncated: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static bool WriteCacheFile(const std::string& path, TextureCacheHeader& header, const TextureCacheInfo& image) {
+    const int levelCount = image.levelCount();
+    if (levelCount < 1 || levelCount > static_cast<int>(TEXTURE_CACHE_MAX_LEVELS) ||
+        (image.faces != 1 && image.faces != 6) || image.levels.size() != static_cast<size_t>(levelCount * image.faces))
+        return false;
+    std::memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = static_cast<uint32_t>(image.format);
+    header.width = static_cast<uint32_t>(image.width);
+    header.height = static_cast<uint32_t>(image.height);
+    header.levelCount = static_cast<uint32_t>(levelCount);
+    header.faceCount = static_cast<uint32_t>(image.faces);
+
+    static const unsigned char zeros[16] = {};
+    std::vector<TextureCacheRegion> regions(image.levels.size());
+    std::vector<FileChunk> chunks;
+    chunks.push_back({ &header, sizeof(header) });
+    chunks.push_back({ regions.data(), regions.size() * sizeof(TextureCacheRegion) });
+    uint64_t offset = sizeof(header) + regions.size() * sizeof(TextureCacheRegion);
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        uint64_t aligned = AlignUp(offset, 16);
+        if (aligned != offset) chunks.push_back({ zeros, static_cast<size_t>(aligned - offset) });
+        regions[i] = { aligned, image.levels[i].size };
+        chunks.push_back({ image.levels[i].data, image.levels[i].size });
+        offset = aligned + image.levels[i].size;
+    }
+
+    if (!WriteFileAtomic(path, chunks)) {
+        std::cerr << "Failed to write texture file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OpenTextureFile(const std::string& path, MappedFile& file, TextureCacheInfo& info) {
+    TextureCacheHeader header;
+    return MapTextureCache(path, file, header, info);
+}
+
+bool WriteTextureFile(const std::string& path, const TextureCacheInfo& image) {
+    TextureCacheHeader header = {};
+    header.contentHash = image.contentHash;
+    return WriteCacheFile(path, header, image);
+}
+
+std::string TextureCachePath(const std::string& imagePath) {
+    return std::filesystem::path(imagePath).replace_extension(".pbrtex").string();
+}
+
+// Same encoding, flip and filter as requested
+static bool CacheMatches(const TextureCacheHeader& header, TextureCompression compression, bool flipY,
+                         uint32_t mipKey, const std::string& path) {
+    if (FormatMatches(header.format, compression) && header.flipY == (flipY ? 1u : 0u) && header.mipKey == mipKey)
+        return true;
+    std::cout << "Texture cache out of date (format), rebuilding: " << path << std::endl;
+    return false;
+}
+
+bool OpenTextureCache(const std::string& imagePath, TextureCompression compression, bool flipY, uint32_t mipKey,
+                      MappedFile& file, TextureCacheInfo& info) {
+    std::string cachePath = TextureCachePath(imagePath);
+    uint64_t sourceSize;
+    int64_t sourceMTime;
+    TextureCacheHeader header;
+    if (!StatSource(imagePath, sourceSize, sourceMTime) || !MapTextureCache(cachePath, file, header, info) ||
+        !CacheMatches(header, compression, flipY, mipKey, cachePath))
+        return false;
+    if (header.sourceSize != sourceSize || header.sourceMTime != sourceMTime ||
+        header.sourceHash != HashFileSampled(imagePath)) {
+        std::cout << "Texture cache out of date (source changed), rebuilding: " << cachePath << std::endl;
+        return false;
+    }
+    return info.faces == 1;
+}
+
+bool WriteTextureCache(const std::string& imagePath, bool flipY, uint32_t mipKey, uint64_t contentHash,
+                       const TextureCacheInfo& image) {
+    TextureCacheHeader header = {};
+    header.flipY = flipY ? 1u : 0u;
+    header.mipKey = mipKey;
+    if (!StatSource(imagePath, header.sourceSize, header.sourceMTime)) return false;
+    header.sourceHash = HashFileSampled(imagePath);
+    header.contentHash = contentHash;
+    return WriteCacheFile(TextureCachePath(imagePath), header, image);
+}
+
+std::string PackedTextureCachePath(const std::string& directory, uint64_t contentHash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.pbrtex", static_cast<unsigned long long>(contentHash));
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool OpenPackedTextureCache(const std::string& cachePath, TextureCompression compression, bool flipY, uint32_t mipKey,
+                            uint64_t contentHash, MappedFile& file, TextureCacheInfo& info) {
+    TextureCacheHeader header;
+    if (!MapTextureCache(cachePath, file, header, info) || !CacheMatches(header, compression, flipY, mipKey, cachePath))
+        return false;
+    return header.contentHash == contentHash && info.faces == 1; // else a hash collision in the name; rebuild
+}
+
+bool WritePackedTextureCache(const std::string& cachePath, bool flipY, uint32_t mipKey, uint64_t contentHash,
+                             const TextureCacheInfo& image) {
+    TextureCacheHeader header = {};
+    header.flipY = flipY ? 1u : 0u;
+    header.mipKey = mipKey;
+    header.contentHash = contentHash; // no single source to stat
+    return WriteCacheFile(cachePath, header, image);
+}
@@ -0,0 +1,87 @@
+// texture_cache.h
+#pragma once
+#include "file_utils.h"
+#include "texture_compress.h"
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Texture container (.pbrtex)
+// ─────
+// A native, KTX2-like texture file: a header, a table with the offset and size
+// of every (level, face) region, then the texels, each region 16-byte aligned.
+// Files are read through a memory mapping and uploaded straight from it, so
+// loading one costs the I/O and nothing else. Holds 2D textures and cubemaps
+// (faces in GL order +X -X +Y -Y +Z -Z) of 8-bit, block-compressed or half-float
+// texels, mip chains included.
+enum class TexelFormat : uint32_t {
+    BC1 = 1, // same values as TextureCompression
+    BC4 = 4,
+    BC5 = 5,
+    R8 = 16,
+    RG8 = 17,
+    RGB8 = 18,
+    RGBA8 = 19,
+    R16F = 32,
+    RG16F = 33,
+    RGB16F = 34,
+    RGBA16F = 35,
+};
+
+bool IsCompressedFormat(TexelFormat format);
+bool IsHalfFormat(TexelFormat format);
+int TexelChannels(TexelFormat format);         // 1-4 (3 for BC1)
+TexelFormat ByteFormat(int channels);          // R8 .. RGBA8
+TexelFormat HalfFormat(int channels);          // R16F .. RGBA16F
+size_t TexelLevelSize(TexelFormat format, int width, int height);
+
+// One level of one face
+struct TextureCacheLevel {
+    const unsigned char* data; // points into the mapping (or the writer's buffers)
+    size_t size;
+};
+
+struct TextureCacheInfo {
+    TexelFormat format = TexelFormat::RGBA8;
+    int width = 0;
+    int height = 0;
+    int faces = 1;            // 1 or 6
+    uint64_t contentHash = 0; // HashBytes of the whole source file at encode time (caches only)
+    std::vector<TextureCacheLevel> levels; // level-major: levels[level * faces + face]
+
+    int levelCount() const { return faces ? static_cast<int>(levels.size()) / faces : 0; }
+    const TextureCacheLevel& level(int index, int face = 0) const { return levels[index * faces + face]; }
+};
+
+// Describe in-memory chains for writing (pointers into `image` / `chain`)
+TextureCacheInfo DescribeTextureImage(const CompressedImage& image);
+TextureCacheInfo DescribeTextureImage(const MipChain& chain);
+
+// Plain container files (baked outputs, hand-made assets); `info.levels` stay valid while `file` is open
+bool OpenTextureFile(const std::string& path, MappedFile& file, TextureCacheInfo& info);
+bool WriteTextureFile(const std::string& path, const TextureCacheInfo& image);
+
+// ─────────────────────────────────────────────
+// Image caches
+// ─────
+// The same file next to a source image ("wood.png" -> "wood.pbrtex") holds its
+// decoded (and possibly block-compressed) mip chain, so later loads skip the
+// image decoder and the encoder. Like the mesh cache it is only used while the
+// source's size, modification time and sampled hash match, and only for the same
+// encoding, flip and mip options (MipOptionsKey). `compression` None accepts any
+// uncompressed format; the caller checks which one it got.
+std::string TextureCachePath(const std::string& imagePath);
+
+bool OpenTextureCache(const std::string& imagePath, TextureCompression compression, bool flipY, uint32_t mipKey,
+                      MappedFile& file, TextureCacheInfo& info);
+bool WriteTextureCache(const std::string& imagePath, bool flipY, uint32_t mipKey, uint64_t contentHash,
+                       const TextureCacheInfo& image);
+
+// Content-addressed variant for textures built from several images (packed material
+// maps): the file is named after the combined content hash of the inputs, which is
+// all it is validated against. Lives in `directory` ("<dir>/<hash>.pbrtex").
+std::string PackedTextureCachePath(const std::string& directory, uint64_t contentHash);
+bool OpenPackedTextureCache(const std::string& cachePath, TextureCompression compression, bool flipY, uint32_t mipKey,
+                            uint64_t contentHash, MappedFile& file, TextureCacheInfo& info);
+bool WritePackedTextureCache(const std::string& cachePath, bool flipY, uint32_t mipKey, uint64_t contentHash,
+                             const TextureCacheInfo& image);
@@ -0,0 +1,300 @@
+// texture_compress.cpp
+#include "texture_compress.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXCOMP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+size_t CompressedBlockBytes(TextureCompression format) {
+    return format == TextureCompression::BC5 ? 16 : 8;
+}
+
+size_t CompressedLevelSize(TextureCompression format, int width, int height) {
+    size_t blocksX = (static_cast<size_t>(width) + 3) / 4;
+    size_t blocksY = (static_cast<size_t>(height) + 3) / 4;
+    return blocksX * blocksY * CompressedBlockBytes(format);
+}
+
+// ─────────────────────────────────────────────
+// BC1
+// ─────
+static uint16_t Pack565(const float c[3]) {
+    int r = static_cast<int>(std::lround(std::min(std::max(c[0], 0.0f), 255.0f) * 31.0f / 255.0f));
+    int g = static_cast<int>(std::lround(std::min(std::max(c[1], 0.0f), 255.0f) * 63.0f / 255.0f));
+    int b = static_cast<int>(std::lround(std::min(std::max(c[2], 0.0f), 255.0f) * 31.0f / 255.0f));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void Unpack565(uint16_t c, float out[3]) {
+    int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+    out[0] = static_cast<float>((r << 3) | (r >> 2));
+    out[1] = static_cast<float>((g << 2) | (g >> 4));
+    out[2] = static_cast<float>((b << 3) | (b >> 2));
+}
+
+// Nearest of the four palette entries per pixel; returns the packed indices and the squared error
+static uint32_t SelectBC1Indices(const float px[3][16], uint16_t c0, uint16_t c1, float& error) {
+    float palette[4][3];
+    Unpack565(c0, palette[0]);
+    Unpack565(c1, palette[1]);
+    for (int k = 0; k < 3; ++k) {
+        palette[2][k] = (2.0f * palette[0][k] + palette[1][k]) / 3.0f;
+        palette[3][k] = (palette[0][k] + 2.0f * palette[1][k]) / 3.0f;
+    }
+
+    uint32_t indices = 0;
+    error = 0.0f;
+#ifdef TEXCOMP_SSE2
+    __m128 totalError = _mm_setzero_ps();
+    for (int i = 0; i < 16; i += 4) {
+        __m128 r = _mm_loadu_ps(px[0] + i), g = _mm_loadu_ps(px[1] + i), b = _mm_loadu_ps(px[2] + i);
+        __m128 bestDist = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int p = 0; p < 4; ++p) {
+            __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+            __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(dist, bestDist));
+            bestDist = _mm_min_ps(dist, bestDist);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(p)));
+        }
+        totalError = _mm_add_ps(totalError, bestDist);
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+        for (int k = 0; k < 4; ++k) indices |= static_cast<uint32_t>(lanes[k]) << (2 * (i + k));
+    }
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, totalError);
+    error = sums[0] + sums[1] + sums[2] + sums[3];
+#else
+    for (int i = 0; i < 16; ++i) {
+        float bestDist = FLT_MAX;
+        uint32_t best = 0;
+        for (uint32_t p = 0; p < 4; ++p) {
+            float dr = px[0][i] - palette[p][0], dg = px[1][i] - palette[p][1], db = px[2][i] - palette[p][2];
+            float dist = dr * dr + dg * dg + db * db;
+            if (dist < bestDist) {
+                bestDist = dist;
+                best = p;
+            }
+        }
+        error += bestDist;
+        indices |= best << (2 * i);
+    }
+#endif
+    return indices;
+}
+
+static void WriteBC1(uint16_t c0, uint16_t c1, uint32_t indices, unsigned char out[8]) {
+    out[0] = static_cast<unsigned char>(c0 & 0xff);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1 & 0xff);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    for (int k = 0; k < 4; ++k) out[4 + k] = static_cast<unsigned char>(indices >> (8 * k));
+}
+
+// Quantizes both endpoints, keeps 4-color mode (c0 > c1) and picks indices
+static uint32_t FitBC1(const float px[3][16], const float e0[3], const float e1[3], uint16_t& c0, uint16_t& c1,
+                       float& error) {
+    c0 = Pack565(e0);
+    c1 = Pack565(e1);
+    if (c0 < c1) std::swap(c0, c1);
+    if (c0 == c1) {
+        // Equal endpoints would switch to the 3-color + transparent mode; nudge c1 down
+        if (c0 == 0) c0 = 1;
+        else c1 = static_cast<uint16_t>(c0 - 1);
+    }
+    return SelectBC1Indices(px, c0, c1, error);
+}
+
+void CompressBC1Block(const unsigned char rgba[16 * 4], unsigned char out[8]) {
+    float px[3][16];
+    float mean[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i)
+        for (int k = 0; k < 3; ++k) {
+            px[k][i] = rgba[i * 4 + k];
+            mean[k] += px[k][i];
+        }
+    for (int k = 0; k < 3; ++k) mean[k] /= 16.0f;
+
+    // Principal axis of the block's colors (power iteration on the covariance)
+    float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float r = px[0][i] - mean[0], g = px[1][i] - mean[1], b = px[2][i] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iter = 0; iter < 8; ++iter) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+        if (len < 1e-6f) break; // (near) solid block: any axis works
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+    float axisLen2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+    float minT = FLT_MAX, maxT = -FLT_MAX;
+    for (int i = 0; i < 16; ++i) {
+        float t = ((px[0][i] - mean[0]) * axis[0] + (px[1][i] - mean[1]) * axis[1] + (px[2][i] - mean[2]) * axis[2]) / axisLen2;
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    // Pull the extremes in a little: the palette then covers the bulk of the block better
+    float inset = (maxT - minT) / 16.0f;
+    minT += inset;
+    maxT -= inset;
+    float e0[3], e1[3];
+    for (int k = 0; k < 3; ++k) {
+        e0[k] = mean[k] + axis[k] * maxT;
+        e1[k] = mean[k] + axis[k] * minT;
+    }
+
+    uint16_t c0, c1;
+    float error;
+    uint32_t indices = FitBC1(px, e0, e1, c0, c1, error);
+
+    // One least-squares refit of the endpoints to the chosen indices
+    static const float WEIGHT[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f }; // share of c0 per index
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        float w = WEIGHT[(indices >> (2 * i)) & 3], v = 1.0f - w;
+        aa += w * w; ab += w * v; bb += v * v;
+        for (int k = 0; k < 3; ++k) {
+            ax[k] += w * px[k][i];
+            bx[k] += v * px[k][i];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) > 1e-6f) {
+        float r0[3], r1[3];
+        for (int k = 0; k < 3; ++k) {
+            r0[k] = (bb * ax[k] - ab * bx[k]) / det;
+            r1[k] = (aa * bx[k] - ab * ax[k]) / det;
+        }
+        uint16_t rc0, rc1;
+        float refinedError;
+        uint32_t refined = FitBC1(px, r0, r1, rc0, rc1, refinedError);
+        if (refinedError < error) {
+            c0 = rc0;
+            c1 = rc1;
+            indices = refined;
+        }
+    }
+    WriteBC1(c0, c1, indices, out);
+}
+
+// ─────────────────────────────────────────────
+// BC4 (BC5 = two of these)
+// ─────
+void CompressBC4Block(const unsigned char values[16], unsigned char out[8]) {
+    unsigned char lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i) {
+        lo = std::min(lo, values[i]);
+        hi = std::max(hi, values[i]);
+    }
+    out[0] = hi;
+    out[1] = lo;
+    uint64_t indices = 0;
+    if (hi != lo) {
+        // 8-value mode (r0 > r1): level 7 = hi is index 0, level 0 = lo is index 1, level k is index 8 - k
+        const float scale = 7.0f / static_cast<float>(hi - lo);
+        int levels[16];
+#ifdef TEXCOMP_SSE2
+        const __m128 lo4 = _mm_set1_ps(static_cast<float>(lo)), scale4 = _mm_set1_ps(scale);
+        for (int i = 0; i < 16; i += 4) {
+            __m128 v = _mm_setr_ps(values[i], values[i + 1], values[i + 2], values[i + 3]);
+            __m128i level = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(v, lo4), scale4)); // round to nearest
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(levels + i), level);
+        }
+#else
+        for (int i = 0; i < 16; ++i)
+            levels[i] = static_cast<int>(std::lround((values[i] - lo) * scale));
+#endif
+        for (int i = 0; i < 16; ++i) {
+            int level = std::min(std::max(levels[i], 0), 7);
+            uint64_t index = level == 7 ? 0 : level == 0 ? 1 : static_cast<uint64_t>(8 - level);
+            indices |= index << (3 * i);
+        }
+    }
+    for (int k = 0; k < 6; ++k) out[2 + k] = static_cast<unsigned char>(indices >> (8 * k));
+}
+
+// ─────────────────────────────────────────────
+// Images
+// ─────
+static void CompressLevel(const unsigned char* pixels, int width, int height, int channels, TextureCompression format,
+                          unsigned char* out) {
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    const size_t blockBytes = CompressedBlockBytes(format);
+    ParallelFor(static_cast<size_t>(blocksY), [&](size_t begin, size_t end) {
+        unsigned char rgba[16 * 4], red[16], green[16];
+        for (size_t by = begin; by < end; ++by) {
+            for (int bx = 0; bx < blocksX; ++bx) {
+                // Gather the block; edge blocks repeat the last row / column
+                for (int i = 0; i < 16; ++i) {
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(static_cast<int>(by) * 4 + (i >> 2), height - 1);
+                    const unsigned char* p = pixels + (static_cast<size_t>(y) * width + x) * channels;
+                    red[i] = p[0];
+                    green[i] = p[std::min(1, channels - 1)];
+                    if (format == TextureCompression::BC1) {
+                        bool gray = channels < 3;
+                        rgba[i * 4 + 0] = p[0];
+                        rgba[i * 4 + 1] = gray ? p[0] : p[1];
+                        rgba[i * 4 + 2] = gray ? p[0] : p[2];
+                        rgba[i * 4 + 3] = 255;
+                    }
+                }
+                unsigned char* block = out + (by * blocksX + bx) * blockBytes;
+                if (format == TextureCompression::BC1) {
+                    CompressBC1Block(rgba, block);
+                } else {
+                    CompressBC4Block(red, block);
+                    if (format == TextureCompression::BC5) CompressBC4Block(green, block + 8);
+                }
+            }
+        }
+    }, 0, 4);
+}
+
+bool PrepareCompressedImage(const MipChain& chain, TextureCompression format, CompressedImage& out) {
+    if (format == TextureCompression::None || chain.levelSizes.empty() || chain.channels < 1 || chain.channels > 4)
+        return false;
+
+    out.format = format;
+    out.width = chain.width;
+    out.height = chain.height;
+    out.levelOffsets.clear();
+    out.levelSizes.clear();
+    size_t total = 0;
+    for (size_t level = 0; level < chain.levelSizes.size(); ++level) {
+        size_t size = CompressedLevelSize(format, std::max(chain.width >> level, 1), std::max(chain.height >> level, 1));
+        out.levelOffsets.push_back(total);
+        out.levelSizes.push_back(size);
+        total += size;
+    }
+    out.data.resize(total);
+    return true;
+}
+
+void CompressImageLevel(const MipChain& chain, size_t level, CompressedImage& out) {
+    CompressLevel(chain.data.data() + chain.levelOffsets[level], std::max(chain.width >> level, 1),
+                  std::max(chain.height >> level, 1), chain.channels, out.format,
+                  out.data.data() + out.levelOffsets[level]);
+}
+
+bool CompressImage(const MipChain& chain, TextureCompression format, CompressedImage& out) {
+    if (!PrepareCompressedImage(chain, format, out)) return false;
+    for (size_t level = 0; level < chain.levelSizes.size(); ++level)
+        CompressImageLevel(chain, level, out);
+    return true;
+}
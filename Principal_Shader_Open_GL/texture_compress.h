@@ -0,0 +1,47 @@
+// texture_compress.h
+#pragma once
+#include "texture_mips.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// CPU block compression (BC1 / BC4 / BC5)
+// ─────
+// Every format stores 4x4 pixel blocks in 8 (BC1, BC4) or 16 (BC5) bytes:
+// BC1 = RGB565 endpoints + 2-bit indices (color maps, 6:1 vs. RGB8),
+// BC4 = one channel with 8-bit endpoints + 3-bit indices (scalar maps, 2:1 vs. R8
+// but 6:1 vs. the RGB files they usually come in), BC5 = two BC4 blocks (normal
+// XY; Z is rebuilt in the shader). Blocks are encoded in parallel over block rows
+// with SSE2 index selection.
+enum class TextureCompression : uint32_t {
+    None = 0,
+    BC1 = 1,
+    BC4 = 4,
+    BC5 = 5,
+};
+
+size_t CompressedBlockBytes(TextureCompression format); // 8 or 16
+size_t CompressedLevelSize(TextureCompression format, int width, int height);
+
+// One 4x4 block; pixels are row-major RGBA8 (BC1) or single bytes (BC4)
+void CompressBC1Block(const unsigned char rgba[16 * 4], unsigned char out[8]);
+void CompressBC4Block(const unsigned char values[16], unsigned char out[8]);
+
+struct CompressedImage {
+    TextureCompression format = TextureCompression::None;
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> data;   // all levels back to back, largest first
+    std::vector<size_t> levelOffsets;  // one per level into `data`
+    std::vector<size_t> levelSizes;
+};
+
+// Compresses every level of `chain` (see texture_mips.h).
+// BC1 reads RGB (gray for 1-2 channels), BC4 the first channel, BC5 the first two.
+bool CompressImage(const MipChain& chain, TextureCompression format, CompressedImage& out);
+
+// The same in steps, for callers that hand levels on as they finish: sizes `out` for
+// every level of `chain`, then encodes one level at a time (in any order)
+bool PrepareCompressedImage(const MipChain& chain, TextureCompression format, CompressedImage& out);
+void CompressImageLevel(const MipChain& chain, size_t level, CompressedImage& out);
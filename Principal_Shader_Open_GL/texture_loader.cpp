@@ -0,0 +1,945 @@
+// texture_loader.cpp
+#include "texture_loader.h"
+#include "file_utils.h"
+#include "gpu_memory.h"
+#include "job_system.h"
+#include "material_pack.h"
+#include "texture_cache.h"
+#include "External/stb_image.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+struct StbiDeleter {
+    void operator()(unsigned char* pixels) const { stbi_image_free(pixels); }
+};
+
+// Identifies a file version without reading it
+struct FileStamp {
+    uintmax_t size = 0;
+    std::filesystem::file_time_type mtime;
+    bool operator==(const FileStamp& o) const { return size == o.size && mtime == o.mtime; }
+};
+
+// One mip level ready for upload: pixel rows, or rows of 4x4 blocks when compressed
+struct UploadLevel {
+    const unsigned char* data = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t size = 0;
+};
+
+// One queued image. Decode fields are written by the job before `decoded` (or, for
+// `levels`, before `prepared`); the upload fields belong to the GL thread.
+struct TextureRequest {
+    GLuint* target = nullptr;
+    std::vector<std::string> paths; // one image, or one per packed channel ("" = constant)
+    std::string name;               // path, or a description of the packed inputs
+    TextureOptions options;
+    std::vector<FileStamp> stamps;
+    bool stamped = false;
+
+    std::atomic<bool> decoded{ false };
+    std::atomic<bool> prepared{ false }; // `levels` final while the encoder is still filling them in
+    std::atomic<size_t> readyFrom{ 0 };  // levels [readyFrom, levels.size()) hold their texels
+    bool ok = false;
+    uint64_t contentHash = 0;
+    uint64_t key = 0;
+    GLuint reused = 0;        // resident texture for `key` the job took a reference on instead of decoding
+    int channels = 0;         // uncompressed only
+    std::vector<UploadLevel> levels;
+    std::unique_ptr<unsigned char, StbiDeleter> pixels;
+    std::vector<unsigned char> packedPixels;
+    MipChain mips;              // uncompressed levels
+    CompressedImage compressed; // freshly encoded blocks
+    MappedFile cacheFile;       // or levels mapped from the .pbrtex
+    double decodeSeconds = 0.0;
+    bool fromCache = false;
+    std::string error;          // what the job threw, reported on the GL thread
+
+    GLuint texture = 0;
+    size_t pendingLevels = 0; // levels not uploaded yet; the next one is pendingLevels - 1
+    int nextRow = 0;
+    bool visible = false;     // tail uploaded, registered and assigned; still refining
+    bool superseded = false;
+    std::chrono::steady_clock::time_point queued;
+    double visibleSeconds = 0.0;
+};
+
+struct PboSlot {
+    GLuint buffer = 0;
+    size_t size = 0;
+    GLsync fence = nullptr;
+};
+
+struct TextureEntry {
+    GLuint texture = 0;
+    size_t bytes = 0;
+    int refs = 0;
+    uint64_t lastUse = 0;     // registry clock at the last assign / release (LRU order)
+    std::string path;         // first path it was loaded from (for logs)
+    bool complete = false;    // every level streamed in
+    // What the budget needs to drop a level
+    TextureCompression compression = TextureCompression::None;
+    GLenum internalFormat = 0;
+    int channels = 0;         // uncompressed only
+    int width = 0;
+    int height = 0;
+    int levelCount = 0;
+    int droppedLevels = 0;    // top levels given up to stay within the GPU memory budget
+};
+
+static std::vector<std::shared_ptr<TextureRequest>> g_requests; // GL thread only, in request order
+static PboSlot g_ring[TEXTURE_PBO_RING_SIZE];
+static size_t g_nextSlot = 0;
+
+// Registry. Decode jobs look up and pin entries, so it is guarded by a mutex;
+// creating and deleting the GL textures happens on the GL thread only.
+static std::mutex g_registryMutex;
+static std::unordered_map<uint64_t, TextureEntry> g_entries;   // key -> entry
+static std::unordered_map<GLuint, uint64_t> g_textureKeys;     // texture -> key
+static std::unordered_map<std::string, std::pair<std::vector<FileStamp>, uint64_t>> g_pathHashes; // by request name, GL thread only
+static TextureCacheStats g_stats;
+static uint64_t g_useClock = 0;
+
+// Key of a downscaled entry: its texture name, unique while it lives, so no request finds it
+static uint64_t DownscaledKey(GLuint texture) {
+    static const uint64_t DOWNSCALED_SEED = 0x646f776e7363616cull;
+    return HashBytes(&texture, sizeof(texture), DOWNSCALED_SEED);
+}
+
+static uint64_t TextureKey(uint64_t contentHash, const TextureOptions& options) {
+    uint32_t params[2] = { static_cast<uint32_t>(options.generateMipmaps) | static_cast<uint32_t>(options.flipY) << 8 |
+                               static_cast<uint32_t>(options.colorSpace) << 16 |
+                               static_cast<uint32_t>(options.compression) << 24,
+                           MipOptionsKey(options.mips) };
+    return HashBytes(params, sizeof(params), contentHash);
+}
+
+static bool StampFile(const std::string& path, FileStamp& stamp) {
+    std::error_code ec;
+    stamp.size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    stamp.mtime = std::filesystem::last_write_time(path, ec);
+    return !ec;
+}
+
+static bool HasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+TextureCompression EffectiveTextureCompression(const TextureOptions& options) {
+    static const bool disabled = [] {
+        const char* env = std::getenv("PBR_TEXTURE_COMPRESSION");
+        return env && std::strcmp(env, "none") == 0;
+    }();
+    static const bool s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool s3tcSRGB = s3tc && HasExtension("GL_EXT_texture_sRGB");
+    if (disabled) return TextureCompression::None;
+    if (options.compression == TextureCompression::BC1 &&
+        !(options.colorSpace == TextureColorSpace::SRGB ? s3tcSRGB : s3tc))
+        return TextureCompression::None; // BC4 / BC5 (RGTC) are core since GL 3.0
+    return options.compression;
+}
+
+// Takes a reference on a resident texture. Caller holds g_registryMutex.
+static GLuint AcquireLocked(uint64_t key) {
+    auto it = g_entries.find(key);
+    if (it == g_entries.end()) return 0;
+    TextureEntry& entry = it->second;
+    if (entry.refs++ == 0) g_stats.idleBytes -= entry.bytes;
+    return entry.texture;
+}
+
+// Report text for gpu_memory.h
+static std::string MemoryState(const TextureEntry& entry) {
+    std::string state = !entry.complete ? "streaming" : entry.refs ? "in use" : "idle";
+    if (entry.droppedLevels) state += ", " + std::to_string(entry.droppedLevels) + " level(s) dropped";
+    return state;
+}
+
+// GL thread only (it deletes textures). Caller holds g_registryMutex.
+static void EvictIdleLocked() {
+    while (g_stats.idleBytes > TEXTURE_CACHE_IDLE_BYTES || GpuMemoryOverBudget() > 0) {
+        auto victim = g_entries.end();
+        for (auto it = g_entries.begin(); it != g_entries.end(); ++it)
+            if (it->second.refs == 0 && (victim == g_entries.end() || it->second.lastUse < victim->second.lastUse))
+                victim = it;
+        if (victim == g_entries.end()) break;
+        TextureEntry& entry = victim->second;
+        UntrackGpuMemory(GpuMemoryKind::MaterialTexture, entry.texture);
+        glDeleteTextures(1, &entry.texture);
+        g_stats.idleBytes -= entry.bytes;
+        g_stats.residentBytes -= entry.bytes;
+        --g_stats.textures;
+        ++g_stats.evictions;
+        g_textureKeys.erase(entry.texture);
+        g_entries.erase(victim);
+    }
+}
+
+static size_t EntryLevelSize(const TextureEntry& entry, int level) {
+    int width = std::max(entry.width >> level, 1), height = std::max(entry.height >> level, 1);
+    if (entry.compression != TextureCompression::None) return CompressedLevelSize(entry.compression, width, height);
+    return static_cast<size_t>(width) * height * entry.channels;
+}
+
+static void ReleaseTexture(GLuint texture) {
+    if (!texture) return;
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    auto key = g_textureKeys.find(texture);
+    if (key == g_textureKeys.end()) {
+        glDeleteTextures(1, &texture); // fallback / foreign texture
+        return;
+    }
+    TextureEntry& entry = g_entries[key->second];
+    entry.lastUse = ++g_useClock;
+    if (--entry.refs == 0) {
+        g_stats.idleBytes += entry.bytes;
+        SetGpuMemoryState(GpuMemoryKind::MaterialTexture, texture, MemoryState(entry));
+        EvictIdleLocked();
+    }
+}
+
+// Points `target` at a texture it already holds a reference to, dropping the previous one
+static void AssignTarget(GLuint* target, GLuint texture) {
+    GLuint previous = *target;
+    *target = texture;
+    if (texture) {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        auto key = g_textureKeys.find(texture);
+        if (key != g_textureKeys.end()) {
+            TextureEntry& entry = g_entries[key->second];
+            entry.lastUse = ++g_useClock;
+            SetGpuMemoryState(GpuMemoryKind::MaterialTexture, texture, MemoryState(entry));
+        }
+    }
+    ReleaseTexture(previous);
+}
+
+// Pins the resident texture for `key` if there is one (so it can't be evicted before the GL thread takes it)
+static bool PinResident(TextureRequest& request) {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    request.reused = AcquireLocked(request.key);
+    return request.reused != 0;
+}
+
+static void UseCachedLevels(TextureRequest& request, const TextureCacheInfo& cached) {
+    for (int level = 0; level < cached.levelCount() && (level == 0 || request.options.generateMipmaps); ++level)
+        request.levels.push_back({ cached.level(level).data, std::max(cached.width >> level, 1),
+                                   std::max(cached.height >> level, 1), cached.level(level).size });
+    if (!IsCompressedFormat(cached.format)) request.channels = TexelChannels(cached.format);
+    request.fromCache = true;
+    request.ok = true;
+}
+
+// A cache (or container) the upload can use: 8-bit or block-compressed 2D texels,
+// with the whole mip chain when one was asked for
+static bool CacheUsable(const TextureRequest& request, const TextureCacheInfo& cached) {
+    return cached.faces == 1 && !IsHalfFormat(cached.format) &&
+           (!request.options.generateMipmaps || cached.levelCount() == MipLevelCount(cached.width, cached.height));
+}
+
+// Flips decoded `pixels` and builds the mip chain, compresses it unless the request is
+// uncompressed, and writes the result to `cachePath` (or the per-image cache when empty)
+static bool PrepareLevels(TextureRequest& request, unsigned char* pixels, int width, int height, int channels,
+                          const std::string& packedCachePath) {
+    const TextureOptions& options = request.options;
+    // stbi_set_flip_vertically_on_load is process-wide, so decodes running side by side
+    // can't use it; rows are flipped here instead.
+    if (options.flipY) FlipRows(pixels, height, static_cast<size_t>(width) * channels);
+
+    if (!GenerateMipChain(pixels, width, height, channels, options.mips, request.mips, options.generateMipmaps ? 0 : 1))
+        return false;
+    request.pixels.reset();
+    request.packedPixels = std::vector<unsigned char>();
+
+    TextureCacheInfo image;
+    if (options.compression == TextureCompression::None) {
+        request.channels = channels;
+        image = DescribeTextureImage(request.mips);
+    } else {
+        if (!PrepareCompressedImage(request.mips, options.compression, request.compressed)) return false;
+        image = DescribeTextureImage(request.compressed);
+    }
+    for (int level = 0; level < image.levelCount(); ++level)
+        request.levels.push_back({ image.level(level).data, std::max(width >> level, 1), std::max(height >> level, 1),
+                                   image.level(level).size });
+
+    if (options.compression != TextureCompression::None) {
+        // Hand levels to the GL thread as they are encoded, smallest first: the tail
+        // is on screen long before the top level (most of the work) is done
+        request.readyFrom.store(request.levels.size(), std::memory_order_relaxed);
+        request.prepared.store(true, std::memory_order_release);
+        for (size_t level = request.levels.size(); level-- > 0;) {
+            CompressImageLevel(request.mips, level, request.compressed);
+            request.readyFrom.store(level, std::memory_order_release);
+        }
+        request.mips = MipChain();
+    }
+
+    const uint32_t mipKey = MipOptionsKey(options.mips);
+    if (packedCachePath.empty())
+        WriteTextureCache(request.paths[0], options.flipY, mipKey, request.contentHash, image);
+    else
+        WritePackedTextureCache(packedCachePath, options.flipY, mipKey, request.contentHash, image);
+    return true;
+}
+
+static unsigned char* DecodeImage(const std::string& path, const MappedFile& file, int& width, int& height, int& channels) {
+    unsigned char* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height,
+                                                  &channels, 0);
+    if (!pixels) {
+        std::cerr << "Failed to load texture at: " << path << std::endl;
+        std::cerr << "STB Error: " << stbi_failure_reason() << std::endl;
+        return nullptr;
+    }
+    if (channels < 1 || channels > 4) {
+        std::cerr << "Unexpected number of channels: " << channels << std::endl;
+        stbi_image_free(pixels);
+        return nullptr;
+    }
+    return pixels;
+}
+
+// A .pbrtex picked directly: uploaded as stored, whatever the options' encoding
+static void OpenContainerTexture(TextureRequest& request) {
+    const std::string& path = request.paths[0];
+    TextureCacheInfo info;
+    if (!OpenTextureFile(path, request.cacheFile, info) || info.faces != 1 || IsHalfFormat(info.format)) {
+        std::cerr << "Not a 2D texture file: " << path << std::endl;
+        return;
+    }
+    request.contentHash = HashBytes(request.cacheFile.data(), request.cacheFile.size());
+    request.key = TextureKey(request.contentHash, request.options);
+    if (PinResident(request)) {
+        request.ok = true;
+        return;
+    }
+    request.options.compression =
+        IsCompressedFormat(info.format) ? static_cast<TextureCompression>(info.format) : TextureCompression::None;
+    UseCachedLevels(request, info);
+}
+
+static void DecodeTexture(TextureRequest& request) {
+    const TextureOptions& options = request.options;
+    const std::string& path = request.paths[0];
+    if (std::filesystem::path(path).extension() == ".pbrtex") {
+        OpenContainerTexture(request);
+        return;
+    }
+
+    // Decoded before: the cache knows the content hash, so the source isn't even read
+    TextureCacheInfo cached;
+    if (OpenTextureCache(path, options.compression, options.flipY, MipOptionsKey(options.mips), request.cacheFile,
+                         cached) &&
+        CacheUsable(request, cached)) {
+        request.contentHash = cached.contentHash;
+        request.key = TextureKey(request.contentHash, options);
+        if (PinResident(request)) {
+            request.ok = true;
+            return;
+        }
+        UseCachedLevels(request, cached);
+        return;
+    }
+    request.cacheFile.close();
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Failed to load texture at: " << path << std::endl;
+        return;
+    }
+    request.contentHash = HashBytes(file.data(), file.size());
+    request.key = TextureKey(request.contentHash, options);
+    // Same image already on the GPU (other path or slot)
+    if (PinResident(request)) {
+        request.ok = true;
+        return;
+    }
+
+    int width = 0, height = 0, channels = 0;
+    unsigned char* pixels = DecodeImage(path, file, width, height, channels);
+    if (!pixels) return;
+    request.pixels.reset(pixels);
+    request.ok = PrepareLevels(request, pixels, width, height, channels, std::string());
+}
+
+// Several maps, first channel of each, into one texture; cached by the inputs' combined hash
+static void DecodePackedTexture(TextureRequest& request) {
+    const TextureOptions& options = request.options;
+    const size_t count = request.paths.size();
+
+    std::vector<MappedFile> files(count);
+    std::vector<uint64_t> hashes(count + 1, 0);
+    hashes[count] = count;
+    std::string directory;
+    for (size_t c = 0; c < count; ++c) {
+        if (request.paths[c].empty()) continue; // constant channel
+        if (!files[c].open(request.paths[c])) {
+            std::cerr << "Failed to load texture at: " << request.paths[c] << std::endl;
+            return;
+        }
+        hashes[c] = HashBytes(files[c].data(), files[c].size());
+        if (directory.empty()) directory = std::filesystem::path(request.paths[c]).parent_path().string();
+    }
+    request.contentHash = HashBytes(hashes.data(), hashes.size() * sizeof(uint64_t));
+    request.key = TextureKey(request.contentHash, options);
+    if (PinResident(request)) {
+        request.ok = true;
+        return;
+    }
+
+    std::string cachePath = PackedTextureCachePath(directory.empty() ? "." : directory, request.contentHash);
+    TextureCacheInfo cached;
+    if (OpenPackedTextureCache(cachePath, options.compression, options.flipY, MipOptionsKey(options.mips),
+                               request.contentHash, request.cacheFile, cached) &&
+        CacheUsable(request, cached)) {
+        UseCachedLevels(request, cached);
+        return;
+    }
+    request.cacheFile.close();
+
+    std::vector<std::unique_ptr<unsigned char, StbiDeleter>> decoded(count);
+    std::vector<ChannelSource> sources(count);
+    for (size_t c = 0; c < count; ++c) {
+        if (!files[c].isOpen()) continue;
+        ChannelSource& source = sources[c];
+        decoded[c].reset(DecodeImage(request.paths[c], files[c], source.width, source.height, source.channels));
+        if (!decoded[c]) return;
+        source.pixels = decoded[c].get();
+    }
+    int width = 0, height = 0;
+    if (!PackChannels(sources.data(), static_cast<int>(count), request.packedPixels, width, height)) return;
+    decoded.clear();
+    request.ok = PrepareLevels(request, request.packedPixels.data(), width, height, static_cast<int>(count), cachePath);
+}
+
+// Common part of the public requests: supersede, memo lookup, queue
+static void QueueRequest(const std::shared_ptr<TextureRequest>& request) {
+    for (auto& pending : g_requests)
+        if (pending->target == request->target) pending->superseded = true;
+
+    request->options.compression = EffectiveTextureCompression(request->options);
+    if (DefaultMipFilter() == MipFilter::Box) request->options.mips.filter = MipFilter::Box;
+    request->stamped = true;
+    for (const std::string& path : request->paths) {
+        FileStamp stamp;
+        request->stamped = request->stamped && (path.empty() || StampFile(path, stamp));
+        request->stamps.push_back(stamp);
+    }
+    request->queued = std::chrono::steady_clock::now();
+
+    // Unchanged files we've hashed before: if their texture is resident, no I/O at all
+    auto memo = g_pathHashes.find(request->name);
+    if (request->stamped && memo != g_pathHashes.end() && memo->second.first == request->stamps) {
+        GLuint texture;
+        {
+            std::lock_guard<std::mutex> lock(g_registryMutex);
+            texture = AcquireLocked(TextureKey(memo->second.second, request->options));
+            if (texture) ++g_stats.hits;
+        }
+        if (texture) {
+            AssignTarget(request->target, texture);
+            return;
+        }
+    }
+
+    g_requests.push_back(request);
+    RunAsync([request]() {
+        auto t0 = std::chrono::steady_clock::now();
+        request->error = CaptureJobError([&]() {
+            if (request->paths.size() == 1)
+                DecodeTexture(*request);
+            else
+                DecodePackedTexture(*request);
+        });
+        if (!request->error.empty()) {
+            request->ok = false;
+            // Levels the encoder never reached stay blank, but the GL thread can finish the texture
+            request->readyFrom.store(0, std::memory_order_release);
+        }
+        request->decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        request->decoded.store(true, std::memory_order_release);
+    });
+}
+
+void RequestTexture2D(GLuint* target, const std::string& path, const TextureOptions& options) {
+    auto request = std::make_shared<TextureRequest>();
+    request->target = target;
+    request->paths = { path };
+    request->name = path;
+    request->options = options;
+    QueueRequest(request);
+}
+
+void RequestPackedTexture2D(GLuint* target, const std::vector<std::string>& channelPaths, const TextureOptions& options) {
+    auto request = std::make_shared<TextureRequest>();
+    request->target = target;
+    request->paths = channelPaths;
+    request->name = "packed(";
+    for (size_t c = 0; c < channelPaths.size(); ++c)
+        request->name += (c ? ", " : "") + (channelPaths[c].empty() ? std::string("-") : channelPaths[c]);
+    request->name += ")";
+    request->options = options;
+    QueueRequest(request);
+}
+
+void ReleaseTexture2D(GLuint* target) {
+    for (auto& pending : g_requests)
+        if (pending->target == target) pending->superseded = true;
+    AssignTarget(target, 0);
+}
+
+static GLenum ChannelFormat(int channels) {
+    switch (channels) {
+    case 1: return GL_RED;
+    case 2: return GL_RG;  // grayscale + alpha
+    case 3: return GL_RGB;
+    default: return GL_RGBA;
+    }
+}
+
+GLenum TextureInternalFormat(const TextureOptions& options, int channels) {
+    bool srgb = options.colorSpace == TextureColorSpace::SRGB;
+    switch (options.compression) {
+    case TextureCompression::BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureCompression::BC4: return GL_COMPRESSED_RED_RGTC1;
+    case TextureCompression::BC5: return GL_COMPRESSED_RG_RGTC2;
+    case TextureCompression::None: break;
+    }
+    if (srgb && channels >= 3)
+        return channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+    return ChannelFormat(channels);
+}
+
+static GLenum InternalFormat(const TextureRequest& request) {
+    return TextureInternalFormat(request.options, request.channels);
+}
+
+static GLuint CreateWhiteTexture() {
+    // default 1x1 white texture instead of leaving the slot at 0
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    unsigned char white[] = { 255, 255, 255, 255 };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    return texture;
+}
+
+static void AllocateTexture(TextureRequest& request) {
+    const bool compressed = request.options.compression != TextureCompression::None;
+    const GLenum internalFormat = InternalFormat(request);
+    const GLint levelCount = static_cast<GLint>(request.levels.size());
+    const bool mipmapped = request.options.generateMipmaps && levelCount > 1;
+
+    glGenTextures(1, &request.texture);
+    glBindTexture(GL_TEXTURE_2D, request.texture);
+    // Texture sampling and wrapping behavior
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // Levels arrive smallest first; sampling is clamped to the ones already there
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    request.pendingLevels = request.levels.size();
+    for (GLint level = 0; level < levelCount; ++level) {
+        const UploadLevel& l = request.levels[level];
+        if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, l.width, l.height, 0,
+                                   static_cast<GLsizei>(l.size), nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, l.width, l.height, 0, ChannelFormat(request.channels),
+                         GL_UNSIGNED_BYTE, nullptr);
+    }
+}
+
+// Streams rows of `request`, smallest level first, until levels [stopLevel, count) are up or
+// the next level isn't encoded yet, lowering GL_TEXTURE_BASE_LEVEL as each one completes.
+// Returns false when it ran out of budget or the next ring slot is still in flight.
+static bool UploadRows(TextureRequest& request, size_t& budget, bool wait, size_t stopLevel) {
+    const bool compressed = request.options.compression != TextureCompression::None;
+    if (request.texture == 0) AllocateTexture(request);
+    glBindTexture(GL_TEXTURE_2D, request.texture);
+
+    for (; request.pendingLevels > stopLevel; --request.pendingLevels, request.nextRow = 0) {
+        const size_t mip = request.pendingLevels - 1;
+        if (mip < request.readyFrom.load(std::memory_order_acquire)) return true; // encoder still on it
+        const UploadLevel& level = request.levels[mip];
+        // A "row" is one pixel row, or one row of 4x4 blocks
+        const int rowHeight = compressed ? 4 : 1;
+        const int rowCount = (level.height + rowHeight - 1) / rowHeight;
+        const size_t rowBytes = level.size / rowCount;
+
+        while (request.nextRow < rowCount) {
+            PboSlot& slot = g_ring[g_nextSlot];
+            if (slot.fence) {
+                GLenum status = glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                                 wait ? 1000000000ull : 0);
+                if (status == GL_TIMEOUT_EXPIRED) return false; // GPU still reading this slot
+                glDeleteSync(slot.fence);
+                slot.fence = nullptr;
+            }
+
+            size_t rows = std::max<size_t>(1, TEXTURE_PBO_SLOT_BYTES / rowBytes);
+            rows = std::min(rows, static_cast<size_t>(rowCount - request.nextRow));
+            size_t bytes = rows * rowBytes;
+            if (bytes > budget) {
+                if (budget < rowBytes) return false;
+                rows = budget / rowBytes;
+                bytes = rows * rowBytes;
+            }
+            const unsigned char* source = level.data + request.nextRow * rowBytes;
+            GLint y = request.nextRow * rowHeight;
+            GLsizei height = std::min(static_cast<GLsizei>(rows) * rowHeight, level.height - y);
+
+            if (slot.buffer == 0) glGenBuffers(1, &slot.buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            if (slot.size < bytes) {
+                slot.size = std::max(bytes, TEXTURE_PBO_SLOT_BYTES);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, slot.size, nullptr, GL_STREAM_DRAW);
+            }
+            void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            const void* pixels = nullptr; // offset 0 in the bound PBO
+            if (mapped) {
+                std::memcpy(mapped, source, bytes);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            } else {
+                // Mapping failed (out of memory?): fall back to a plain client-memory upload
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                pixels = source;
+            }
+            if (compressed)
+                glCompressedTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(mip), 0, y, level.width, height, InternalFormat(request),
+                                          static_cast<GLsizei>(bytes), pixels);
+            else
+                glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(mip), 0, y, level.width, height, ChannelFormat(request.channels),
+                                GL_UNSIGNED_BYTE, pixels);
+            if (mapped) {
+                slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                g_nextSlot = (g_nextSlot + 1) % TEXTURE_PBO_RING_SIZE;
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            request.nextRow += static_cast<int>(rows);
+            budget -= bytes;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(mip));
+    }
+    return true;
+}
+
+// Largest level small enough to go up right away (or the only one): levels from here down
+// are uploaded before the texture replaces the target's old one
+static size_t TailLevel(const TextureRequest& request) {
+    size_t level = 0;
+    while (level + 1 < request.levels.size() &&
+           std::max(request.levels[level].width, request.levels[level].height) > TEXTURE_STREAM_TAIL_SIZE)
+        ++level;
+    return level;
+}
+
+static size_t LevelBytes(const TextureRequest& request) {
+    size_t bytes = 0;
+    for (const UploadLevel& level : request.levels) bytes += level.size;
+    return bytes;
+}
+
+// Adds a texture whose tail is up to the registry, with the target's reference and one
+// the request keeps until the last level is in (so it can't be evicted half streamed)
+static void RegisterTexture(const TextureRequest& request) {
+    size_t bytes = LevelBytes(request); // every level is allocated up front
+
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    TextureEntry& entry = g_entries[request.key];
+    entry.texture = request.texture;
+    entry.bytes = bytes;
+    entry.refs = 2;
+    entry.lastUse = ++g_useClock;
+    entry.path = request.name;
+    entry.compression = request.options.compression;
+    entry.internalFormat = InternalFormat(request);
+    entry.channels = request.channels;
+    entry.width = request.levels[0].width;
+    entry.height = request.levels[0].height;
+    entry.levelCount = static_cast<int>(request.levels.size());
+    TrackGpuMemory(GpuMemoryKind::MaterialTexture, request.texture, bytes, request.name, MemoryState(entry));
+    g_textureKeys[request.texture] = request.key;
+    g_stats.residentBytes += bytes;
+    ++g_stats.textures;
+    ++g_stats.misses;
+}
+
+static const char* CompressionName(TextureCompression compression) {
+    switch (compression) {
+    case TextureCompression::BC1: return "BC1";
+    case TextureCompression::BC4: return "BC4";
+    case TextureCompression::BC5: return "BC5";
+    case TextureCompression::None: break;
+    }
+    return "uncompressed";
+}
+
+// Handles everything about a request short of uploading: supersede, failure, and images that are
+// resident already. Returns false when the request is finished with.
+static bool ResolveRequest(TextureRequest& request) {
+    if (request.visible) return true; // registered; only its larger levels are left
+    bool decoded = request.decoded.load(std::memory_order_acquire);
+    if (request.superseded) {
+        if (!decoded) return true;
+        if (request.texture) glDeleteTextures(1, &request.texture);
+        ReleaseTexture(request.reused);
+        return false; // the decode job holds its own reference
+    }
+    if (!decoded && !request.prepared.load(std::memory_order_acquire)) return true;
+    if (decoded && !request.ok) {
+        if (!request.error.empty())
+            std::cerr << "Texture load failed: " << request.name << ": " << request.error << std::endl;
+        if (request.texture) glDeleteTextures(1, &request.texture); // allocated for a tail that never came
+        if (*request.target == 0) *request.target = CreateWhiteTexture();
+        return false;
+    }
+    if (request.stamped)
+        g_pathHashes[request.name] = { request.stamps, request.contentHash };
+
+    // Resident already: found by the job, or uploaded by an identical request since
+    GLuint shared = 0;
+    if (request.reused) {
+        shared = request.reused; // pinned with the registry locked: no map lookup outside it
+    } else if (request.texture == 0) {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        shared = AcquireLocked(request.key);
+    }
+    if (!shared) return true;
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        ++g_stats.hits;
+    }
+    AssignTarget(request.target, shared);
+    return false;
+}
+
+static void UpdateTextureStreaming(size_t byteBudget, bool wait) {
+    if (g_requests.empty()) return;
+
+    // Rows are tightly packed (RGB widths need not be a multiple of 4)
+    GLint previousAlignment, previousTexture;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    size_t budget = byteBudget;
+    bool stalled = false; // keep the ring and budget for requests in order
+    const auto now = std::chrono::steady_clock::now();
+
+    // Tails first, so every new texture replaces its target's old one within a frame or two...
+    for (size_t i = 0; i < g_requests.size();) {
+        TextureRequest& request = *g_requests[i];
+        if (!ResolveRequest(request)) {
+            g_requests.erase(g_requests.begin() + i);
+            continue;
+        }
+        ++i;
+        bool uploadable = request.decoded.load(std::memory_order_acquire) ||
+                          request.prepared.load(std::memory_order_acquire);
+        if (request.visible || request.superseded || !uploadable || stalled) continue;
+        stalled = !UploadRows(request, budget, wait, TailLevel(request));
+        if (request.pendingLevels > TailLevel(request)) continue;
+
+        RegisterTexture(request);
+        AssignTarget(request.target, request.texture);
+        request.visible = true;
+        request.visibleSeconds = std::chrono::duration<double>(now - request.queued).count();
+    }
+
+    // ...then their larger levels, textures still assigned ahead of superseded ones
+    for (int superseded = 0; superseded < 2; ++superseded)
+        for (auto& request : g_requests)
+            if (!stalled && request->visible && request->superseded == (superseded == 1))
+                stalled = !UploadRows(*request, budget, wait, 0);
+
+    for (size_t i = 0; i < g_requests.size();) {
+        TextureRequest& request = *g_requests[i];
+        if (!request.visible || request.pendingLevels > 0 || !request.decoded.load(std::memory_order_acquire)) {
+            ++i;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_registryMutex);
+            TextureEntry& entry = g_entries.at(request.key);
+            entry.complete = true;
+            SetGpuMemoryState(GpuMemoryKind::MaterialTexture, request.texture, MemoryState(entry));
+        }
+        ReleaseTexture(request.texture); // the streaming reference; the target keeps its own
+        if (!request.error.empty()) {
+            std::cerr << "Texture encode failed after its tail was shown: " << request.name << ": " << request.error
+                      << std::endl;
+            g_requests.erase(g_requests.begin() + i);
+            continue;
+        }
+        double total = std::chrono::duration<double>(std::chrono::steady_clock::now() - request.queued).count();
+        std::cout << "Loaded texture " << request.name << " (" << request.levels[0].width << "x"
+                  << request.levels[0].height << ", " << CompressionName(request.options.compression) << ", "
+                  << LevelBytes(request) / 1024 << " KB" << (request.fromCache ? ", from cache" : "") << "): "
+                  << (request.fromCache ? "map " : "decode ") << request.decodeSeconds * 1000.0
+                  << " ms, visible after " << request.visibleSeconds * 1000.0 << " ms, complete after "
+                  << total * 1000.0 << " ms" << std::endl;
+        g_requests.erase(g_requests.begin() + i);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+}
+
+// Gives up the top level of `entry` (a quarter of the size): reads levels 1.. back and
+// redefines them one level up, so the texture keeps its name and every target stays valid.
+// Caller holds g_registryMutex.
+static void DropTopLevelLocked(TextureEntry& entry) {
+    const bool compressed = entry.compression != TextureCompression::None;
+    const GLenum format = ChannelFormat(entry.channels);
+    GLint previousTexture, previousPack, previousUnpack;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousPack);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpack);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+
+    std::vector<std::vector<unsigned char>> levels;
+    for (int level = 1; level < entry.levelCount; ++level) {
+        levels.emplace_back(EntryLevelSize(entry, level));
+        if (compressed)
+            glGetCompressedTexImage(GL_TEXTURE_2D, level, levels.back().data());
+        else
+            glGetTexImage(GL_TEXTURE_2D, level, format, GL_UNSIGNED_BYTE, levels.back().data());
+    }
+    const size_t freed = EntryLevelSize(entry, 0);
+    entry.width = std::max(entry.width >> 1, 1);
+    entry.height = std::max(entry.height >> 1, 1);
+    entry.levelCount -= 1;
+    for (int level = 0; level < entry.levelCount; ++level) {
+        const std::vector<unsigned char>& data = levels[level];
+        int width = std::max(entry.width >> level, 1), height = std::max(entry.height >> level, 1);
+        if (compressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, entry.internalFormat, width, height, 0,
+                                   static_cast<GLsizei>(data.size()), data.data());
+        else
+            glTexImage2D(GL_TEXTURE_2D, level, entry.internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE,
+                         data.data());
+    }
+    // The old 1x1 level past the new end stays defined but unused
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.levelCount - 1);
+
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(previousTexture));
+    glPixelStorei(GL_PACK_ALIGNMENT, previousPack);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpack);
+
+    entry.bytes -= freed;
+    g_stats.residentBytes -= freed;
+    ++entry.droppedLevels;
+    ++g_stats.downscales;
+    TrackGpuMemory(GpuMemoryKind::MaterialTexture, entry.texture, entry.bytes, entry.path, MemoryState(entry));
+    std::cout << "GPU memory over budget: " << entry.path << " downscaled to " << entry.width << "x" << entry.height
+              << std::endl;
+}
+
+// Over the GPU memory budget: evict idle textures (least recently used first), then
+// drop the top level of the least recently used texture still in use, one per frame
+static void EnforceTextureBudget() {
+    if (GpuMemoryOverBudget() == 0) return;
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    EvictIdleLocked();
+    if (GpuMemoryOverBudget() == 0) return;
+
+    auto victim = g_entries.end();
+    for (auto it = g_entries.begin(); it != g_entries.end(); ++it) {
+        const TextureEntry& entry = it->second;
+        if (entry.complete && entry.levelCount > 1 && std::max(entry.width, entry.height) > TEXTURE_BUDGET_MIN_SIZE &&
+            (victim == g_entries.end() || entry.lastUse < victim->second.lastUse))
+            victim = it;
+    }
+    if (victim == g_entries.end()) return;
+    const bool fullQuality = victim->second.droppedLevels == 0;
+    DropTopLevelLocked(victim->second);
+
+    // The smaller copy must not answer later requests for the full-quality image: they load it
+    // again (from its .pbrtex), and the copy is evicted once its targets have moved on
+    if (fullQuality) {
+        auto node = g_entries.extract(victim);
+        node.key() = DownscaledKey(node.mapped().texture);
+        g_textureKeys[node.mapped().texture] = node.key();
+        g_entries.insert(std::move(node));
+    }
+}
+
+void UpdateTextureStreaming(size_t byteBudget) {
+    UpdateTextureStreaming(byteBudget, false);
+    EnforceTextureBudget();
+}
+
+void FlushTextureLoads() {
+    while (!g_requests.empty()) {
+        UpdateTextureStreaming(static_cast<size_t>(-1), true);
+        if (!g_requests.empty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); // decodes still running
+    }
+}
+
+size_t PendingTextureLoads() {
+    size_t pending = 0;
+    for (const auto& request : g_requests)
+        pending += request->superseded ? 0 : 1;
+    return pending;
+}
+
+TextureCacheStats GetTextureCacheStats() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    return g_stats;
+}
+
+void ShutdownTextureStreaming() {
+    for (auto& request : g_requests)
+        if (request->texture && !request->visible) glDeleteTextures(1, &request->texture); // else the registry's
+    g_requests.clear();
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        for (auto& entry : g_entries) {
+            UntrackGpuMemory(GpuMemoryKind::MaterialTexture, entry.second.texture);
+            glDeleteTextures(1, &entry.second.texture);
+        }
+        g_entries.clear();
+        g_textureKeys.clear();
+        g_stats = TextureCacheStats();
+    }
+    g_pathHashes.clear();
+    for (PboSlot& slot : g_ring) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.buffer) glDeleteBuffers(1, &slot.buffer);
+        slot = PboSlot();
+    }
+}
@@ -0,0 +1,105 @@
+// texture_loader.h
+#pragma once
+#include <glad/glad.h>
+#include "texture_compress.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Asynchronous 2D texture loading
+// ─────
+// Images are decoded on the job system (several at once), then streamed to the
+// GPU from the GL thread through a small ring of pixel buffer objects: each
+// frame copies at most a fixed budget of rows into a PBO and issues
+// glTexSubImage2D from it, so the transfer itself runs asynchronously. A ring
+// slot is only reused once its fence has signaled, so nothing ever waits on the
+// GPU. Mip levels are filtered on the CPU with the decode (texture_mips.h) and
+// streamed smallest first: once the tail (levels up to TEXTURE_STREAM_TAIL_SIZE,
+// a few KB) is up, the new texture replaces the target's old one, and each larger
+// level that arrives after lowers GL_TEXTURE_BASE_LEVEL, so the image sharpens
+// over the next frames instead of the old one lingering until the top level is in.
+// Fresh block-compressed images hand their levels over as they are encoded.
+const size_t TEXTURE_PBO_RING_SIZE = 4;
+const size_t TEXTURE_PBO_SLOT_BYTES = 4 << 20;  // per slot, so one frame streams at most 16 MB
+const int TEXTURE_STREAM_TAIL_SIZE = 128;       // largest level shown before the rest
+
+// ─────────────────────────────────────────────
+// Texture registry
+// ─────
+// Loaded textures are keyed by a hash of the file contents plus the load
+// options, so identical images share one GPU texture no matter which path
+// or material slot asked for them. Targets hold a reference; a texture nobody
+// references stays resident (up to TEXTURE_CACHE_IDLE_BYTES, least recently
+// released evicted first), so switching back to a recent material is free.
+// A (path, size, mtime) -> content hash memo skips the file read entirely
+// when an unchanged file is selected again.
+// Registry textures count against the GPU memory budget (gpu_memory.h). While the
+// total is over it, idle textures are evicted first, least recently used first;
+// then, one per frame, the least recently used texture in use gives up its top
+// mip level (read back and redefined in place, so targets keep their ids), down
+// to TEXTURE_BUDGET_MIN_SIZE. A downscaled texture stays that way until evicted, but
+// leaves the shared key: a later request for the image loads it at full quality again.
+const size_t TEXTURE_CACHE_IDLE_BYTES = 256u << 20;
+const int TEXTURE_BUDGET_MIN_SIZE = 256;
+
+enum class TextureColorSpace { Linear, SRGB }; // SRGB uses GL_SRGB8(_ALPHA8) storage
+
+struct TextureOptions {
+    bool generateMipmaps = true;
+    bool flipY = true;
+    TextureColorSpace colorSpace = TextureColorSpace::Linear;
+    // Block-compressed upload with a precomputed mip chain, cached in a .pbrtex next to the image.
+    // BC1 needs EXT_texture_compression_s3tc (falls back to None without it);
+    // PBR_TEXTURE_COMPRESSION=none turns compression off for comparison.
+    TextureCompression compression = TextureCompression::None;
+    // How the mip chain is filtered (color space, normals, roughness channel).
+    // PBR_MIP_FILTER=box replaces the Kaiser filter for comparison.
+    MipOptions mips;
+};
+
+// Queues a load of `path` whose result replaces *target. A .pbrtex file is uploaded as stored
+// (its own encoding and mips, whatever `options` ask for). `target` must stay valid until the
+// load completes (globals / long-lived members). A newer request for the same target
+// supersedes this one (one already shown still finishes its larger levels, after the others).
+// On failure the old texture is kept (a 1x1 white one if there was none). A resident texture is
+// assigned immediately.
+void RequestTexture2D(GLuint* target, const std::string& path, const TextureOptions& options = TextureOptions());
+
+// Packs the first channel of each image into one texture (channel i <- channelPaths[i], up to 4;
+// "" fills that channel with white), resampled to the largest input. The result is cached by the
+// inputs' content, so packing a given combination happens once. See material_pack.h for roughness / metallic.
+void RequestPackedTexture2D(GLuint* target, const std::vector<std::string>& channelPaths,
+                            const TextureOptions& options = TextureOptions());
+
+// What `options` end up as on this driver / environment: BC1 without S3TC support (or with
+// PBR_TEXTURE_COMPRESSION=none) is uncompressed
+TextureCompression EffectiveTextureCompression(const TextureOptions& options);
+// GL internal format for textures loaded with (effective) `options`; `channels` matters uncompressed
+GLenum TextureInternalFormat(const TextureOptions& options, int channels);
+
+// Drops the target's reference (or deletes a texture the registry doesn't own) and zeroes it
+void ReleaseTexture2D(GLuint* target);
+
+// Once per frame on the GL thread: uploads up to `byteBudget` bytes of decoded images and
+// enforces the GPU memory budget
+void UpdateTextureStreaming(size_t byteBudget = TEXTURE_PBO_RING_SIZE * TEXTURE_PBO_SLOT_BYTES);
+
+// Blocks until every queued texture is on the GPU (startup: all decodes still run in parallel)
+void FlushTextureLoads();
+
+size_t PendingTextureLoads();
+
+struct TextureCacheStats {
+    size_t hits = 0;          // requests served by an already resident texture
+    size_t misses = 0;        // requests that had to decode and upload
+    size_t textures = 0;      // resident textures
+    size_t residentBytes = 0; // all resident textures (mip chains included)
+    size_t idleBytes = 0;     // the part no target currently references
+    size_t evictions = 0;     // idle textures deleted (idle limit or GPU memory budget)
+    size_t downscales = 0;    // top levels dropped to stay within the budget
+    float hitRate() const { return hits + misses ? static_cast<float>(hits) / (hits + misses) : 0.0f; }
+};
+TextureCacheStats GetTextureCacheStats();
+
+void ShutdownTextureStreaming(); // frees the registry and the PBO ring; call before the context goes away
@@ -0,0 +1,402 @@
+// texture_mips.cpp
+#include "texture_mips.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXMIPS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+int MipLevelCount(int width, int height) {
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size >>= 1) ++levels;
+    return levels;
+}
+
+void FlipRows(unsigned char* pixels, int height, size_t rowBytes) {
+    std::vector<unsigned char> row(rowBytes);
+    for (int y = 0; y < height / 2; ++y) {
+        unsigned char* top = pixels + y * rowBytes;
+        unsigned char* bottom = pixels + (height - 1 - y) * rowBytes;
+        std::memcpy(row.data(), top, rowBytes);
+        std::memcpy(top, bottom, rowBytes);
+        std::memcpy(bottom, row.data(), rowBytes);
+    }
+}
+
+MipFilter DefaultMipFilter() {
+    static const MipFilter filter = [] {
+        const char* env = std::getenv("PBR_MIP_FILTER");
+        return env && std::strcmp(env, "box") == 0 ? MipFilter::Box : MipFilter::Kaiser;
+    }();
+    return filter;
+}
+
+uint32_t MipOptionsKey(const MipOptions& options) {
+    return static_cast<uint32_t>(options.filter) | (options.srgb ? 1u << 8 : 0u) | (options.normalMap ? 1u << 9 : 0u) |
+           (options.wrap ? 1u << 10 : 0u) | (static_cast<uint32_t>(options.roughnessChannel + 1) & 0xFu) << 12;
+}
+
+// ─────────────────────────────────────────────
+// Filter kernels
+// ─────
+// Float RGBA texels, `faces` images of width x height back to back
+struct LinearImage {
+    int width = 0;
+    int height = 0;
+    int faces = 0;
+    std::vector<float> texels;
+
+    void resize(int w, int h, int f) {
+        width = w;
+        height = h;
+        faces = f;
+        texels.resize(static_cast<size_t>(w) * h * f * 4);
+    }
+    float* row(int face, int y) { return texels.data() + ((static_cast<size_t>(face) * height + y) * width) * 4; }
+    const float* row(int face, int y) const {
+        return texels.data() + ((static_cast<size_t>(face) * height + y) * width) * 4;
+    }
+};
+
+// For every destination texel along one axis: `count` source indices and weights (zero padded)
+struct FilterTaps {
+    int count = 0;
+    std::vector<int> index;
+    std::vector<float> weight;
+};
+
+static double BesselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32 && term > sum * 1e-12; ++k) {
+        term *= (x * 0.5 / k) * (x * 0.5 / k);
+        sum += term;
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc, `x` in destination texels. Width 3 and alpha 4 are the usual
+// texture-tool parameters: a sharp low-pass with little ringing.
+static double KaiserWeight(double x) {
+    const double width = 3.0, alpha = 4.0, pi = 3.14159265358979323846;
+    if (std::fabs(x) >= width) return 0.0;
+    double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+    double t = x / width;
+    return sinc * BesselI0(alpha * std::sqrt(1.0 - t * t)) / BesselI0(alpha);
+}
+
+static FilterTaps BuildTaps(MipFilter filter, int srcSize, int dstSize, bool wrap) {
+    FilterTaps taps;
+    const double scale = static_cast<double>(srcSize) / dstSize;
+    const double radius = srcSize == dstSize ? 0.5 : filter == MipFilter::Kaiser ? 3.0 * scale : 0.5 * scale;
+    std::vector<std::vector<std::pair<int, double>>> perTexel(dstSize);
+    for (int i = 0; i < dstSize; ++i) {
+        const double center = (i + 0.5) * scale; // in source texels
+        double sum = 0.0;
+        for (int j = static_cast<int>(std::floor(center - radius)); j <= static_cast<int>(std::ceil(center + radius)); ++j) {
+            double w;
+            if (srcSize == dstSize)
+                w = j == i ? 1.0 : 0.0;
+            else if (filter == MipFilter::Kaiser)
+                w = KaiserWeight((j + 0.5 - center) / scale);
+            else // box: the part of texel j inside the footprint
+                w = std::max(0.0, std::min(j + 1.0, center + radius) - std::max(static_cast<double>(j), center - radius));
+            if (w == 0.0) continue;
+            int source = wrap ? ((j % srcSize) + srcSize) % srcSize : std::min(std::max(j, 0), srcSize - 1);
+            perTexel[i].push_back({ source, w });
+            sum += w;
+        }
+        for (auto& tap : perTexel[i]) tap.second /= sum;
+        taps.count = std::max(taps.count, static_cast<int>(perTexel[i].size()));
+    }
+    taps.index.assign(static_cast<size_t>(dstSize) * taps.count, 0);
+    taps.weight.assign(static_cast<size_t>(dstSize) * taps.count, 0.0f);
+    for (int i = 0; i < dstSize; ++i)
+        for (size_t k = 0; k < perTexel[i].size(); ++k) {
+            taps.index[static_cast<size_t>(i) * taps.count + k] = perTexel[i][k].first;
+            taps.weight[static_cast<size_t>(i) * taps.count + k] = static_cast<float>(perTexel[i][k].second);
+        }
+    return taps;
+}
+
+// ─────────────────────────────────────────────
+// Filtering
+// ─────
+enum ChannelKind : uint8_t {
+    CHANNEL_LINEAR,
+    CHANNEL_SRGB,
+    CHANNEL_NORMAL,    // signed [-1, 1] while filtering
+    CHANNEL_ROUGHNESS, // roughness^4 while filtering
+};
+
+struct ChannelLayout {
+    ChannelKind kind[4] = { CHANNEL_LINEAR, CHANNEL_LINEAR, CHANNEL_LINEAR, CHANNEL_LINEAR };
+    bool normals = false;  // renormalize xyz after every level
+    bool rebuildZ = false; // 2-channel normal map: Z derived from XY before filtering
+    bool hdr = false;      // only clamp below (no upper bound)
+};
+
+static ChannelLayout LayoutFor(const MipOptions& options, int channels, bool hdr) {
+    ChannelLayout layout;
+    layout.hdr = hdr;
+    if (hdr) return layout;
+    const int colorChannels = channels >= 3 ? 3 : 1; // gray + alpha, or RGB(A)
+    for (int c = 0; c < channels; ++c) {
+        if (options.normalMap && channels >= 2 && c < 3)
+            layout.kind[c] = CHANNEL_NORMAL;
+        else if (options.srgb && c < colorChannels)
+            layout.kind[c] = CHANNEL_SRGB;
+        if (c == options.roughnessChannel) layout.kind[c] = CHANNEL_ROUGHNESS;
+    }
+    layout.normals = options.normalMap && channels >= 2;
+    layout.rebuildZ = layout.normals && channels == 2;
+    return layout;
+}
+
+static void Accumulate(float* acc, const float* source, float weight, size_t count) {
+#if TEXMIPS_SSE2
+    const __m128 w = _mm_set1_ps(weight);
+    for (size_t i = 0; i < count; i += 4)
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(w, _mm_loadu_ps(source + i))));
+#else
+    for (size_t i = 0; i < count; ++i) acc[i] += weight * source[i];
+#endif
+}
+
+// Clamps to the valid range and renormalizes normals, in place
+static void FinishTexels(float* texels, int count, const ChannelLayout& layout) {
+    for (int x = 0; x < count; ++x) {
+        float* t = texels + x * 4;
+        if (layout.normals) {
+            float length = std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+            if (length > 1e-6f) {
+                t[0] /= length;
+                t[1] /= length;
+                t[2] /= length;
+            } else {
+                t[0] = t[1] = 0.0f; // opposing normals cancelled out: fall back to flat
+                t[2] = 1.0f;
+            }
+        }
+        for (int c = 0; c < 4; ++c) {
+            if (layout.kind[c] == CHANNEL_NORMAL) continue;
+            // Kaiser's negative lobes can overshoot
+            t[c] = layout.hdr ? std::max(t[c], 0.0f) : std::min(std::max(t[c], 0.0f), 1.0f);
+        }
+    }
+}
+
+// Filters `src` into `dst` (already sized): a vertical pass into a row buffer, then a
+// horizontal pass out of it, one destination row per iteration
+static void Downsample(const LinearImage& src, LinearImage& dst, const FilterTaps& tapsX, const FilterTaps& tapsY,
+                       const ChannelLayout& layout) {
+    const size_t rowFloats = static_cast<size_t>(src.width) * 4;
+    ParallelFor(static_cast<size_t>(dst.faces) * dst.height, [&](size_t begin, size_t end) {
+        std::vector<float> column(rowFloats);
+        for (size_t job = begin; job < end; ++job) {
+            const int face = static_cast<int>(job / dst.height), y = static_cast<int>(job % dst.height);
+            std::fill(column.begin(), column.end(), 0.0f);
+            for (int k = 0; k < tapsY.count; ++k) {
+                float w = tapsY.weight[static_cast<size_t>(y) * tapsY.count + k];
+                if (w != 0.0f)
+                    Accumulate(column.data(), src.row(face, tapsY.index[static_cast<size_t>(y) * tapsY.count + k]), w,
+                               rowFloats);
+            }
+
+            float* out = dst.row(face, y);
+            for (int x = 0; x < dst.width; ++x) {
+                const int* index = tapsX.index.data() + static_cast<size_t>(x) * tapsX.count;
+                const float* weight = tapsX.weight.data() + static_cast<size_t>(x) * tapsX.count;
+#if TEXMIPS_SSE2
+                __m128 acc = _mm_setzero_ps();
+                for (int k = 0; k < tapsX.count; ++k)
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(column.data() + index[k] * 4)));
+                _mm_storeu_ps(out + x * 4, acc);
+#else
+                float acc[4] = {};
+                for (int k = 0; k < tapsX.count; ++k)
+                    for (int c = 0; c < 4; ++c) acc[c] += weight[k] * column[index[k] * 4 + c];
+                std::memcpy(out + x * 4, acc, sizeof(acc));
+#endif
+            }
+            FinishTexels(out, dst.width, layout);
+        }
+    }, 0, 4);
+}
+
+// Calls onLevel(level, image) for each level below 0, filtering from the previous one
+template <typename OnLevel>
+static void FilterChain(LinearImage& current, int levelCount, const MipOptions& options, const ChannelLayout& layout,
+                        const OnLevel& onLevel) {
+    LinearImage next;
+    for (int level = 1; level < levelCount; ++level) {
+        int width = std::max(current.width / 2, 1), height = std::max(current.height / 2, 1);
+        FilterTaps tapsX = BuildTaps(options.filter, current.width, width, options.wrap);
+        FilterTaps tapsY = BuildTaps(options.filter, current.height, height, options.wrap);
+        next.resize(width, height, current.faces);
+        Downsample(current, next, tapsX, tapsY, layout);
+        onLevel(level, next);
+        std::swap(current, next);
+    }
+}
+
+// ─────────────────────────────────────────────
+// 8-bit conversion
+// ─────
+static float SRGBToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSRGB(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+static const int SRGB_ENCODE_TABLE_SIZE = 1 << 14; // fine enough for the steep start of the curve
+
+static const float* DecodeTable(ChannelKind kind) {
+    static const std::vector<float> tables = [] {
+        std::vector<float> t(4 * 256);
+        for (int v = 0; v < 256; ++v) {
+            float f = v / 255.0f;
+            t[CHANNEL_LINEAR * 256 + v] = f;
+            t[CHANNEL_SRGB * 256 + v] = SRGBToLinear(f);
+            t[CHANNEL_NORMAL * 256 + v] = f * 2.0f - 1.0f;
+            t[CHANNEL_ROUGHNESS * 256 + v] = f * f * f * f;
+        }
+        return t;
+    }();
+    return tables.data() + kind * 256;
+}
+
+static unsigned char EncodeSRGB(float linear) {
+    static const std::vector<unsigned char> table = [] {
+        std::vector<unsigned char> t(SRGB_ENCODE_TABLE_SIZE);
+        for (int i = 0; i < SRGB_ENCODE_TABLE_SIZE; ++i)
+            t[i] = static_cast<unsigned char>(LinearToSRGB((i + 0.5f) / SRGB_ENCODE_TABLE_SIZE) * 255.0f + 0.5f);
+        return t;
+    }();
+    int i = static_cast<int>(linear * SRGB_ENCODE_TABLE_SIZE);
+    return table[std::min(std::max(i, 0), SRGB_ENCODE_TABLE_SIZE - 1)];
+}
+
+static unsigned char EncodeChannel(float value, ChannelKind kind) {
+    switch (kind) {
+    case CHANNEL_SRGB: return EncodeSRGB(value);
+    case CHANNEL_NORMAL: value = value * 0.5f + 0.5f; break;
+    case CHANNEL_ROUGHNESS: value = std::sqrt(std::sqrt(value)); break;
+    case CHANNEL_LINEAR: break;
+    }
+    return static_cast<unsigned char>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static void DecodeLevel(const unsigned char* pixels, int channels, const ChannelLayout& layout, LinearImage& image) {
+    const float* tables[4];
+    for (int c = 0; c < 4; ++c) tables[c] = DecodeTable(layout.kind[c]);
+    ParallelFor(static_cast<size_t>(image.height), [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const unsigned char* src = pixels + y * image.width * channels;
+            float* dst = image.row(0, static_cast<int>(y));
+            for (int x = 0; x < image.width; ++x, src += channels, dst += 4) {
+                dst[0] = dst[1] = dst[2] = dst[3] = 0.0f;
+                for (int c = 0; c < channels; ++c) dst[c] = tables[c][src[c]];
+                if (layout.rebuildZ) dst[2] = std::sqrt(std::max(0.0f, 1.0f - dst[0] * dst[0] - dst[1] * dst[1]));
+            }
+        }
+    }, 0, 16);
+}
+
+static void EncodeLevel(const LinearImage& image, int channels, const ChannelLayout& layout, unsigned char* pixels) {
+    ParallelFor(static_cast<size_t>(image.height), [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const float* src = image.row(0, static_cast<int>(y));
+            unsigned char* dst = pixels + y * image.width * channels;
+            for (int x = 0; x < image.width; ++x, src += 4, dst += channels)
+                for (int c = 0; c < channels; ++c) dst[c] = EncodeChannel(src[c], layout.kind[c]);
+        }
+    }, 0, 16);
+}
+
+bool GenerateMipChain(const unsigned char* pixels, int width, int height, int channels, const MipOptions& options,
+                      MipChain& out, int maxLevels) {
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) return false;
+
+    int levelCount = MipLevelCount(width, height);
+    if (maxLevels > 0) levelCount = std::min(levelCount, maxLevels);
+    out.width = width;
+    out.height = height;
+    out.channels = channels;
+    out.levelOffsets.clear();
+    out.levelSizes.clear();
+    size_t total = 0;
+    for (int level = 0; level < levelCount; ++level) {
+        size_t size = static_cast<size_t>(std::max(width >> level, 1)) * std::max(height >> level, 1) * channels;
+        out.levelOffsets.push_back(total);
+        out.levelSizes.push_back(size);
+        total += size;
+    }
+    out.data.resize(total);
+    std::memcpy(out.data.data(), pixels, out.levelSizes[0]);
+    if (levelCount == 1) return true;
+
+    const ChannelLayout layout = LayoutFor(options, channels, false);
+    LinearImage image;
+    image.resize(width, height, 1);
+    DecodeLevel(pixels, channels, layout, image);
+    FilterChain(image, levelCount, options, layout, [&](int level, const LinearImage& filtered) {
+        EncodeLevel(filtered, channels, layout, out.data.data() + out.levelOffsets[level]);
+    });
+    return true;
+}
+
+bool GenerateHdrMipChain(const float* const* faces, int faceCount, int width, int height, int channels,
+                         const MipOptions& options, HdrMipChain& out) {
+    if (!faces || faceCount < 1 || width <= 0 || height <= 0 || channels < 1 || channels > 4) return false;
+
+    const int levelCount = MipLevelCount(width, height);
+    out.width = width;
+    out.height = height;
+    out.channels = channels;
+    out.faces = faceCount;
+    out.levelOffsets.clear();
+    out.faceSizes.clear();
+    size_t total = 0;
+    for (int level = 0; level < levelCount; ++level) {
+        size_t size = static_cast<size_t>(std::max(width >> level, 1)) * std::max(height >> level, 1) * channels;
+        out.levelOffsets.push_back(total);
+        out.faceSizes.push_back(size);
+        total += size * faceCount;
+    }
+    out.data.resize(total);
+    for (int face = 0; face < faceCount; ++face)
+        std::memcpy(out.data.data() + face * out.faceSizes[0], faces[face], out.faceSizes[0] * sizeof(float));
+
+    const ChannelLayout layout = LayoutFor(options, channels, true);
+    LinearImage image;
+    image.resize(width, height, faceCount);
+    ParallelFor(static_cast<size_t>(faceCount) * height, [&](size_t begin, size_t end) {
+        for (size_t job = begin; job < end; ++job) {
+            const int face = static_cast<int>(job / height), y = static_cast<int>(job % height);
+            const float* src = faces[face] + static_cast<size_t>(y) * width * channels;
+            float* dst = image.row(face, y);
+            for (int x = 0; x < width; ++x, src += channels, dst += 4) {
+                dst[0] = dst[1] = dst[2] = dst[3] = 0.0f;
+                for (int c = 0; c < channels; ++c) dst[c] = src[c];
+            }
+        }
+    }, 0, 16);
+    FilterChain(image, levelCount, options, layout, [&](int level, const LinearImage& filtered) {
+        for (int face = 0; face < faceCount; ++face) {
+            float* dst = out.data.data() + out.levelOffsets[level] + face * out.faceSizes[level];
+            for (int y = 0; y < filtered.height; ++y) {
+                const float* src = filtered.row(face, y);
+                for (int x = 0; x < filtered.width; ++x, src += 4, dst += channels)
+                    for (int c = 0; c < channels; ++c) dst[c] = src[c];
+            }
+        }
+    });
+    return true;
+}
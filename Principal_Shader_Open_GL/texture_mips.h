@@ -0,0 +1,70 @@
+// texture_mips.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// CPU mip chain generation
+// ─────
+// Replaces glGenerateMipmap, whose filter is up to the driver and which averages
+// sRGB-encoded bytes as if they were linear. Each level is filtered from the one
+// above with a separable kernel (Kaiser-windowed sinc, or a plain 2x2 box), in
+// linear light for color maps. Normal maps are renormalized per level and
+// roughness is averaged as GGX alpha^2 (roughness^4), so a level's roughness
+// keeps the variance of the texels it covers instead of drifting smooth.
+// Pixels are filtered as 4-wide float vectors (SSE2 when available), in
+// parallel over row bands (and cubemap faces) on the job system.
+enum class MipFilter : uint8_t {
+    Box = 0,
+    Kaiser = 1,
+};
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Kaiser;
+    bool srgb = false;            // RGB (or gray) is sRGB-encoded color; alpha is always linear
+    bool normalMap = false;       // RGB holds a [0, 1]-encoded unit vector (Z rebuilt for 2 channels)
+    int8_t roughnessChannel = -1; // channel holding perceptual roughness, or -1
+    bool wrap = true;             // repeat at the edges (GL_REPEAT); cubemap faces clamp
+};
+
+int MipLevelCount(int width, int height); // full chain down to 1x1
+
+// Kaiser unless PBR_MIP_FILTER=box is set (for comparison)
+MipFilter DefaultMipFilter();
+
+// Identifies the options in cache headers and registry keys
+uint32_t MipOptionsKey(const MipOptions& options);
+
+// Flips an image in place (decoders produce top row first, GL expects bottom first)
+void FlipRows(unsigned char* pixels, int height, size_t rowBytes);
+
+// 8-bit chain: every level back to back, largest first, tightly packed rows
+struct MipChain {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::vector<unsigned char> data;
+    std::vector<size_t> levelOffsets; // one per level into `data`
+    std::vector<size_t> levelSizes;
+};
+
+// Copies `pixels` (1-4 channels) into level 0 and filters up to `maxLevels` levels
+// below it (0 = the full chain down to 1x1)
+bool GenerateMipChain(const unsigned char* pixels, int width, int height, int channels, const MipOptions& options,
+                      MipChain& out, int maxLevels = 0);
+
+// Float chain for HDR images: `faceCount` equally sized faces (1 for a 2D image, 6 for
+// a cubemap), filtered independently. Each level holds all faces back to back.
+struct HdrMipChain {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int faces = 0;
+    std::vector<float> data;
+    std::vector<size_t> levelOffsets; // in floats
+    std::vector<size_t> faceSizes;    // floats per face, per level
+};
+
+bool GenerateHdrMipChain(const float* const* faces, int faceCount, int width, int height, int channels,
+                         const MipOptions& options, HdrMipChain& out);
@@ -1,24 +1,211 @@
 #include "texture_utils.h"
+#include "brdf_lut.h"
+#include "file_utils.h"
+#include "half_float.h"
+#include "hdr_image.h"
+#include "ibl_cache.h"
+#include "texture_cache.h"
+#include "texture_mips.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "External/stb_image.h"
 
 
 
-GLuint LoadTexture2D(const std::string& path, bool generateMipmaps, bool flipY) {
-    stbi_set_flip_vertically_on_load(flipY);
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+struct TexelGLFormat {
+    TexelFormat texel;
+    GLenum internalFormat;
+    GLenum format; // 0 for block-compressed formats
+    GLenum type;
+};
+
+static const TexelGLFormat TEXEL_GL_FORMATS[] = {
+    { TexelFormat::BC1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, 0 },
+    { TexelFormat::BC4, GL_COMPRESSED_RED_RGTC1, 0, 0 },
+    { TexelFormat::BC5, GL_COMPRESSED_RG_RGTC2, 0, 0 },
+    { TexelFormat::R8, GL_R8, GL_RED, GL_UNSIGNED_BYTE },
+    { TexelFormat::RG8, GL_RG8, GL_RG, GL_UNSIGNED_BYTE },
+    { TexelFormat::RGB8, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE },
+    { TexelFormat::RGBA8, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+    { TexelFormat::R16F, GL_R16F, GL_RED, GL_HALF_FLOAT },
+    { TexelFormat::RG16F, GL_RG16F, GL_RG, GL_HALF_FLOAT },
+    { TexelFormat::RGB16F, GL_RGB16F, GL_RGB, GL_HALF_FLOAT },
+    { TexelFormat::RGBA16F, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },
+};
+
+static const TexelGLFormat* GLFormatOf(TexelFormat texel) {
+    for (const TexelGLFormat& format : TEXEL_GL_FORMATS)
+        if (format.texel == texel) return &format;
+    return nullptr;
+}
 
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (!data) {
+// Reverse lookup for read-back; sRGB storage is saved as the plain format
+static const TexelGLFormat* GLFormatOfInternal(GLint internalFormat) {
+    switch (internalFormat) {
+    case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT: internalFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT; break;
+    case GL_RED: internalFormat = GL_R8; break;
+    case GL_RG: internalFormat = GL_RG8; break;
+    case GL_RGB: case GL_SRGB8: internalFormat = GL_RGB8; break;
+    case GL_RGBA: case GL_SRGB8_ALPHA8: internalFormat = GL_RGBA8; break;
+    }
+    for (const TexelGLFormat& format : TEXEL_GL_FORMATS)
+        if (static_cast<GLint>(format.internalFormat) == internalFormat) return &format;
+    return nullptr;
+}
+
+// Creates a 2D texture or cubemap from the first `levelCount` levels of `info`, straight
+// from wherever the levels point (usually a file mapping). Leaves it bound.
+static GLuint UploadTextureLevels(const TextureCacheInfo& info, int levelCount) {
+    const TexelGLFormat* format = GLFormatOf(info.format);
+    if (!format) return 0;
+    const GLenum target = info.faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(target, texture);
+
+    GLint previousAlignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int level = 0; level < levelCount; ++level) {
+        GLsizei width = std::max(info.width >> level, 1), height = std::max(info.height >> level, 1);
+        for (int face = 0; face < info.faces; ++face) {
+            const TextureCacheLevel& region = info.level(level, face);
+            GLenum faceTarget = info.faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D;
+            if (format->format == 0)
+                glCompressedTexImage2D(faceTarget, level, format->internalFormat, width, height, 0,
+                                       static_cast<GLsizei>(region.size), region.data);
+            else
+                glTexImage2D(faceTarget, level, format->internalFormat, width, height, 0, format->format,
+                             format->type, region.data);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    return texture;
+}
+
+GLuint LoadTextureFile(const std::string& path, GLenum* target) {
+    MappedFile file;
+    TextureCacheInfo info;
+    if (!OpenTextureFile(path, file, info)) {
+        std::cerr << "Failed to load texture file at: " << path << std::endl;
+        return 0;
+    }
+    GLuint texture = UploadTextureLevels(info, info.levelCount());
+    if (!texture) return 0;
+    GLenum textureTarget = info.faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    bool mipmapped = info.levelCount() > 1;
+    glTexParameteri(textureTarget, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(textureTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    if (info.faces == 6) {
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    if (target) *target = textureTarget;
+    return texture;
+}
+
+// Reads every defined level (and face) of `texture` into `storage`, described by `info`
+static bool ReadTextureLevels(GLuint texture, GLenum target, TextureCacheInfo& info,
+                              std::vector<std::vector<unsigned char>>& storage) {
+    const GLenum levelTarget = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+    glBindTexture(target, texture);
+    GLint internalFormat = 0, width = 0, height = 0, maxLevel = 0;
+    glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(levelTarget, 0, GL_TEXTURE_HEIGHT, &height);
+    glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+    const TexelGLFormat* format = GLFormatOfInternal(internalFormat);
+    if (!format || width <= 0 || height <= 0) {
+        std::cerr << "Cannot read back texture " << texture << " (internal format 0x" << std::hex << internalFormat
+                  << std::dec << ")" << std::endl;
+        return false;
+    }
+
+    info = TextureCacheInfo();
+    info.format = format->texel;
+    info.width = width;
+    info.height = height;
+    info.faces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+    int levelCount = std::min(MipLevelCount(width, height), maxLevel + 1);
+    for (int level = 1; level < levelCount; ++level) { // stop at the first level that was never defined
+        GLint levelWidth = 0;
+        glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &levelWidth);
+        if (levelWidth == 0) levelCount = level;
+    }
+
+    storage.clear();
+    GLint previousAlignment;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    for (int level = 0; level < levelCount; ++level) {
+        for (int face = 0; face < info.faces; ++face) {
+            GLenum faceTarget = info.faces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+            storage.emplace_back(TexelLevelSize(info.format, std::max(width >> level, 1), std::max(height >> level, 1)));
+            if (format->format == 0)
+                glGetCompressedTexImage(faceTarget, level, storage.back().data());
+            else
+                glGetTexImage(faceTarget, level, format->format, format->type, storage.back().data());
+        }
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, previousAlignment);
+    for (const auto& region : storage) info.levels.push_back({ region.data(), region.size() });
+    return true;
+}
+
+bool SaveTextureFile(GLuint texture, GLenum target, const std::string& path) {
+    TextureCacheInfo info;
+    std::vector<std::vector<unsigned char>> storage;
+    return ReadTextureLevels(texture, target, info, storage) && WriteTextureFile(path, info);
+}
+
+GLuint LoadTexture2D(const std::string& path, bool generateMipmaps, bool flipY) {
+    // A .pbrtex, or the cache of an image decoded before: uploaded straight from the mapping
+    const MipOptions mips;
+    const uint32_t mipKey = MipOptionsKey(mips);
+    const bool container = std::filesystem::path(path).extension() == ".pbrtex";
+    MappedFile cacheFile;
+    TextureCacheInfo cached;
+    GLuint texture = 0;
+    if ((container ? OpenTextureFile(path, cacheFile, cached)
+                   : OpenTextureCache(path, TextureCompression::None, flipY, mipKey, cacheFile, cached)) &&
+        cached.faces == 1 && !IsHalfFormat(cached.format) &&
+        (container || !generateMipmaps || cached.levelCount() == MipLevelCount(cached.width, cached.height))) {
+        generateMipmaps = generateMipmaps && cached.levelCount() > 1;
+        texture = UploadTextureLevels(cached, generateMipmaps ? cached.levelCount() : 1);
+    }
+    cacheFile.close();
+
+    MappedFile file;
+    int width = 0, height = 0, nrChannels = 0;
+    unsigned char* data = nullptr;
+    const char* error = container ? "not a valid 2D texture file" : "cannot open file";
+    if (!texture && !container && file.open(path)) {
+        data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &nrChannels, 0);
+        error = data ? "unexpected number of channels" : stbi_failure_reason();
+    }
+    if (!texture && (!data || nrChannels < 1 || nrChannels > 4)) {
         std::cerr << "Failed to load texture at: " << path << std::endl;
-        std::cerr << "STB Error: " << stbi_failure_reason() << std::endl;
-        
+        std::cerr << "Error: " << error << std::endl;
+        stbi_image_free(data);
+
         // default 1x1 white texture instead of returning 0
-        GLuint texture;
         glGenTextures(1, &texture);
         glBindTexture(GL_TEXTURE_2D, texture);
         unsigned char white[] = {255, 255, 255, 255};
@@ -26,112 +213,188 @@ GLuint LoadTexture2D(const std::string& path, bool generateMipmaps, bool flipY)
         return texture;
     }
 
-    // Generate texture and upload data to GPU
-    GLuint texture;
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    if (!texture) {
+        // Flipped here rather than with stbi_set_flip_vertically_on_load, which is
+        // process-wide and would also flip the loader's concurrent decodes
+        if (flipY) FlipRows(data, height, static_cast<size_t>(width) * nrChannels);
+        MipChain chain;
+        GenerateMipChain(data, width, height, nrChannels, mips, chain, generateMipmaps ? 0 : 1);
+        stbi_image_free(data);
+        TextureCacheInfo image = DescribeTextureImage(chain);
+        WriteTextureCache(path, flipY, mipKey, HashBytes(file.data(), file.size()), image);
+        texture = UploadTextureLevels(image, image.levelCount());
+    }
 
     // Texture sampling and wrapping behavior
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    GLenum format;
-    if (nrChannels == 1)
-        format = GL_RED;
-    else if (nrChannels == 2)
-        format = GL_RG;  // New case for grayscale + alpha
-    else if (nrChannels == 3)
-        format = GL_RGB;
-    else if (nrChannels == 4)
-        format = GL_RGBA;
-    else {
-        std::cerr << "Unexpected number of channels: " << nrChannels << std::endl;
-        stbi_image_free(data);
-        return 0;
-    }
-
-
-   GLint internalFormat;
-    if (nrChannels == 1)
-        internalFormat = GL_RED;
-    else if (nrChannels == 2)
-        internalFormat = GL_RG;
-    else if (nrChannels == 3)
-        internalFormat = GL_RGB;
-    else
-        internalFormat = GL_RGBA;
-
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-
-    if (generateMipmaps)
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
     return texture;
 }
 
-GLuint LoadHDRTexture(const std::string& path) {
-    // Use stbi_loadf for floating point data
-    // HDR files store linear values that can exceed 1.0
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(true);
-    float* data = stbi_loadf(path.c_str(), &width, &height, &nrChannels, 0);
-
+// Formats the Radiance reader turns down (or a corrupt file, which stb reports); full size
+static bool DecodeHdrWithStb(const MappedFile& file, const std::string& path, HdrImage& image) {
+    int channels = 0;
+    float* data = stbi_loadf_from_memory(file.data(), static_cast<int>(file.size()), &image.width, &image.height,
+                                         &channels, 3);
     if (!data) {
         std::cerr << "Failed to load hdr texture at: " << path << std::endl;
         std::cerr << "STB Error: " << stbi_failure_reason() << std::endl;
-        return 0;
+        return false;
     }
+    image.sourceWidth = image.width;
+    image.sourceHeight = image.height;
+    image.texels.resize(static_cast<size_t>(image.width) * image.height * 3);
+    FloatsToHalves(data, image.texels.data(), image.texels.size());
+    stbi_image_free(data);
+    FlipRows(reinterpret_cast<unsigned char*>(image.texels.data()), image.height,
+             static_cast<size_t>(image.width) * 3 * sizeof(uint16_t));
+    return true;
+}
 
-    // Generate texture and upload data to GPU
-    GLuint hdrTexture;
-    glGenTextures(1, &hdrTexture);
-    glBindTexture(GL_TEXTURE_2D, hdrTexture);
+GLuint LoadHDRTexture(const std::string& path) {
+    // HDR files store linear values that can exceed 1.0. They are kept as half floats
+    // (what GL_RGB16F stores) in a .pbrtex next to the image, uploaded from the mapping.
+    // The width limit stands in for the mip key, so changing it rebuilds the cache.
+    const int maxWidth = DefaultHdrMaxWidth();
+    MappedFile cacheFile;
+    TextureCacheInfo cached;
+    GLuint hdrTexture = 0;
+    if (OpenTextureCache(path, TextureCompression::None, true, static_cast<uint32_t>(maxWidth), cacheFile, cached) &&
+        cached.format == TexelFormat::RGB16F)
+        hdrTexture = UploadTextureLevels(cached, 1);
+    cacheFile.close();
+
+    if (!hdrTexture) {
+        MappedFile file;
+        if (!file.open(path)) {
+            std::cerr << "Failed to load hdr texture at: " << path << std::endl;
+            return 0;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        HdrImage hdr;
+        if (!LoadRadianceHdr(file.data(), file.size(), maxWidth, hdr) && !DecodeHdrWithStb(file, path, hdr))
+            return 0;
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "HDR " << path << ": " << hdr.sourceWidth << "x" << hdr.sourceHeight;
+        if (hdr.width != hdr.sourceWidth) std::cout << " -> " << hdr.width << "x" << hdr.height;
+        std::cout << " decoded to half floats in " << ms << " ms" << std::endl;
+
+        TextureCacheInfo image;
+        image.format = TexelFormat::RGB16F;
+        image.width = hdr.width;
+        image.height = hdr.height;
+        image.levels.push_back({ reinterpret_cast<const unsigned char*>(hdr.texels.data()),
+                                 hdr.texels.size() * sizeof(uint16_t) });
+        WriteTextureCache(path, true, static_cast<uint32_t>(maxWidth), HashBytes(file.data(), file.size()), image);
+        hdrTexture = UploadTextureLevels(image, 1);
+    }
 
     // set parameters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return hdrTexture;
+}
 
-    GLenum format;
-    if (nrChannels == 1)
-        format = GL_RED;  // Grayscale
-    else if (nrChannels == 3)
-        format = GL_RGB;
-    else if (nrChannels == 4)
-        format = GL_RGBA;
-    else {
-        std::cerr << "Unexpected number of channels: " << nrChannels << std::endl;
-        stbi_image_free(data);
-        return 0;
-    }
+// ─────────────────────────────────────────────
+// Cubemap capture
+// ─────
+// The bake passes' programs and framebuffer, created on first use and kept until
+// ShutdownEnvironmentBake, so an environment swap only pays for the shading. Each pass
+// fills all six faces of a level in one draw: a layered attachment and
+// cubemap_layered.geom picking the face per primitive. Nothing is depth tested, so
+// there is no depth buffer.
+static GLuint g_captureFbo = 0;
+static GLuint g_captureVao = 0; // empty: the triangle comes from gl_VertexID
+static GLuint g_equirectProgram = 0;
+static GLuint g_prefilterProgram = 0;
+static GLint g_prefilterRoughnessLoc = -1;
+static GLint g_prefilterSampleCountLoc = -1;
+static GLint g_prefilterEnvironmentSizeLoc = -1;
+static GLint g_prefilterMinLodLoc = -1;
+
+static GLuint LinkCaptureProgram(const char* fragmentPath, const char* samplerName) {
+    std::string vertexSource = ReadTextFile("shaders/cubemap_layered.vert");
+    std::string geometrySource = ReadTextFile("shaders/cubemap_layered.geom");
+    std::string fragSource = ReadTextFile(fragmentPath);
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexSource.c_str());
+    GLuint gs = CompileShader(GL_GEOMETRY_SHADER, geometrySource.c_str());
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragSource.c_str());
+    GLuint program = LinkProgram(vs, gs, fs);
+    glDeleteShader(vs);
+    glDeleteShader(gs);
+    glDeleteShader(fs);
+    glUseProgram(program);
+    glUniform1i(ULoc(program, samplerName), 0); // the source is always on unit 0
+    return program;
+}
 
-   GLint internalFormat;
-    if (nrChannels == 1)
-        internalFormat = GL_R16F;
-    else if (nrChannels == 3)
-        internalFormat = GL_RGB16F;
-    else
-        internalFormat = GL_RGBA16F;
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_FLOAT, data);
+static void InitEnvironmentBake() {
+    if (g_captureFbo) return;
+    glGenFramebuffers(1, &g_captureFbo);
+    glGenVertexArrays(1, &g_captureVao);
+    g_equirectProgram = LinkCaptureProgram("shaders/equirect_to_cubemap.frag", "equirectangularMap");
+    g_prefilterProgram = LinkCaptureProgram("shaders/prefilter_ggx.frag", "environmentMap");
+    g_prefilterRoughnessLoc = ULoc(g_prefilterProgram, "roughness");
+    g_prefilterSampleCountLoc = ULoc(g_prefilterProgram, "sampleCount");
+    g_prefilterEnvironmentSizeLoc = ULoc(g_prefilterProgram, "environmentSize");
+    g_prefilterMinLodLoc = ULoc(g_prefilterProgram, "minLod");
+}
 
-    stbi_image_free(data);
-    return hdrTexture;
+void ShutdownEnvironmentBake() {
+    if (!g_captureFbo) return;
+    glDeleteFramebuffers(1, &g_captureFbo);
+    glDeleteVertexArrays(1, &g_captureVao);
+    glDeleteProgram(g_equirectProgram);
+    glDeleteProgram(g_prefilterProgram);
+    g_captureFbo = g_captureVao = g_equirectProgram = g_prefilterProgram = 0;
 }
 
-GLuint EquirectToCubemap(GLuint hdrTex, GLuint /*unused*/, GLuint /*unused*/, int size) {
-    GLuint captureFBO, captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
+// The state a capture changes, put back by EndCapture
+struct CaptureState {
+    GLint viewport[4];
+    GLint framebuffer;
+    GLint vertexArray;
+    GLboolean depthTest;
+};
+
+static CaptureState BeginCapture(GLuint program) {
+    CaptureState state;
+    glGetIntegerv(GL_VIEWPORT, state.viewport);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &state.framebuffer);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &state.vertexArray);
+    state.depthTest = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_captureFbo);
+    glBindVertexArray(g_captureVao);
+    glUseProgram(program);
+    return state;
+}
 
+// Every face of `cubemap`'s `level` with the current program, in one draw
+static void CaptureCubemapLevel(GLuint cubemap, int level, int size) {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, cubemap, level);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Cubemap capture framebuffer incomplete (level " << level << ")" << std::endl;
+        return;
+    }
+    glViewport(0, 0, size, size);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void EndCapture(const CaptureState& state) {
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 0, 0); // don't keep the cubemap referenced
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(state.framebuffer));
+    glBindVertexArray(static_cast<GLuint>(state.vertexArray));
+    glViewport(state.viewport[0], state.viewport[1], state.viewport[2], state.viewport[3]);
+    if (state.depthTest) glEnable(GL_DEPTH_TEST);
+}
+
+GLuint EquirectToCubemap(GLuint hdrTex, int size) {
+    InitEnvironmentBake();
     GLuint envCubemap;
     glGenTextures(1, &envCubemap);
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
@@ -142,134 +405,260 @@ GLuint EquirectToCubemap(GLuint hdrTex, GLuint /*unused*/, GLuint /*unused*/, in
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, 0); // complete for the layered attachment
 
-    glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-    glm::mat4 views[] = {
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-    };
-
-    // compile shaders
-    std::string vertexSource = ReadTextFile("shaders/cubemap_vertex.vert");
-    std::string fragSource = ReadTextFile("shaders/equirect_to_cubemap.frag");
-
-    GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, vertexSource.c_str());
-    GLuint frag_shader = CompileShader(GL_FRAGMENT_SHADER, fragSource.c_str());
-    GLuint shader_program = LinkProgram(vertex_shader, frag_shader);
-    glUseProgram(shader_program);
-
-    GLint loc_equirectangularMap = glGetUniformLocation(shader_program, "equirectangularMap");
-    GLint loc_proj     = glGetUniformLocation(shader_program, "projection");
-    GLint loc_view     = glGetUniformLocation(shader_program, "view");
-    glUniform1i(loc_equirectangularMap, 0);
-    glUniformMatrix4fv(loc_proj, 1, GL_FALSE, glm::value_ptr(proj));
-
-    // bind HDR
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, hdrTex);
+    CaptureState state = BeginCapture(g_equirectProgram);
+    CaptureCubemapLevel(envCubemap, 0, size);
+    EndCapture(state);
+    return envCubemap;
+}
 
-    // state
-    GLint prevViewport[4]; glGetIntegerv(GL_VIEWPORT, prevViewport);
-    glViewport(0, 0, size, size);
-    glEnable(GL_DEPTH_TEST);
-    GLint prevDepthFunc; glGetIntegerv(GL_DEPTH_FUNC, &prevDepthFunc);
-    glDepthFunc(GL_LEQUAL);
-
-    // render into each face
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cerr << "Cubemap capture FBO incomplete\n";
-    }
+void GenerateCubemapMips(GLuint cubemap) {
+    auto t0 = std::chrono::steady_clock::now();
+    GLint size = 0;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &size);
+    if (size <= 0) return;
+
+    GLint previousPack;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousPack);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    std::vector<float> faces(static_cast<size_t>(size) * size * 3 * 6);
+    const float* facePointers[6];
     for (int i = 0; i < 6; ++i) {
-        glUniformMatrix4fv(loc_view, 1, GL_FALSE, glm::value_ptr(views[i]));
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, envCubemap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        renderCube(); // helper that binds its own VAO
+        float* face = faces.data() + static_cast<size_t>(size) * size * 3 * i;
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, GL_FLOAT, face);
+        facePointers[i] = face;
     }
+    glPixelStorei(GL_PACK_ALIGNMENT, previousPack);
+
+    MipOptions options;
+    options.filter = ENVIRONMENT_MIP_FILTER; // box (ibl_cache.h)
+    options.wrap = false;
+    HdrMipChain chain;
+    if (!GenerateHdrMipChain(facePointers, 6, size, size, 3, options, chain)) return;
+
+    GLint previousUnpack;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpack);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const GLint levelCount = static_cast<GLint>(chain.levelOffsets.size());
+    for (GLint level = 1; level < levelCount; ++level) {
+        GLsizei levelSize = std::max(size >> level, 1);
+        for (int i = 0; i < 6; ++i)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB16F, levelSize, levelSize, 0, GL_RGB,
+                         GL_FLOAT, chain.data.data() + chain.levelOffsets[level] + i * chain.faceSizes[level]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpack);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // restore state
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
-    glDepthFunc(prevDepthFunc);
-
-    glDeleteRenderbuffers(1, &captureRBO);
-    glDeleteFramebuffers(1, &captureFBO);
-    glDeleteProgram(shader_program);
-    glDeleteShader(vertex_shader);
-    glDeleteShader(frag_shader);
-
-    return envCubemap;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Environment mips: " << levelCount << " levels of " << size << "x" << size << " in " << ms << " ms"
+              << std::endl;
 }
 
-GLuint ConvolveIrradiance(GLuint envCubemap) {
-    GLuint captureFBO, captureRBO;
-    glGenFramebuffers(1, &captureFBO);
-    glGenRenderbuffers(1, &captureRBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
-
-    GLuint irradianceMap;
-    glGenTextures(1, &irradianceMap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, irradianceMap);
-    for (int i = 0; i < 6; ++i)
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
+GLuint PrefilterEnvironment(GLuint envCubemap, int size, int levelCount) {
+    auto t0 = std::chrono::steady_clock::now();
+    InitEnvironmentBake();
+    GLint envSize = 0, envMaxLevel = 0;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &envSize);
+    glGetTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, &envMaxLevel);
+    levelCount = std::max(1, std::min({ levelCount, MipLevelCount(size, size), PREFILTER_MAX_LEVELS }));
+
+    GLuint prefiltered;
+    glGenTextures(1, &prefiltered);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, prefiltered);
+    for (int level = 0; level < levelCount; ++level) {
+        GLsizei levelSize = std::max(size >> level, 1);
+        for (int i = 0; i < 6; ++i)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB16F, levelSize, levelSize, 0, GL_RGB,
+                         GL_FLOAT, nullptr);
+    }
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
 
-    // compile shaders
-    std::string vertexSource = ReadTextFile("shaders/cubemap_vertex.vert");  // Reuse existing
-    std::string fragSource = ReadTextFile("shaders/irradiance_convolution.frag");
-    GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, vertexSource.c_str());
-    GLuint frag_shader = CompileShader(GL_FRAGMENT_SHADER, fragSource.c_str());
-    GLuint program = LinkProgram(vertex_shader, frag_shader);
-    glUseProgram(program);
-
-    glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-    glm::mat4 views[] = {
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3(0.0f,  0.0f,  1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3(0.0f,  0.0f, -1.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
-        glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
-    };
-
-    // set uniforms
-    glUniform1i(glGetUniformLocation(program, "environmentMap"), 0);
-    glUniform1i(glGetUniformLocation(program, "irradianceMap"), 4);  // Texture unit 4
-    glUniform1i(glGetUniformLocation(program, "useIBL"), 1);  // Enable IBL
-    GLint loc_proj     = glGetUniformLocation(program, "projection");
-    GLint loc_view     = glGetUniformLocation(program, "view");
-    glUniformMatrix4fv(loc_proj, 1, GL_FALSE, glm::value_ptr(proj));
-
-    // bind HDR
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+    CaptureState state = BeginCapture(g_prefilterProgram);
+    glUniform1f(g_prefilterEnvironmentSizeLoc, static_cast<float>(envSize));
+    for (int level = 0; level < levelCount; ++level) {
+        GLsizei levelSize = std::max(size >> level, 1);
+        glUniform1f(g_prefilterRoughnessLoc, levelCount > 1 ? static_cast<float>(level) / (levelCount - 1) : 0.0f);
+        glUniform1i(g_prefilterSampleCountLoc, PREFILTER_SAMPLE_COUNTS[level]);
+        float minLod = std::log2(static_cast<float>(envSize) / static_cast<float>(levelSize));
+        glUniform1f(g_prefilterMinLodLoc, std::min(std::max(minLod, 0.0f), static_cast<float>(envMaxLevel)));
+        CaptureCubemapLevel(prefiltered, level, levelSize);
+    }
+    EndCapture(state);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Prefiltered environment: " << levelCount << " GGX levels of " << size << "x" << size
+              << " queued in " << ms << " ms" << std::endl;
+    return prefiltered;
+}
 
-    // Before rendering loop
-    glViewport(0, 0, 32, 32);
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
+int TextureMaxLevel(GLenum target, GLuint texture) {
+    GLint maxLevel = 0;
+    glBindTexture(target, texture);
+    glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+    return maxLevel;
+}
 
-    // render into each irradianceMap face
+GLuint CreateBrdfLutTexture() {
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<uint16_t> texels;
+    ComputeBrdfLut(BRDF_LUT_SIZE, BRDF_LUT_SAMPLES, texels);
+
+    GLuint lut;
+    glGenTextures(1, &lut);
+    glBindTexture(GL_TEXTURE_2D, lut);
+    GLint previousUnpack;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousUnpack);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, BRDF_LUT_SIZE, BRDF_LUT_SIZE, 0, GL_RG, GL_HALF_FLOAT, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, previousUnpack);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "BRDF LUT: " << BRDF_LUT_SIZE << "x" << BRDF_LUT_SIZE << ", " << BRDF_LUT_SAMPLES
+              << " samples per texel in " << ms << " ms" << std::endl;
+    return lut;
+}
+
+IrradianceSH ComputeIrradianceSH(GLuint envCubemap) {
+    auto t0 = std::chrono::steady_clock::now();
+    GLint size = 0, maxLevel = 0;
+    glBindTexture(GL_TEXTURE_CUBE_MAP, envCubemap);
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_TEXTURE_WIDTH, &size);
+    glGetTexParameteriv(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+    if (size <= 0) return IrradianceSH();
+
+    // Nine coefficients can't tell a 64^2 face from the full one, and the box-filtered
+    // mip (GenerateCubemapMips) averages every texel above it
+    int level = 0;
+    while (level < maxLevel && (size >> level) > IRRADIANCE_SH_FACE_SIZE) ++level;
+    GLint levelSize = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_CUBE_MAP_POSITIVE_X, level, GL_TEXTURE_WIDTH, &levelSize);
+    if (levelSize <= 0) {
+        level = 0;
+        levelSize = size;
+    }
+
+    GLint previousPack;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &previousPack);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    std::vector<float> faces(static_cast<size_t>(levelSize) * levelSize * 3 * 6);
+    const float* facePointers[6];
     for (int i = 0; i < 6; ++i) {
-        glUniformMatrix4fv(loc_view, 1, GL_FALSE, glm::value_ptr(views[i]));
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                               GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        renderCube(); // helper that binds its own VAO
+        float* face = faces.data() + static_cast<size_t>(levelSize) * levelSize * 3 * i;
+        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, GL_RGB, GL_FLOAT, face);
+        facePointers[i] = face;
     }
+    glPixelStorei(GL_PACK_ALIGNMENT, previousPack);
 
-    // restore state
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    return irradianceMap;
-}
\ No newline at end of file
+    IrradianceSH sh = ProjectIrradianceSH(facePointers, levelSize);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Irradiance SH: projected 6x" << levelSize << "x" << levelSize << " in " << ms << " ms" << std::endl;
+    return sh;
+}
+
+void UploadIrradianceSH(GLuint& buffer, const IrradianceSH& sh) {
+    // std140: one vec4 per coefficient, RGB in xyz
+    float data[SH_COEFFICIENT_COUNT][4] = {};
+    for (int i = 0; i < SH_COEFFICIENT_COUNT; ++i)
+        for (int c = 0; c < 3; ++c) data[i][c] = sh.coefficients[i][c];
+    if (!buffer) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(data), data, GL_STATIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, IRRADIANCE_SH_BINDING, buffer);
+}
+
+// Cubemaps clamp and filter across their mips; the LUT clamps too (N.V = 1 must not wrap to 0)
+static void SetEnvironmentSampling(GLenum target, bool mipmapped) {
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (target == GL_TEXTURE_CUBE_MAP) glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+static void ReleaseEnvironment(EnvironmentMaps& maps) {
+    GLuint textures[] = { maps.environment, maps.prefiltered, maps.brdfLut };
+    glDeleteTextures(3, textures);
+    maps.environment = maps.prefiltered = maps.brdfLut = 0;
+    maps.prefilteredMaxLevel = 0;
+}
+
+// Uploads every texture of a mapped cache; false (nothing left behind) if one doesn't fit GL
+static bool UploadEnvironment(const IblCacheData& data, EnvironmentMaps& maps) {
+    GLuint* textures[IBL_TEXTURE_COUNT] = { &maps.environment, &maps.prefiltered, &maps.brdfLut };
+    for (int t = 0; t < IBL_TEXTURE_COUNT; ++t) {
+        const TextureCacheInfo& info = data.textures[t];
+        *textures[t] = UploadTextureLevels(info, info.levelCount());
+        if (!*textures[t]) {
+            ReleaseEnvironment(maps);
+            return false;
+        }
+        SetEnvironmentSampling(info.faces == 6 ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, info.levelCount() > 1);
+    }
+    maps.prefilteredMaxLevel = data.texture(IblTexture::Prefiltered).levelCount() - 1;
+    maps.irradiance = data.irradiance;
+    return true;
+}
+
+bool LoadEnvironment(const std::string& hdrPath, EnvironmentMaps& maps) {
+    auto t0 = std::chrono::steady_clock::now();
+    const uint64_t bakeKey = IblBakeKey();
+    {
+        MappedFile cacheFile;
+        IblCacheData cached;
+        if (OpenIblCache(hdrPath, bakeKey, cacheFile, cached) && UploadEnvironment(cached, maps)) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "IBL loaded from cache " << IblCachePath(hdrPath) << " in " << ms << " ms" << std::endl;
+            return true;
+        }
+    }
+
+    // Bake: the equirectangular HDR is only an input, freed once the cubemap exists
+    GLuint hdrTexture = LoadHDRTexture(hdrPath);
+    if (!hdrTexture) return false;
+    maps.environment = EquirectToCubemap(hdrTexture, ENVIRONMENT_SIZE);
+    glDeleteTextures(1, &hdrTexture);
+    GenerateCubemapMips(maps.environment);
+    maps.prefiltered = PrefilterEnvironment(maps.environment);
+    maps.prefilteredMaxLevel = TextureMaxLevel(GL_TEXTURE_CUBE_MAP, maps.prefiltered);
+    maps.irradiance = ComputeIrradianceSH(maps.environment);
+    maps.brdfLut = CreateBrdfLutTexture();
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    // Read back and write the cache (the read-back also waits for the bake passes)
+    IblCacheData bake;
+    std::vector<std::vector<unsigned char>> storage[IBL_TEXTURE_COUNT];
+    const GLuint textures[IBL_TEXTURE_COUNT] = { maps.environment, maps.prefiltered, maps.brdfLut };
+    const GLenum targets[IBL_TEXTURE_COUNT] = { GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D };
+    bool complete = true;
+    for (int t = 0; t < IBL_TEXTURE_COUNT; ++t)
+        complete = complete && ReadTextureLevels(textures[t], targets[t], bake.textures[t], storage[t]);
+    MappedFile source;
+    if (complete && source.open(hdrPath)) {
+        bake.contentHash = HashBytes(source.data(), source.size());
+        bake.irradiance = maps.irradiance;
+        WriteIblCache(hdrPath, bakeKey, bake);
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "IBL baked in " << bakeMs << " ms, cached as " << IblCachePath(hdrPath) << " (" << ms
+              << " ms in total)" << std::endl;
+    return true;
+}
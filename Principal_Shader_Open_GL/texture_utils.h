@@ -2,13 +2,53 @@
 #pragma once
 #include "shader_utils.h"
 #include "mesh_utils.h"
+#include "ibl_cache.h"
+#include "spherical_harmonics.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <string>
 
+// Both keep what they decoded in a .pbrtex next to the image (texture_cache.h) and
+// upload straight from its mapping next time; LoadTexture2D also opens .pbrtex files
 GLuint LoadTexture2D(const std::string& path, bool generateMipmaps=true, bool flipY=true); // returns GL texture id
 GLuint LoadHDRTexture(const std::string& path);
-GLuint EquirectToCubemap(GLuint hdrTex, GLuint cubeVAO, GLuint cubeVBO, int size = 512);
-GLuint ConvolveIrradiance(GLuint envCubemap);
\ No newline at end of file
+// Native texture files for any 2D texture or cubemap (e.g. the IBL outputs): every
+// level is read back (8-bit, half float or BC blocks) and written / mapped and uploaded.
+// `target` receives GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+bool SaveTextureFile(GLuint texture, GLenum target, const std::string& path);
+GLuint LoadTextureFile(const std::string& path, GLenum* target = nullptr);
+// The bake passes below render every cubemap face in one layered draw through programs
+// and a framebuffer kept between environments; free them before the context goes away
+void ShutdownEnvironmentBake();
+GLuint EquirectToCubemap(GLuint hdrTex, int size = ENVIRONMENT_SIZE);
+// Reads the RGB16F faces back, filters the mip chain on the CPU (texture_mips.h) and
+// uploads it; sets trilinear filtering
+void GenerateCubemapMips(GLuint cubemap);
+// Specular IBL (split sum): a GGX-prefiltered copy of the mipmapped environment, mip i
+// holding roughness i / (levelCount - 1), read in basic.frag with a real-mip-count LOD
+GLuint PrefilterEnvironment(GLuint envCubemap, int size = PREFILTER_SIZE, int levelCount = PREFILTER_LEVELS);
+int TextureMaxLevel(GLenum target, GLuint texture); // GL_TEXTURE_MAX_LEVEL, i.e. the last mip sampled
+// The environment-independent half of the split sum (brdf_lut.h) as an RG16F texture
+GLuint CreateBrdfLutTexture();
+// Diffuse IBL: projects the environment's mip closest to IRRADIANCE_SH_FACE_SIZE into
+// L2 spherical harmonics (spherical_harmonics.h)
+IrradianceSH ComputeIrradianceSH(GLuint envCubemap);
+// Writes `sh` to the uniform buffer behind basic.frag's IrradianceSH block (created on first
+// use) and binds it to IRRADIANCE_SH_BINDING
+const GLuint IRRADIANCE_SH_BINDING = 0;
+void UploadIrradianceSH(GLuint& buffer, const IrradianceSH& sh);
+
+// Everything the lighting needs from one HDR environment
+struct EnvironmentMaps {
+    GLuint environment = 0; // mipmapped cubemap (skybox, prefilter input)
+    GLuint prefiltered = 0; // GGX-prefiltered cubemap
+    int prefilteredMaxLevel = 0; // its last mip (uPrefilterMaxLod), kept so drawing needn't query GL
+    GLuint brdfLut = 0;
+    IrradianceSH irradiance;
+};
+// Uploads `hdrPath`'s baked IBL cache (ibl_cache.h) straight from its mapping, or loads the
+// HDR, runs every bake pass above and writes the cache for next time. False if the HDR
+// can't be read.
+bool LoadEnvironment(const std::string& hdrPath, EnvironmentMaps& maps);
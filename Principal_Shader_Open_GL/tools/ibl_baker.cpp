@@ -0,0 +1,169 @@
+// tools/ibl_baker.cpp - headless CPU IBL baker for batches of environments
+//
+// Usage: ibl_baker [--force] <file.hdr | directory>...
+//   Bakes every Radiance .hdr given (directories are searched recursively) into the
+//   .pbribl cache next to it, the file the viewer's LoadEnvironment maps instead of
+//   baking on the GPU. Caches that are already up to date are skipped unless --force.
+//   Prints per-stage timings for each environment and the batch, and environments
+//   per second. No GL context is created, so this runs on GPU-less build machines;
+//   PBR_WORKER_THREADS limits the threads, PBR_HDR_MAX_WIDTH is honored as in the viewer.
+#include "brdf_lut.h"
+#include "file_utils.h"
+#include "hdr_image.h"
+#include "ibl_bake.h"
+#include "ibl_cache.h"
+#include "job_system.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool IsHdrFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".hdr";
+}
+
+// Files as given, directories expanded to the .hdr files below them (sorted, for stable output)
+static void CollectInputs(const std::string& argument, std::vector<std::string>& inputs) {
+    std::error_code ec;
+    if (!std::filesystem::is_directory(argument, ec)) {
+        inputs.push_back(argument);
+        return;
+    }
+    std::vector<std::string> found;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(argument, ec))
+        if (entry.is_regular_file(ec) && IsHdrFile(entry.path())) found.push_back(entry.path().string());
+    std::sort(found.begin(), found.end());
+    inputs.insert(inputs.end(), found.begin(), found.end());
+}
+
+struct StageTimes {
+    double decode = 0.0, cubemap = 0.0, mips = 0.0, prefilter = 0.0, irradiance = 0.0, write = 0.0;
+
+    double total() const { return decode + cubemap + mips + prefilter + irradiance + write; }
+    void add(const StageTimes& other) {
+        decode += other.decode;
+        cubemap += other.cubemap;
+        mips += other.mips;
+        prefilter += other.prefilter;
+        irradiance += other.irradiance;
+        write += other.write;
+    }
+};
+
+static void PrintStageRow(const char* name, const char* size, const StageTimes& t) {
+    std::printf("%-32.32s %11s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, size, t.decode, t.cubemap,
+                t.mips, t.prefilter, t.irradiance, t.write, t.total());
+}
+
+int main(int argc, char** argv) {
+    bool force = false;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--force") == 0) force = true;
+        else CollectInputs(argv[i], inputs);
+    }
+    if (inputs.empty()) {
+        std::cerr << "Usage: ibl_baker [--force] <file.hdr | directory>..." << std::endl;
+        return 2;
+    }
+
+    const auto batchStart = std::chrono::steady_clock::now();
+    const uint64_t bakeKey = IblBakeKey();
+    const int maxWidth = DefaultHdrMaxWidth();
+    std::cout << inputs.size() << " environment(s), " << WorkerCount() << " worker threads, cube faces "
+              << ENVIRONMENT_SIZE << ", prefilter " << PREFILTER_SIZE << " x " << PREFILTER_LEVELS << " levels\n\n";
+
+    std::printf("%-32s %11s %9s %9s %9s %9s %9s %9s %9s\n", "environment", "size", "decode", "cubemap", "mips",
+                "prefilter", "SH", "write", "total ms");
+    StageTimes totals;
+    size_t baked = 0, skipped = 0, failed = 0;
+    std::vector<uint16_t> brdfLut; // the same for every environment: computed once, on the first bake
+    double lutMs = 0.0;
+    std::chrono::steady_clock::time_point t0;
+    for (const std::string& path : inputs) {
+        const std::string name = std::filesystem::path(path).filename().string();
+        if (!force) {
+            MappedFile cacheFile;
+            IblCacheData cached;
+            if (OpenIblCache(path, bakeKey, cacheFile, cached)) {
+                std::printf("%-32.32s up to date, skipped\n", name.c_str());
+                ++skipped;
+                continue;
+            }
+        }
+
+        StageTimes times;
+        t0 = std::chrono::steady_clock::now();
+        MappedFile file;
+        HdrImage hdr;
+        if (!file.open(path) || !LoadRadianceHdr(file.data(), file.size(), maxWidth, hdr)) {
+            std::cerr << "Cannot decode " << path << std::endl;
+            ++failed;
+            continue;
+        }
+        times.decode = MillisecondsSince(t0);
+
+        if (brdfLut.empty()) {
+            t0 = std::chrono::steady_clock::now();
+            ComputeBrdfLut(BRDF_LUT_SIZE, BRDF_LUT_SAMPLES, brdfLut);
+            lutMs = MillisecondsSince(t0);
+        }
+        IblBake bake;
+        IblBakeStats stats;
+        if (!BakeIblEnvironment(hdr, brdfLut, bake, &stats)) {
+            std::cerr << "Bake failed: " << path << std::endl;
+            ++failed;
+            continue;
+        }
+        times.cubemap = stats.cubemapMs;
+        times.mips = stats.mipsMs;
+        times.prefilter = stats.prefilterMs;
+        times.irradiance = stats.irradianceMs;
+
+        t0 = std::chrono::steady_clock::now();
+        bake.data.contentHash = HashBytes(file.data(), file.size());
+        file.close();
+        if (!WriteIblCache(path, bakeKey, bake.data)) {
+            ++failed;
+            continue;
+        }
+        times.write = MillisecondsSince(t0);
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%dx%d", hdr.width, hdr.height);
+        PrintStageRow(name.c_str(), size, times);
+        totals.add(times);
+        ++baked;
+    }
+
+    const double seconds = MillisecondsSince(batchStart) / 1000.0;
+    if (baked > 0) {
+        std::printf("\n");
+        PrintStageRow("total", "", totals);
+        StageTimes average = totals;
+        const double scale = 1.0 / static_cast<double>(baked);
+        average.decode *= scale;
+        average.cubemap *= scale;
+        average.mips *= scale;
+        average.prefilter *= scale;
+        average.irradiance *= scale;
+        average.write *= scale;
+        PrintStageRow("average", "", average);
+        std::printf("BRDF LUT (once per batch): %.1f ms\n", lutMs);
+    }
+    std::printf("\n%zu baked, %zu up to date, %zu failed in %.2f s: %.2f environments/s\n", baked, skipped, failed,
+                seconds, seconds > 0.0 ? static_cast<double>(baked) / seconds : 0.0);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,536 @@
+// tools/mesh_pipeline_bench.cpp - per-commit regression benchmark for the mesh pipeline
+//
+// Usage: mesh_pipeline_bench [--shapes grid,sphere,noise] [--sizes 10k,100k,1m]
+//                            [--lod-max 2m] [--json out.json] [--label name] [--keep]
+//   Generates deterministic synthetic OBJs and, for every shape and size, times
+//   each CPU stage in isolation on the same input:
+//     parse      ParseObjParallel
+//     tangents   ComputeTangents
+//     optimize   OptimizeMesh
+//     pack       PackVertices + 16-bit indices (the CPU side of createMesh)
+//     lod        BuildLodChain   (only up to --lod-max triangles, it is the slow one)
+//     meshlets   BuildMeshlets
+//   plus the whole import chain end to end, in the order the viewer's OBJ load runs it.
+//   Each record has time, throughput and the peak RSS reached during the stage.
+//   Results go out as JSON (stdout, or --json); progress is printed on stderr.
+//   Sizes take k/m suffixes and go up to 50m. Inputs are deterministic: noise
+//   and scattering come from integer hashes rather than <random>.
+//   No GL context is created; the GL upload itself is not measured.
+#include "obj_parser.h"
+#include "tangents.h"
+#include "mesh_optimize.h"
+#include "mesh_lod.h"
+#include "meshlets.h"
+#include "job_system.h"
+#include "vertex.h"
+#include "vertex_packing.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// ─────────────────────────────────────────────
+// Peak resident set size
+// ─────
+// On Linux the high-water mark can be reset (clear_refs), so every stage reports
+// its own peak. Elsewhere the process-wide peak is reported, which only grows.
+static bool ResetPeakRss() {
+#ifdef __linux__
+    std::ofstream clear("/proc/self/clear_refs");
+    if (!clear) return false;
+    clear << "5";
+    return static_cast<bool>(clear);
+#else
+    return false;
+#endif
+}
+
+static double PeakRssMB() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    return 0.0;
+#else
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::strtod(line.c_str() + 6, nullptr) / 1024.0; // kB
+    }
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+#else
+    return usage.ru_maxrss / 1024.0;            // kB
+#endif
+#endif
+}
+
+// ─────────────────────────────────────────────
+// Deterministic synthetic inputs
+// ─────
+// <random> distributions differ between standard libraries, so noise comes from
+// an integer hash instead.
+static uint64_t Hash64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static float HashUnit(uint64_t x) { // [0, 1)
+    return static_cast<float>(Hash64(x) >> 40) / static_cast<float>(1ull << 24);
+}
+
+// Smooth 3D value noise on an integer lattice
+static float ValueNoise(float x, float y, float z) {
+    float fx = std::floor(x), fy = std::floor(y), fz = std::floor(z);
+    int64_t ix = static_cast<int64_t>(fx), iy = static_cast<int64_t>(fy), iz = static_cast<int64_t>(fz);
+    float tx = x - fx, ty = y - fy, tz = z - fz;
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    ty = ty * ty * (3.0f - 2.0f * ty);
+    tz = tz * tz * (3.0f - 2.0f * tz);
+    auto corner = [&](int dx, int dy, int dz) {
+        uint64_t key = static_cast<uint64_t>(ix + dx) * 73856093ull ^ static_cast<uint64_t>(iy + dy) * 19349663ull ^
+                       static_cast<uint64_t>(iz + dz) * 83492791ull;
+        return HashUnit(key);
+    };
+    float x00 = corner(0, 0, 0) + (corner(1, 0, 0) - corner(0, 0, 0)) * tx;
+    float x10 = corner(0, 1, 0) + (corner(1, 1, 0) - corner(0, 1, 0)) * tx;
+    float x01 = corner(0, 0, 1) + (corner(1, 0, 1) - corner(0, 0, 1)) * tx;
+    float x11 = corner(0, 1, 1) + (corner(1, 1, 1) - corner(0, 1, 1)) * tx;
+    float y0 = x00 + (x10 - x00) * ty;
+    float y1 = x01 + (x11 - x01) * ty;
+    return y0 + (y1 - y0) * tz;
+}
+
+// Bijective scatter of [0, n): i -> (a*i + b) mod n with gcd(a, n) = 1. Models the
+// unordered vertex and face lists of scanner output without a shuffle array.
+struct Scatter {
+    uint64_t n, a, b;
+    explicit Scatter(uint64_t count, uint64_t seed) : n(std::max<uint64_t>(count, 1)) {
+        a = (Hash64(seed) % n) | 1;
+        while (std::gcd(a, n) != 1) a += 2;
+        b = Hash64(seed + 1) % n;
+    }
+    uint64_t operator()(uint64_t i) const { return (a * i + b) % n; } // a, i < n < 2^32: no overflow
+};
+
+// Buffered writer for very large OBJ files
+class ObjWriter {
+public:
+    explicit ObjWriter(const std::string& path) : buffer_(1 << 20) {
+        out_.rdbuf()->pubsetbuf(buffer_.data(), buffer_.size());
+        out_.open(path, std::ios::binary);
+    }
+    bool ok() const { return static_cast<bool>(out_); }
+    template <typename... Args>
+    void line(const char* format, Args... args) {
+        char text[256];
+        int len = std::snprintf(text, sizeof(text), format, args...);
+        out_.write(text, len);
+    }
+
+private:
+    std::vector<char> buffer_;
+    std::ofstream out_;
+};
+
+// Displaced height field, (n+1)^2 vertices and 2n^2 triangles, with normals and UVs
+static bool WriteGridObj(const std::string& path, size_t triangles) {
+    size_t n = std::max<size_t>(1, static_cast<size_t>(std::ceil(std::sqrt(triangles / 2.0))));
+    ObjWriter out(path);
+    for (size_t y = 0; y <= n; ++y) {
+        for (size_t x = 0; x <= n; ++x) {
+            float u = static_cast<float>(x) / n, v = static_cast<float>(y) / n;
+            out.line("v %.6f %.6f %.6f\n", u * 2.0f - 1.0f, 0.05f * std::sin(u * 40.0f) * std::cos(v * 37.0f), v * 2.0f - 1.0f);
+        }
+    }
+    for (size_t y = 0; y <= n; ++y)
+        for (size_t x = 0; x <= n; ++x)
+            out.line("vt %.6f %.6f\n", static_cast<float>(x) / n, static_cast<float>(y) / n);
+    for (size_t y = 0; y <= n; ++y) {
+        for (size_t x = 0; x <= n; ++x) {
+            float u = static_cast<float>(x) / n, v = static_cast<float>(y) / n;
+            float nx = -2.0f * std::cos(u * 40.0f) * std::cos(v * 37.0f);
+            float nz = 1.85f * std::sin(u * 40.0f) * std::sin(v * 37.0f);
+            float len = std::sqrt(nx * nx + 1.0f + nz * nz);
+            out.line("vn %.5f %.5f %.5f\n", nx / len, 1.0f / len, nz / len);
+        }
+    }
+    for (size_t y = 0; y < n; ++y) {
+        for (size_t x = 0; x < n; ++x) {
+            size_t i0 = y * (n + 1) + x + 1, i1 = i0 + 1, i2 = i0 + (n + 1), i3 = i2 + 1; // 1-based
+            out.line("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i0, i0, i0, i2, i2, i2, i1, i1, i1);
+            out.line("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i1, i1, i1, i2, i2, i2, i3, i3, i3);
+        }
+    }
+    return out.ok();
+}
+
+// UV sphere with rings x 2*rings quads: a closed mesh with a UV seam and pole fans.
+// `scan` turns it into scanner-like output: noisy radius, positions only, and
+// vertices and faces in scattered order.
+static bool WriteSphereObj(const std::string& path, size_t triangles, bool scan) {
+    const float PI = 3.14159265f;
+    size_t rings = std::max<size_t>(2, static_cast<size_t>(std::ceil(std::sqrt(triangles / 4.0))));
+    size_t segments = rings * 2;
+    size_t vertexCount = (rings + 1) * (segments + 1);
+    Scatter vertexOrder(vertexCount, scan ? 7 : 0);
+    std::vector<uint32_t> slotOf; // file position of grid vertex g (scan only)
+    if (scan) {
+        slotOf.resize(vertexCount);
+        for (size_t g = 0; g < vertexCount; ++g) slotOf[g] = static_cast<uint32_t>(vertexOrder(g));
+    }
+
+    // Scan files list vertices in scattered order, so also keep the inverse map
+    std::vector<uint32_t> gridAt;
+    if (scan) {
+        gridAt.resize(vertexCount);
+        for (size_t g = 0; g < vertexCount; ++g) gridAt[slotOf[g]] = static_cast<uint32_t>(g);
+    }
+
+    ObjWriter out(path);
+    for (size_t slot = 0; slot < vertexCount; ++slot) {
+        size_t g = scan ? gridAt[slot] : slot;
+        size_t r = g / (segments + 1), s = g % (segments + 1);
+        float theta = PI * r / rings, phi = 2.0f * PI * (s % segments) / segments; // seam shares positions exactly
+        glm::vec3 p(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        if (scan) {
+            float bump = ValueNoise(p.x * 6.0f + 11.0f, p.y * 6.0f + 17.0f, p.z * 6.0f + 23.0f);
+            float grain = HashUnit(g * 2654435761ull) - 0.5f;
+            p = p * (1.0f + 0.15f * bump + 0.002f * grain);
+        }
+        out.line("v %.6f %.6f %.6f\n", p.x, p.y, p.z);
+    }
+    if (!scan) {
+        for (size_t g = 0; g < vertexCount; ++g) {
+            size_t r = g / (segments + 1), s = g % (segments + 1);
+            out.line("vt %.6f %.6f\n", static_cast<float>(s) / segments, 1.0f - static_cast<float>(r) / rings);
+        }
+        for (size_t g = 0; g < vertexCount; ++g) {
+            size_t r = g / (segments + 1), s = g % (segments + 1);
+            float theta = PI * r / rings, phi = 2.0f * PI * (s % segments) / segments;
+            out.line("vn %.5f %.5f %.5f\n", std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        }
+    }
+
+    // Pole rows get one triangle per quad, the rest two
+    size_t faceCount = segments * 2 + (rings - 2) * segments * 2;
+    Scatter faceOrder(faceCount, scan ? 13 : 0);
+    auto vertexId = [&](size_t r, size_t s) -> size_t {
+        if (scan) // scans are welded: no seam column, one vertex per pole (the copies stay unreferenced)
+            s = (r == 0 || r == rings) ? 0 : s % segments;
+        size_t g = r * (segments + 1) + s;
+        return (scan ? slotOf[g] : g) + 1;
+    };
+    for (size_t f = 0; f < faceCount; ++f) {
+        size_t face = scan ? static_cast<size_t>(faceOrder(f)) : f;
+        size_t a, b, c;
+        if (face < segments) {                          // north cap
+            a = vertexId(0, face); b = vertexId(1, face + 1); c = vertexId(1, face);
+        } else if (face < segments * 2) {               // south cap
+            size_t s = face - segments;
+            a = vertexId(rings - 1, s); b = vertexId(rings - 1, s + 1); c = vertexId(rings, s);
+        } else {
+            size_t q = (face - segments * 2) / 2;
+            size_t r = 1 + q / segments, s = q % segments;
+            size_t i0 = vertexId(r, s), i1 = vertexId(r, s + 1), i2 = vertexId(r + 1, s), i3 = vertexId(r + 1, s + 1);
+            if ((face & 1) == 0) { a = i0; b = i1; c = i2; }
+            else { a = i1; b = i3; c = i2; }
+        }
+        if (scan) out.line("f %zu %zu %zu\n", a, b, c);
+        else out.line("f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c);
+    }
+    return out.ok();
+}
+
+// ─────────────────────────────────────────────
+// Stage runner and JSON report
+// ─────
+struct StageResult {
+    std::string name;
+    double ms = 0.0;
+    double throughput = 0.0;
+    const char* unit = "";
+    double peakRssMB = 0.0;
+};
+
+struct InputResult {
+    std::string shape;
+    size_t requestedTriangles = 0;
+    size_t triangles = 0;
+    size_t vertices = 0;
+    uint64_t objBytes = 0;
+    double generateMs = 0.0;
+    std::vector<StageResult> stages;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// `work` returns the amount processed in `unit`s (MB, M triangles, ...) for the throughput column
+static StageResult RunStage(const char* name, const char* unit, const std::function<double()>& work) {
+    ResetPeakRss();
+    auto t0 = Clock::now();
+    double amount = work();
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    StageResult result;
+    result.name = name;
+    result.ms = seconds * 1000.0;
+    result.throughput = seconds > 0.0 ? amount / seconds : 0.0;
+    result.unit = unit;
+    result.peakRssMB = PeakRssMB();
+    std::fprintf(stderr, "  %-10s %10.1f ms %10.2f %-10s peak %8.1f MB\n", name, result.ms, result.throughput, unit, result.peakRssMB);
+    return result;
+}
+
+static bool ParseSize(const std::string& text, size_t& value) {
+    char* end = nullptr;
+    double number = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || number <= 0.0) return false;
+    if (*end == 'k' || *end == 'K') number *= 1e3, ++end;
+    else if (*end == 'm' || *end == 'M') number *= 1e6, ++end;
+    if (*end != '\0') return false;
+    value = static_cast<size_t>(number);
+    return true;
+}
+
+static std::vector<std::string> SplitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+static std::string JsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+    return out;
+}
+
+static void WriteJson(std::ostream& out, const std::string& label, bool perStagePeak, const std::vector<InputResult>& results) {
+    char number[64];
+    auto fmt = [&](double v) { std::snprintf(number, sizeof(number), "%.3f", v); return std::string(number); };
+
+    out << "{\n  \"label\": \"" << JsonEscape(label) << "\",\n"
+        << "  \"timestamp\": " << static_cast<long long>(std::time(nullptr)) << ",\n"
+        << "  \"threads\": " << WorkerCount() << ",\n"
+        << "  \"peakRssPerStage\": " << (perStagePeak ? "true" : "false") << ",\n"
+        << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const InputResult& r = results[i];
+        out << (i ? "," : "") << "\n    {\"shape\": \"" << r.shape << "\", \"requestedTriangles\": " << r.requestedTriangles
+            << ", \"triangles\": " << r.triangles << ", \"vertices\": " << r.vertices
+            << ", \"objBytes\": " << r.objBytes << ", \"generateMs\": " << fmt(r.generateMs) << ",\n     \"stages\": [";
+        for (size_t k = 0; k < r.stages.size(); ++k) {
+            const StageResult& st = r.stages[k];
+            out << (k ? "," : "") << "\n       {\"name\": \"" << st.name << "\", \"ms\": " << fmt(st.ms)
+                << ", \"throughput\": " << fmt(st.throughput) << ", \"unit\": \"" << st.unit
+                << "\", \"peakRssMB\": " << fmt(st.peakRssMB) << "}";
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+// Mirrors the CPU half of the viewer's OBJ load (RunMeshLoad): parse, tangents, centering, optimization, packing
+static size_t RunImportChain(const std::string& path) {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    if (!ParseObjParallel(path, vertices, indices)) return 0;
+    ComputeTangents(vertices, indices);
+
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    for (const Vertex& v : vertices) {
+        minPos = glm::min(minPos, v.position);
+        maxPos = glm::max(maxPos, v.position);
+    }
+    glm::vec3 center = (minPos + maxPos) * 0.5f;
+    for (Vertex& v : vertices) v.position -= center;
+
+    OptimizeMesh(vertices, indices);
+
+    std::vector<PackedVertex> packed;
+    VertexDequantization dequant;
+    PackVertices(vertices.data(), vertices.size(), packed, dequant, nullptr);
+    std::vector<uint16_t> indices16;
+    if (CanUse16BitIndices(vertices.size())) PackIndices16(indices.data(), indices.size(), indices16);
+    return indices.size() / 3;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> shapes = { "grid", "sphere", "noise" };
+    std::vector<size_t> sizes = { 10000, 100000, 1000000 };
+    size_t lodMax = 2000000;
+    std::string jsonPath, label;
+    bool keep = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--keep") {
+            keep = true;
+        } else if (arg == "--shapes" && hasValue) {
+            shapes = SplitList(argv[++i]);
+        } else if (arg == "--sizes" && hasValue) {
+            sizes.clear();
+            for (const std::string& item : SplitList(argv[++i])) {
+                size_t value;
+                if (!ParseSize(item, value)) {
+                    std::cerr << "Bad size: " << item << std::endl;
+                    return 1;
+                }
+                sizes.push_back(value);
+            }
+        } else if (arg == "--lod-max" && hasValue) {
+            if (!ParseSize(argv[++i], lodMax)) lodMax = 0;
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--label" && hasValue) {
+            label = argv[++i];
+        } else {
+            std::cerr << "Usage: mesh_pipeline_bench [--shapes grid,sphere,noise] [--sizes 10k,100k,1m] "
+                         "[--lod-max 2m] [--json out.json] [--label name] [--keep]" << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& shape : shapes) {
+        if (shape != "grid" && shape != "sphere" && shape != "noise") {
+            std::cerr << "Unknown shape: " << shape << " (grid, sphere, noise)" << std::endl;
+            return 1;
+        }
+    }
+
+    bool perStagePeak = ResetPeakRss();
+    std::vector<InputResult> results;
+    for (const std::string& shape : shapes) {
+        for (size_t triangles : sizes) {
+            InputResult result;
+            result.shape = shape;
+            result.requestedTriangles = triangles;
+
+            std::string path = (std::filesystem::temp_directory_path() /
+                                ("mesh_pipeline_" + shape + "_" + std::to_string(triangles) + ".obj")).string();
+            auto t0 = Clock::now();
+            if (!std::filesystem::exists(path)) {
+                bool written = shape == "grid" ? WriteGridObj(path, triangles) : WriteSphereObj(path, triangles, shape == "noise");
+                if (!written) {
+                    std::cerr << "Cannot write " << path << std::endl;
+                    return 1;
+                }
+            }
+            result.generateMs = std::chrono::duration<double>(Clock::now() - t0).count() * 1000.0;
+            result.objBytes = std::filesystem::file_size(path);
+            std::fprintf(stderr, "%s %zu: %.1f MB OBJ\n", shape.c_str(), triangles, result.objBytes / (1024.0 * 1024.0));
+
+            // Every stage starts from its own copy of the previous stage's output
+            std::vector<Vertex> parsedVertices;
+            std::vector<unsigned int> parsedIndices;
+            bool parsed = false;
+            result.stages.push_back(RunStage("parse", "MB/s", [&]() {
+                parsed = ParseObjParallel(path, parsedVertices, parsedIndices);
+                return result.objBytes / (1024.0 * 1024.0);
+            }));
+            if (!parsed) {
+                std::cerr << "Parse failed: " << path << std::endl;
+                return 1;
+            }
+            result.triangles = parsedIndices.size() / 3;
+            result.vertices = parsedVertices.size();
+            const double mtris = result.triangles / 1e6;
+
+            std::vector<Vertex> vertices = parsedVertices;
+            result.stages.push_back(RunStage("tangents", "Mtris/s", [&]() {
+                ComputeTangents(vertices, parsedIndices);
+                return mtris;
+            }));
+            parsedVertices = vertices; // later stages see tangent-space input like the loader does
+
+            std::vector<unsigned int> indices = parsedIndices;
+            result.stages.push_back(RunStage("optimize", "Mtris/s", [&]() {
+                OptimizeMesh(vertices, indices);
+                return mtris;
+            }));
+
+            result.stages.push_back(RunStage("pack", "Mverts/s", [&]() {
+                std::vector<PackedVertex> packed;
+                VertexDequantization dequant;
+                PackVertices(vertices.data(), vertices.size(), packed, dequant, nullptr);
+                std::vector<uint16_t> indices16;
+                if (CanUse16BitIndices(vertices.size())) PackIndices16(indices.data(), indices.size(), indices16);
+                return vertices.size() / 1e6;
+            }));
+
+            if (result.triangles <= lodMax) {
+                result.stages.push_back(RunStage("lod", "Mtris/s", [&]() {
+                    std::vector<unsigned int> chain;
+                    std::vector<MeshLod> lods;
+                    BuildLodChain(vertices, indices, chain, lods);
+                    return mtris;
+                }));
+            }
+
+            result.stages.push_back(RunStage("meshlets", "Mtris/s", [&]() {
+                std::vector<unsigned int> clustered = indices;
+                std::vector<Meshlet> meshlets;
+                BuildMeshlets(vertices, clustered.data(), clustered.size(), 0, meshlets);
+                return mtris;
+            }));
+
+            // Release the stage inputs so the end-to-end peak is the import chain's own
+            std::vector<Vertex>().swap(parsedVertices);
+            std::vector<Vertex>().swap(vertices);
+            std::vector<unsigned int>().swap(parsedIndices);
+            std::vector<unsigned int>().swap(indices);
+            result.stages.push_back(RunStage("end_to_end", "MB/s", [&]() {
+                RunImportChain(path);
+                return result.objBytes / (1024.0 * 1024.0);
+            }));
+
+            if (!keep) std::filesystem::remove(path);
+            results.push_back(result);
+        }
+    }
+
+    if (jsonPath.empty()) {
+        WriteJson(std::cout, label, perStagePeak, results);
+    } else {
+        std::ofstream out(jsonPath);
+        WriteJson(out, label, perStagePeak, results);
+        if (!out) {
+            std::cerr << "Cannot write " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cerr << "Wrote " << jsonPath << std::endl;
+    }
+    return 0;
+}
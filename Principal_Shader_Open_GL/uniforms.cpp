@@ -27,9 +27,8 @@ MaterialUniforms getMaterialUniforms(GLuint program) {
     u.uDielectricF0 = glGetUniformLocation(program, "uDielectricF0");
     u.uNormalTex = glGetUniformLocation(program, "uNormalTex");
     u.uUseNormalTex = glGetUniformLocation(program, "uUseNormalTex");
-    u.uRoughnessMap = glGetUniformLocation(program, "roughnessMap");
-    u.uAOMap = glGetUniformLocation(program, "aoMap");
-    u.uMetallicMap = glGetUniformLocation(program, "metallicMap");
+    u.uRoughMetalMap = glGetUniformLocation(program, "roughMetalMap");
+    u.uOcclusionMap = glGetUniformLocation(program, "occlusionMap");
     u.uUseRoughnessMap = glGetUniformLocation(program, "useRoughnessMap");
     u.uUseMetallicMap = glGetUniformLocation(program, "useMetallicMap");
     u.uUseAOMap = glGetUniformLocation(program, "useAOMap");
@@ -41,6 +40,9 @@ VertexUniforms getVertexUniforms(GLuint program) {
     u.modelMatrix = glGetUniformLocation(program, "modelMatrix");
     u.viewMatrix = glGetUniformLocation(program, "viewMatrix");
     u.projectionMatrix = glGetUniformLocation(program, "projectionMatrix");
+    u.positionOffset = glGetUniformLocation(program, "uPositionOffset");
+    u.positionScale = glGetUniformLocation(program, "uPositionScale");
+    u.uvTransform = glGetUniformLocation(program, "uUVTransform");
     return u;
 }
 
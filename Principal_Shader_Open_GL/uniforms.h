@@ -22,9 +22,8 @@ GLint uMetallic;
 GLint uDielectricF0;
 GLint uNormalTex;
 GLint uUseNormalTex;
-GLint uRoughnessMap;
-GLint uMetallicMap;
-GLint uAOMap;
+GLint uRoughMetalMap;   // roughness / metallic in R / G
+GLint uOcclusionMap;
 GLint uUseRoughnessMap;
 GLint uUseMetallicMap;
 GLint uUseAOMap;
@@ -34,6 +33,9 @@ struct VertexUniforms {
 GLint modelMatrix;
 GLint viewMatrix;
 GLint projectionMatrix;
+GLint positionOffset;
+GLint positionScale;
+GLint uvTransform;
 };
 
 
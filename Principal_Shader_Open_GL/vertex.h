@@ -0,0 +1,15 @@
+// vertex.h
+#pragma once
+#include <glm/glm.hpp>
+
+// ─────────────────────────────────────────────
+// Vertex struct: holds per-vertex data
+// ─────
+// Needed to send position, normal, UV, and tangent to the GPU.
+// Kept free of GL headers so CPU-only code (parsers, tools) can use it.
+struct Vertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 texCoord;
+    glm::vec4 tangent = glm::vec4(0.0); // xyz = tangent, w = bitangent sign (+1 / -1)
+};
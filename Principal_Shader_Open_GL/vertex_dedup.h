@@ -0,0 +1,79 @@
+// vertex_dedup.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// OBJ corner deduplication
+// ─────
+// An OBJ face corner is a (position, normal, texcoord) index triple. Two corners
+// with the same triple become the same GPU vertex. The triple is packed into a
+// 12-byte integer key and looked up in an open-addressing (linear probing) table,
+// so no strings or per-node heap allocations happen on this hot path.
+struct CornerKey {
+    uint32_t v, n, t; // OBJ indices shifted by +1 so that "missing" (-1) becomes 0
+};
+
+struct CornerSlot {
+    CornerKey key;
+    uint32_t vertex; // index into the output vertex array, EMPTY_CORNER_SLOT when unused
+};
+
+const uint32_t EMPTY_CORNER_SLOT = 0xFFFFFFFFu;
+
+inline uint32_t HashCornerKey(const CornerKey& k) {
+    // 64-bit multiply/xor-shift mix; cheap and spreads neighbouring indices well
+    uint64_t h = (uint64_t(k.v) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(k.n) * 0xC2B2AE3D27D4EB4Full) ^ (uint64_t(k.t) * 0x165667B19E3779F9ull);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return static_cast<uint32_t>(h);
+}
+
+struct CornerHashTable {
+    std::vector<CornerSlot> slots;
+    size_t mask = 0;
+    size_t count = 0;
+
+    explicit CornerHashTable(size_t expectedUnique) {
+        size_t capacity = 16;
+        while (capacity < expectedUnique * 2) capacity <<= 1; // keep load factor <= 0.5 up front
+        resize(capacity);
+    }
+
+    void resize(size_t capacity) {
+        std::vector<CornerSlot> old;
+        old.swap(slots);
+        slots.assign(capacity, CornerSlot{ {0, 0, 0}, EMPTY_CORNER_SLOT });
+        mask = capacity - 1;
+        for (const CornerSlot& s : old) {
+            if (s.vertex == EMPTY_CORNER_SLOT) continue;
+            size_t i = HashCornerKey(s.key) & mask;
+            while (slots[i].vertex != EMPTY_CORNER_SLOT) i = (i + 1) & mask;
+            slots[i] = s;
+        }
+    }
+
+    // Returns the existing vertex for this key, or inserts `newVertex` and returns it.
+    // `inserted` tells the caller whether it has to emit a new Vertex.
+    uint32_t findOrInsert(const CornerKey& key, uint32_t newVertex, bool& inserted) {
+        if ((count + 1) * 10 > slots.size() * 7) resize(slots.size() * 2); // grow past 0.7 load
+        size_t i = HashCornerKey(key) & mask;
+        for (;;) {
+            CornerSlot& s = slots[i];
+            if (s.vertex == EMPTY_CORNER_SLOT) {
+                s.key = key;
+                s.vertex = newVertex;
+                ++count;
+                inserted = true;
+                return newVertex;
+            }
+            if (s.key.v == key.v && s.key.n == key.n && s.key.t == key.t) {
+                inserted = false;
+                return s.vertex;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+};
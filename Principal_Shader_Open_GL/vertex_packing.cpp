@@ -0,0 +1,151 @@
+// vertex_packing.cpp
+#include "vertex_packing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+static const float UNORM16_MAX = 65535.0f;
+static const float SNORM10_MAX = 511.0f;
+
+static uint16_t QuantizeUnorm16(float value, float offset, float invScale) {
+    float q = (value - offset) * invScale;
+    return static_cast<uint16_t>(std::min(std::max(std::round(q), 0.0f), UNORM16_MAX));
+}
+
+// What normalized GL_UNSIGNED_SHORT fetch hands the shader: q / 65535, in [0, 1]
+static float UnpackUnorm16(uint16_t q) {
+    return static_cast<float>(q) / UNORM16_MAX;
+}
+
+static uint32_t QuantizeSnorm10(float value) {
+    int q = static_cast<int>(std::round(std::min(std::max(value, -1.0f), 1.0f) * SNORM10_MAX));
+    return static_cast<uint32_t>(q) & 0x3FFu;
+}
+
+// GL_INT_2_10_10_10_REV: x in the low bits, w in the top two
+static uint32_t PackSnorm1010102(const glm::vec3& v, float w) {
+    uint32_t qw = w < 0.0f ? 0x3u : (w > 0.0f ? 0x1u : 0x0u);
+    return QuantizeSnorm10(v.x) | (QuantizeSnorm10(v.y) << 10) | (QuantizeSnorm10(v.z) << 20) | (qw << 30);
+}
+
+// Same conversion as the GL (signed normalized, -512 clamps to -1)
+static glm::vec3 UnpackSnorm1010102(uint32_t packed) {
+    glm::vec3 v;
+    for (int c = 0; c < 3; ++c) {
+        int q = static_cast<int>((packed >> (10 * c)) & 0x3FFu);
+        if (q & 0x200) q -= 0x400;
+        v[c] = std::max(static_cast<float>(q) / SNORM10_MAX, -1.0f);
+    }
+    return v;
+}
+
+static glm::vec3 SafeNormalize(const glm::vec3& v) {
+    float len2 = glm::dot(v, v);
+    return len2 > 0.0f ? v / std::sqrt(len2) : glm::vec3(0.0f);
+}
+
+static float AngleDegrees(const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 na = SafeNormalize(a), nb = SafeNormalize(b);
+    if (glm::dot(na, na) == 0.0f || glm::dot(nb, nb) == 0.0f) return 0.0f;
+    float c = std::min(std::max(glm::dot(na, nb), -1.0f), 1.0f);
+    return std::acos(c) * 57.2957795f;
+}
+
+// Dequantization scale and quantization factor for one axis spanning `range`. The attributes
+// are fetched normalized, so the shader sees q / 65535 and the scale is the whole range. A flat axis
+// (a planar mesh, constant UVs) quantizes everything to 0 and decodes to the offset
+// exactly; dividing by its zero range would turn every value into 0 * inf = NaN.
+static void AxisQuantization(float range, float& scale, float& inverse) {
+    if (range > 0.0f && std::isfinite(range)) {
+        scale = range;
+        inverse = UNORM16_MAX / range;
+    } else {
+        scale = 0.0f;
+        inverse = 0.0f;
+    }
+}
+
+void PackVertices(const Vertex* vertices, size_t vertexCount, std::vector<PackedVertex>& packed,
+                  VertexDequantization& dequant, VertexPackingReport* report) {
+    packed.resize(vertexCount);
+    dequant = VertexDequantization();
+    if (vertexCount == 0) return;
+
+    glm::vec3 minPos(FLT_MAX), maxPos(-FLT_MAX);
+    glm::vec2 minUV(FLT_MAX), maxUV(-FLT_MAX);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        minPos = glm::min(minPos, vertices[i].position);
+        maxPos = glm::max(maxPos, vertices[i].position);
+        minUV = glm::min(minUV, vertices[i].texCoord);
+        maxUV = glm::max(maxUV, vertices[i].texCoord);
+    }
+
+    glm::vec3 posScale, posInv;
+    glm::vec2 uvScale, uvInv;
+    for (int c = 0; c < 3; ++c) AxisQuantization(maxPos[c] - minPos[c], posScale[c], posInv[c]);
+    for (int c = 0; c < 2; ++c) AxisQuantization(maxUV[c] - minUV[c], uvScale[c], uvInv[c]);
+    dequant.positionOffset = minPos;
+    dequant.positionScale = posScale;
+    dequant.uvTransform = glm::vec4(minUV, uvScale);
+
+    float maxPosErr = 0.0f, maxNormalErr = 0.0f, maxTangentErr = 0.0f, maxUVErr = 0.0f;
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const Vertex& v = vertices[i];
+        PackedVertex& p = packed[i];
+        for (int c = 0; c < 3; ++c)
+            p.position[c] = QuantizeUnorm16(v.position[c], minPos[c], posInv[c]);
+        p.padding = 0;
+        p.normal = PackSnorm1010102(SafeNormalize(v.normal), 0.0f);
+        p.tangent = PackSnorm1010102(SafeNormalize(glm::vec3(v.tangent)), v.tangent.w);
+        p.texCoord[0] = QuantizeUnorm16(v.texCoord.x, minUV.x, uvInv.x);
+        p.texCoord[1] = QuantizeUnorm16(v.texCoord.y, minUV.y, uvInv.y);
+
+        if (!report) continue;
+        for (int c = 0; c < 3; ++c) {
+            float decoded = dequant.positionOffset[c] + dequant.positionScale[c] * UnpackUnorm16(p.position[c]);
+            maxPosErr = std::max(maxPosErr, std::fabs(decoded - v.position[c]));
+        }
+        for (int c = 0; c < 2; ++c) {
+            float decoded = dequant.uvTransform[c] + dequant.uvTransform[c + 2] * UnpackUnorm16(p.texCoord[c]);
+            maxUVErr = std::max(maxUVErr, std::fabs(decoded - v.texCoord[c]));
+        }
+        maxNormalErr = std::max(maxNormalErr, AngleDegrees(v.normal, UnpackSnorm1010102(p.normal)));
+        maxTangentErr = std::max(maxTangentErr, AngleDegrees(glm::vec3(v.tangent), UnpackSnorm1010102(p.tangent)));
+    }
+
+    if (report) {
+        report->vertexBytesBefore = vertexCount * sizeof(Vertex);
+        report->vertexBytesAfter = vertexCount * sizeof(PackedVertex);
+        report->maxPositionError = maxPosErr;
+        const glm::vec3& range = dequant.positionScale;
+        report->positionErrorBound = 0.5f * std::max(range.x, std::max(range.y, range.z)) / UNORM16_MAX;
+        report->maxNormalError = maxNormalErr;
+        report->maxTangentError = maxTangentErr;
+        report->maxUVError = maxUVErr;
+    }
+}
+
+bool CanUse16BitIndices(size_t vertexCount) {
+    return vertexCount <= 65536; // every index fits in 0..65535
+}
+
+void PackIndices16(const unsigned int* indices, size_t indexCount, std::vector<uint16_t>& packed) {
+    packed.resize(indexCount);
+    for (size_t i = 0; i < indexCount; ++i)
+        packed[i] = static_cast<uint16_t>(indices[i]);
+}
+
+void PrintVertexPackingReport(const VertexPackingReport& report) {
+    size_t before = report.vertexBytesBefore + report.indexBytesBefore;
+    size_t after = report.vertexBytesAfter + report.indexBytesAfter;
+    std::cout << "Mesh memory: " << before / 1024.0 << " KB -> " << after / 1024.0 << " KB ("
+              << (before ? 100.0 * (1.0 - static_cast<double>(after) / before) : 0.0) << "% saved; vertices "
+              << report.vertexBytesBefore / 1024.0 << " -> " << report.vertexBytesAfter / 1024.0 << " KB, indices "
+              << report.indexBytesBefore / 1024.0 << " -> " << report.indexBytesAfter / 1024.0 << " KB)" << std::endl;
+    if (report.vertexBytesAfter != report.vertexBytesBefore) {
+        std::cout << "Quantization error: position " << report.maxPositionError << " (bound " << report.positionErrorBound
+                  << "), normal " << report.maxNormalError << " deg, tangent " << report.maxTangentError
+                  << " deg, uv " << report.maxUVError << std::endl;
+    }
+}
@@ -0,0 +1,56 @@
+// vertex_packing.h
+#pragma once
+#include "vertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Compact vertex format
+// ─────
+// 20 bytes instead of the 48 of Vertex, decoded by the vertex fetch hardware:
+//   position : unorm16 x3 within the mesh bounds, fetched normalized to [0, 1] and
+//              rebuilt in basic.vert as uPositionOffset + uPositionScale * aPos
+//   normal   : snorm 10-10-10-2 (GL_INT_2_10_10_10_REV)
+//   tangent  : snorm 10-10-10-2, the 2-bit w holds the bitangent sign exactly
+//   texCoord : unorm16 x2 within the UV bounds, rebuilt with uUVTransform
+// Quantizing UVs to their own bounds beats half floats for tiled UVs, where a
+// half loses precision quickly above 1.0.
+enum VertexFormat {
+    VERTEX_FORMAT_FLOAT,  // Vertex as-is
+    VERTEX_FORMAT_PACKED  // PackedVertex
+};
+
+struct PackedVertex {
+    uint16_t position[3];
+    uint16_t padding;     // keeps the 32-bit attributes aligned
+    uint32_t normal;
+    uint32_t tangent;
+    uint16_t texCoord[2];
+};
+
+// How to turn the normalized attributes back into model space / UV space
+struct VertexDequantization {
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f); // the bounds' extent: attributes arrive in [0, 1]
+    glm::vec4 uvTransform = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // xy = offset, zw = scale (the UV extent)
+};
+
+// Per-mesh memory and accuracy report; errors are measured by decoding every vertex
+struct VertexPackingReport {
+    size_t vertexBytesBefore = 0;
+    size_t vertexBytesAfter = 0;
+    size_t indexBytesBefore = 0;
+    size_t indexBytesAfter = 0;
+    float maxPositionError = 0.0f;   // model units
+    float positionErrorBound = 0.0f; // half a quantization step along the longest axis
+    float maxNormalError = 0.0f;     // degrees
+    float maxTangentError = 0.0f;    // degrees
+    float maxUVError = 0.0f;         // UV units
+};
+
+void PackVertices(const Vertex* vertices, size_t vertexCount, std::vector<PackedVertex>& packed,
+                  VertexDequantization& dequant, VertexPackingReport* report = nullptr);
+bool CanUse16BitIndices(size_t vertexCount);
+void PackIndices16(const unsigned int* indices, size_t indexCount, std::vector<uint16_t>& packed);
+void PrintVertexPackingReport(const VertexPackingReport& report);
@@ -0,0 +1,986 @@
+// virtual_texture.cpp
+#include "virtual_texture.h"
+#include "file_utils.h"
+#include "gpu_memory.h"
+#include "job_system.h"
+#include "material_pack.h"
+#include "shader_utils.h"
+#include "texture_cache.h"
+#include "External/stb_image.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+// Bump whenever the file layout or the page encoding changes
+static const uint32_t VIRTUAL_TEXTURE_VERSION = 1;
+static const char VIRTUAL_TEXTURE_MAGIC[8] = { 'P', 'B', 'R', 'V', 'T', '\0', '\0', '\0' };
+static const size_t FEEDBACK_RING_SIZE = 3;
+
+struct VirtualTextureHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t format;      // TexelFormat of every page: BC1 / BC4 / BC5, or RGBA8 uncompressed
+    uint32_t width;       // level 0, powers of two (other sizes are resampled when building)
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t pageSize;    // VT_PAGE_SIZE and VT_PAGE_BORDER at build time
+    uint32_t pageBorder;
+    uint32_t flipY;
+    uint32_t mipKey;      // MipOptionsKey of the filter that built the chain
+    uint32_t reserved;
+    uint64_t sourceSize;  // single images: the source's identity, as in .pbrtex caches
+    int64_t  sourceMTime;
+    uint64_t sourceHash;
+    uint64_t contentHash; // packed maps: the inputs' combined hash
+    // followed by one uint64_t file offset per page (level by level, rows bottom up), then the pages
+};
+
+// Pages of one level and where they sit in the indirection atlas: level 0 at the
+// origin, the smaller levels stacked in a column to its right
+struct VirtualLevel {
+    int width = 0;
+    int height = 0;
+    int pagesX = 0;
+    int pagesY = 0;
+    size_t firstPage = 0; // page table index of page (0, 0)
+    int atlasX = 0;
+    int atlasY = 0;
+};
+
+struct LoadedPage {
+    uint32_t page = 0;
+    std::vector<unsigned char> data;
+    std::string error; // the read threw; `data` is empty
+};
+
+struct CacheSlot {
+    int32_t page = -1;     // page table index, -1 = free
+    uint64_t lastSeen = 0; // feedback frame that last asked for it (LRU order)
+    bool pinned = false;   // single-page levels, the fallback for everything else
+};
+
+// Build fields are written by the job before `built`; the rest belongs to the GL thread
+// except `loaded`, which page jobs append to under `loadMutex`.
+struct VirtualTextureState {
+    VirtualTexture* owner = nullptr;
+    std::vector<std::string> paths;
+    std::string name;
+    TextureOptions options;
+    std::chrono::steady_clock::time_point queued;
+
+    std::atomic<bool> built{ false };
+    std::atomic<bool> released{ false };
+    bool ok = false;
+    std::string error; // what the build threw, reported by UpdateVirtualTextures
+    MappedFile file;
+    TexelFormat format = TexelFormat::RGBA8;
+    int width = 0;
+    int height = 0;
+    size_t pageBytes = 0;
+    std::vector<VirtualLevel> levels;
+    std::vector<uint64_t> pageOffsets;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+
+    std::mutex loadMutex;
+    std::vector<LoadedPage> loaded;
+
+    GLuint physical = 0;
+    GLuint indirection = 0;
+    GLenum internalFormat = 0;
+    int slotsPerSide = 0;
+    std::vector<CacheSlot> slots;
+    std::vector<int32_t> pageSlots;     // page -> slot, -1 = not resident
+    std::vector<uint8_t> pageLoading;   // read in flight
+    std::vector<uint64_t> pageWanted;   // feedback frame that last asked for the page
+    std::vector<unsigned char> indirectionTexels; // RGBA8: slot x, slot y, resident level, 255
+    bool indirectionDirty = false;
+    size_t loadsInFlight = 0;
+    size_t residentPages = 0;
+    uint64_t lastFeedback = 0;
+};
+
+struct FeedbackReadback {
+    GLuint buffer = 0;
+    size_t size = 0;
+    GLsync fence = nullptr;
+    int width = 0;
+    int height = 0;
+    uint64_t frame = 0;
+};
+
+static std::vector<std::shared_ptr<VirtualTextureState>> g_states; // GL thread only, building and ready
+static VirtualTextureStats g_stats;
+
+static GLuint g_feedbackProgram = 0;
+static GLint g_feedbackScaleLoc = -1;
+static GLuint g_feedbackFbo = 0;
+static GLuint g_feedbackColor = 0;
+static GLuint g_feedbackDepth = 0;
+static int g_feedbackWidth = 0;
+static int g_feedbackHeight = 0;
+static int g_viewWidth = 0;
+static int g_viewHeight = 0;
+static GLfloat g_clearColor[4] = {};
+static FeedbackReadback g_readbacks[FEEDBACK_RING_SIZE];
+static size_t g_nextReadback = 0;
+static uint64_t g_feedbackFrame = 0;
+
+bool VirtualTexture::ready() const {
+    return state && state->physical != 0;
+}
+
+static int VirtualTextureMinSize() {
+    static const int size = [] {
+        const char* env = std::getenv("PBR_VIRTUAL_TEXTURE_SIZE");
+        return env ? std::max(0, std::atoi(env)) : 8192;
+    }();
+    return size;
+}
+
+bool WantsVirtualTexture(const std::vector<std::string>& channelPaths) {
+    int largest = 0;
+    for (const std::string& path : channelPaths) {
+        if (path.empty()) continue;
+        if (std::filesystem::path(path).extension() == ".pbrvt") return true;
+        int width = 0, height = 0, channels = 0;
+        if (stbi_info(path.c_str(), &width, &height, &channels)) largest = std::max({ largest, width, height });
+    }
+    return VirtualTextureMinSize() > 0 && largest >= VirtualTextureMinSize();
+}
+
+// ─────────────────────────────────────────────
+// Tiled file (.pbrvt)
+// ─────
+static int PagesAcross(int texels) {
+    return (texels + VT_PAGE_SIZE - 1) / VT_PAGE_SIZE;
+}
+
+static void LayoutLevels(VirtualTextureState& state, int levelCount) {
+    state.levels.assign(levelCount, VirtualLevel());
+    size_t pages = 0;
+    int columnY = 0;
+    for (int l = 0; l < levelCount; ++l) {
+        VirtualLevel& level = state.levels[l];
+        level.width = std::max(state.width >> l, 1);
+        level.height = std::max(state.height >> l, 1);
+        level.pagesX = PagesAcross(level.width);
+        level.pagesY = PagesAcross(level.height);
+        level.firstPage = pages;
+        pages += static_cast<size_t>(level.pagesX) * level.pagesY;
+        if (l > 0) {
+            level.atlasX = state.levels[0].pagesX;
+            level.atlasY = columnY;
+            columnY += level.pagesY;
+        }
+    }
+    state.atlasWidth = state.levels[0].pagesX + (levelCount > 1 ? state.levels[1].pagesX : 0);
+    state.atlasHeight = std::max(state.levels[0].pagesY, columnY);
+    state.pageOffsets.assign(pages, 0);
+}
+
+static size_t PageIndex(const VirtualTextureState& state, int level, int x, int y) {
+    const VirtualLevel& l = state.levels[level];
+    return l.firstPage + static_cast<size_t>(y) * l.pagesX + x;
+}
+
+static bool StatSource(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Maps `path` and reads its layout into `state`; `expected` carries the encoding and, unless
+// `anySource`, the source identity the file must match
+static bool OpenTiledFile(const std::string& path, const VirtualTextureHeader& expected, bool anySource,
+                          VirtualTextureState& state) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return false;
+    if (!state.file.open(path)) {
+        std::cerr << "Cannot map virtual texture: " << path << std::endl;
+        return false;
+    }
+    VirtualTextureHeader header;
+    if (state.file.size() < sizeof(header)) return false;
+    std::memcpy(&header, state.file.data(), sizeof(header));
+    if (std::memcmp(header.magic, VIRTUAL_TEXTURE_MAGIC, sizeof(VIRTUAL_TEXTURE_MAGIC)) != 0 ||
+        header.version != VIRTUAL_TEXTURE_VERSION || header.pageSize != VT_PAGE_SIZE ||
+        header.pageBorder != VT_PAGE_BORDER) {
+        std::cout << "Virtual texture out of date (version), rebuilding: " << path << std::endl;
+        state.file.close();
+        return false;
+    }
+    if (!anySource && (header.format != expected.format || header.flipY != expected.flipY ||
+                       header.mipKey != expected.mipKey || header.sourceSize != expected.sourceSize ||
+                       header.sourceMTime != expected.sourceMTime || header.sourceHash != expected.sourceHash ||
+                       header.contentHash != expected.contentHash)) {
+        std::cout << "Virtual texture out of date (source or format changed), rebuilding: " << path << std::endl;
+        state.file.close();
+        return false;
+    }
+
+    const TexelFormat format = static_cast<TexelFormat>(header.format);
+    bool valid = (IsCompressedFormat(format) || format == TexelFormat::RGBA8) && header.width > 0 &&
+                 header.height > 0 && header.levelCount >= 1 && header.levelCount <= VT_MAX_LEVELS &&
+                 static_cast<int>(header.levelCount) <= MipLevelCount(header.width, header.height);
+    if (valid) {
+        state.format = format;
+        state.width = static_cast<int>(header.width);
+        state.height = static_cast<int>(header.height);
+        state.pageBytes = TexelLevelSize(format, VT_PAGE_STRIDE, VT_PAGE_STRIDE);
+        LayoutLevels(state, static_cast<int>(header.levelCount));
+        const size_t tableBytes = state.pageOffsets.size() * sizeof(uint64_t);
+        valid = sizeof(header) + tableBytes <= state.file.size();
+        if (valid) std::memcpy(state.pageOffsets.data(), state.file.data() + sizeof(header), tableBytes);
+        for (size_t i = 0; valid && i < state.pageOffsets.size(); ++i)
+            valid = state.pageOffsets[i] + state.pageBytes <= state.file.size();
+    }
+    if (!valid) {
+        std::cerr << "Virtual texture truncated: " << path << std::endl;
+        state.file.close();
+        return false;
+    }
+    return true;
+}
+
+// Bilinear resample up to the next power of two in each direction, so every level
+// halves exactly and page (x, y)'s parent is always page (x / 2, y / 2)
+static void ResampleToPowerOfTwo(const unsigned char* pixels, int width, int height, int channels,
+                                 std::vector<unsigned char>& out, int& outWidth, int& outHeight) {
+    outWidth = 1;
+    outHeight = 1;
+    while (outWidth < width) outWidth <<= 1;
+    while (outHeight < height) outHeight <<= 1;
+    out.resize(static_cast<size_t>(outWidth) * outHeight * channels);
+    ParallelFor(static_cast<size_t>(outHeight), [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+            const float sy = std::min(std::max((y + 0.5f) * height / outHeight - 0.5f, 0.0f), height - 1.0f);
+            const int y0 = static_cast<int>(sy), y1 = std::min(y0 + 1, height - 1);
+            const float fy = sy - y0;
+            for (int x = 0; x < outWidth; ++x) {
+                const float sx = std::min(std::max((x + 0.5f) * width / outWidth - 0.5f, 0.0f), width - 1.0f);
+                const int x0 = static_cast<int>(sx), x1 = std::min(x0 + 1, width - 1);
+                const float fx = sx - x0;
+                for (int c = 0; c < channels; ++c) {
+                    auto at = [&](int px, int py) {
+                        return static_cast<float>(pixels[(static_cast<size_t>(py) * width + px) * channels + c]);
+                    };
+                    const float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+                    const float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+                    out[(y * outWidth + x) * channels + c] =
+                        static_cast<unsigned char>(std::lround(top + (bottom - top) * fy));
+                }
+            }
+        }
+    }, 0, 16);
+}
+
+// One page of `level` with its border (wrapped around the level's edges, as GL_REPEAT
+// samples), block-compressed or expanded to RGBA8 into `out`
+static void EncodePage(const MipChain& chain, const VirtualLevel& level, int levelIndex, int pageX, int pageY,
+                       TexelFormat format, unsigned char* out) {
+    const int channels = chain.channels;
+    const bool compressed = IsCompressedFormat(format);
+    const unsigned char* src = chain.data.data() + chain.levelOffsets[levelIndex];
+
+    MipChain page;
+    page.width = VT_PAGE_STRIDE;
+    page.height = VT_PAGE_STRIDE;
+    page.channels = compressed ? channels : 4;
+    page.data.resize(static_cast<size_t>(VT_PAGE_STRIDE) * VT_PAGE_STRIDE * page.channels);
+    page.levelOffsets = { 0 };
+    page.levelSizes = { page.data.size() };
+    for (int y = 0; y < VT_PAGE_STRIDE; ++y) {
+        int sy = (pageY * VT_PAGE_SIZE - VT_PAGE_BORDER + y) % level.height;
+        if (sy < 0) sy += level.height;
+        for (int x = 0; x < VT_PAGE_STRIDE; ++x) {
+            int sx = (pageX * VT_PAGE_SIZE - VT_PAGE_BORDER + x) % level.width;
+            if (sx < 0) sx += level.width;
+            const unsigned char* texel = src + (static_cast<size_t>(sy) * level.width + sx) * channels;
+            unsigned char* dst = page.data.data() + (static_cast<size_t>(y) * VT_PAGE_STRIDE + x) * page.channels;
+            if (compressed) {
+                std::memcpy(dst, texel, channels);
+            } else {
+                // Two channels stay R / G as in a regular RG texture (packed roughness / metallic);
+                // gray spreads over RGB; missing alpha is opaque
+                dst[0] = texel[0];
+                dst[1] = channels >= 2 ? texel[1] : texel[0];
+                dst[2] = channels >= 3 ? texel[2] : channels == 1 ? texel[0] : 0;
+                dst[3] = channels == 4 ? texel[3] : 255;
+            }
+        }
+    }
+    if (!compressed) {
+        std::memcpy(out, page.data.data(), page.data.size());
+        return;
+    }
+    CompressedImage image;
+    CompressImage(page, static_cast<TextureCompression>(format), image);
+    std::memcpy(out, image.data.data(), image.data.size());
+}
+
+// Decodes (and packs) the sources, filters the mip chain and writes every page to `path`
+static bool BuildTiledFile(VirtualTextureState& state, const std::string& path, VirtualTextureHeader header) {
+    const TextureOptions& options = state.options;
+    const size_t count = state.paths.size();
+    std::vector<std::unique_ptr<unsigned char, void (*)(void*)>> decoded;
+    std::vector<ChannelSource> sources(count);
+    for (size_t c = 0; c < count; ++c) {
+        decoded.emplace_back(nullptr, stbi_image_free);
+        if (state.paths[c].empty()) continue; // constant channel
+        MappedFile file;
+        ChannelSource& source = sources[c];
+        if (file.open(state.paths[c]))
+            decoded[c].reset(stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &source.width,
+                                                   &source.height, &source.channels, 0));
+        if (!decoded[c]) {
+            std::cerr << "Failed to load texture at: " << state.paths[c] << std::endl;
+            return false;
+        }
+        source.pixels = decoded[c].get();
+    }
+
+    // One image as decoded, several through the channel packer (material_pack.h)
+    std::vector<unsigned char> packed;
+    unsigned char* pixels = nullptr;
+    int width = 0, height = 0, channels = 0;
+    if (count == 1) {
+        pixels = decoded[0].get();
+        width = sources[0].width;
+        height = sources[0].height;
+        channels = sources[0].channels;
+    } else {
+        if (!PackChannels(sources.data(), static_cast<int>(count), packed, width, height)) return false;
+        decoded.clear();
+        pixels = packed.data();
+        channels = static_cast<int>(count);
+    }
+    if (options.flipY) FlipRows(pixels, height, static_cast<size_t>(width) * channels);
+
+    std::vector<unsigned char> resampled;
+    if ((width & (width - 1)) != 0 || (height & (height - 1)) != 0) {
+        int pow2Width = 0, pow2Height = 0;
+        ResampleToPowerOfTwo(pixels, width, height, channels, resampled, pow2Width, pow2Height);
+        std::cout << "Virtual texture " << state.name << ": resampled " << width << "x" << height << " to "
+                  << pow2Width << "x" << pow2Height << std::endl;
+        pixels = resampled.data();
+        width = pow2Width;
+        height = pow2Height;
+    }
+
+    MipChain chain;
+    const int levelCount = std::min(MipLevelCount(width, height), VT_MAX_LEVELS);
+    bool ok = GenerateMipChain(pixels, width, height, channels, options.mips, chain, levelCount);
+    decoded.clear();
+    packed = std::vector<unsigned char>();
+    resampled = std::vector<unsigned char>();
+    if (!ok) return false;
+
+    state.format = static_cast<TexelFormat>(header.format);
+    state.width = width;
+    state.height = height;
+    state.pageBytes = TexelLevelSize(state.format, VT_PAGE_STRIDE, VT_PAGE_STRIDE);
+    LayoutLevels(state, levelCount);
+
+    // Pages of a level are encoded in parallel into one buffer; the chain level is dropped after
+    std::vector<std::vector<unsigned char>> levelPages(levelCount);
+    for (int l = 0; l < levelCount; ++l) {
+        const VirtualLevel& level = state.levels[l];
+        const size_t pages = static_cast<size_t>(level.pagesX) * level.pagesY;
+        levelPages[l].resize(pages * state.pageBytes);
+        ParallelFor(pages, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p)
+                EncodePage(chain, level, l, static_cast<int>(p % level.pagesX), static_cast<int>(p / level.pagesX),
+                           state.format, levelPages[l].data() + p * state.pageBytes);
+        });
+    }
+    chain = MipChain();
+
+    header.width = static_cast<uint32_t>(width);
+    header.height = static_cast<uint32_t>(height);
+    header.levelCount = static_cast<uint32_t>(levelCount);
+    static const unsigned char zeros[16] = {};
+    const uint64_t tableEnd = sizeof(header) + state.pageOffsets.size() * sizeof(uint64_t);
+    const uint64_t dataStart = AlignUp(tableEnd, 16); // page sizes are multiples of 16 (34^2 blocks)
+    for (size_t p = 0; p < state.pageOffsets.size(); ++p) state.pageOffsets[p] = dataStart + p * state.pageBytes;
+    std::vector<FileChunk> chunks;
+    chunks.push_back({ &header, sizeof(header) });
+    chunks.push_back({ state.pageOffsets.data(), state.pageOffsets.size() * sizeof(uint64_t) });
+    if (dataStart != tableEnd) chunks.push_back({ zeros, static_cast<size_t>(dataStart - tableEnd) });
+    for (const auto& pages : levelPages) chunks.push_back({ pages.data(), pages.size() });
+    if (!WriteFileAtomic(path, chunks)) {
+        std::cerr << "Failed to write virtual texture: " << path << std::endl;
+        return false;
+    }
+    levelPages.clear();
+    state.file.close();
+    return OpenTiledFile(path, header, false, state);
+}
+
+// Job: opens the tiled file next to the source, building it first when missing or stale
+static void PrepareTiledFile(VirtualTextureState& state) {
+    const std::string& first = state.paths[0];
+    if (state.paths.size() == 1 && std::filesystem::path(first).extension() == ".pbrvt") {
+        state.ok = OpenTiledFile(first, VirtualTextureHeader(), true, state);
+        return;
+    }
+
+    VirtualTextureHeader header = {};
+    std::memcpy(header.magic, VIRTUAL_TEXTURE_MAGIC, sizeof(VIRTUAL_TEXTURE_MAGIC));
+    header.version = VIRTUAL_TEXTURE_VERSION;
+    header.format = static_cast<uint32_t>(state.options.compression == TextureCompression::None
+                                              ? TexelFormat::RGBA8
+                                              : static_cast<TexelFormat>(state.options.compression));
+    header.pageSize = VT_PAGE_SIZE;
+    header.pageBorder = VT_PAGE_BORDER;
+    header.flipY = state.options.flipY ? 1u : 0u;
+    header.mipKey = MipOptionsKey(state.options.mips);
+
+    std::string path;
+    if (state.paths.size() == 1) {
+        path = std::filesystem::path(first).replace_extension(".pbrvt").string();
+        if (!StatSource(first, header.sourceSize, header.sourceMTime)) {
+            std::cerr << "Failed to load texture at: " << first << std::endl;
+            return;
+        }
+        header.sourceHash = HashFileSampled(first);
+    } else {
+        // Packed maps: named and validated by the inputs' content, like packed .pbrtex caches
+        std::vector<uint64_t> hashes(state.paths.size() + 1, 0);
+        hashes.back() = state.paths.size();
+        std::string directory;
+        for (size_t c = 0; c < state.paths.size(); ++c) {
+            if (state.paths[c].empty()) continue;
+            MappedFile file;
+            if (!file.open(state.paths[c])) {
+                std::cerr << "Failed to load texture at: " << state.paths[c] << std::endl;
+                return;
+            }
+            hashes[c] = HashBytes(file.data(), file.size());
+            if (directory.empty()) directory = std::filesystem::path(state.paths[c]).parent_path().string();
+        }
+        header.contentHash = HashBytes(hashes.data(), hashes.size() * sizeof(uint64_t));
+        path = std::filesystem::path(PackedTextureCachePath(directory.empty() ? "." : directory, header.contentHash))
+                   .replace_extension(".pbrvt")
+                   .string();
+    }
+
+    if (OpenTiledFile(path, header, false, state)) {
+        state.ok = true;
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    state.ok = BuildTiledFile(state, path, header);
+    if (state.ok)
+        std::cout << "Virtual texture built: " << path << " (" << state.width << "x" << state.height << ", "
+                  << state.pageOffsets.size() << " pages) in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count() << " s" << std::endl;
+}
+
+// ─────────────────────────────────────────────
+// Page cache
+// ─────
+// Pages one screen shows at one level, times three (the coarser level beside it, pages
+// coming into view, LRU slack), never more than the texture has
+static int SlotsPerSide(const VirtualTextureState& state, int viewWidth, int viewHeight) {
+    size_t pinned = 0;
+    for (const VirtualLevel& level : state.levels)
+        if (level.pagesX * level.pagesY == 1) ++pinned;
+    const size_t screenPages = static_cast<size_t>(PagesAcross(viewWidth) + 1) * (PagesAcross(viewHeight) + 1);
+    const size_t needed = std::min(3 * screenPages + pinned, state.pageOffsets.size());
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(needed))));
+    return std::max(1, std::min({ side, maxSize / VT_PAGE_STRIDE, 255 }));
+}
+
+static void UploadPage(const VirtualTextureState& state, int slot, const unsigned char* data) {
+    const int x = (slot % state.slotsPerSide) * VT_PAGE_STRIDE;
+    const int y = (slot / state.slotsPerSide) * VT_PAGE_STRIDE;
+    glBindTexture(GL_TEXTURE_2D, state.physical);
+    if (IsCompressedFormat(state.format))
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, VT_PAGE_STRIDE, VT_PAGE_STRIDE, state.internalFormat,
+                                  static_cast<GLsizei>(state.pageBytes), data);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, VT_PAGE_STRIDE, VT_PAGE_STRIDE, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
+// A free slot, else the least recently seen page the last feedback didn't ask for; -1 when
+// the view needs more pages than the cache holds (those pages show a coarser level)
+static int AllocateSlot(VirtualTextureState& state) {
+    int best = -1;
+    for (int s = 0; s < static_cast<int>(state.slots.size()); ++s) {
+        const CacheSlot& slot = state.slots[s];
+        if (slot.page < 0) return s;
+        if (!slot.pinned && slot.lastSeen < state.lastFeedback &&
+            (best < 0 || slot.lastSeen < state.slots[best].lastSeen))
+            best = s;
+    }
+    if (best >= 0) {
+        state.pageSlots[state.slots[best].page] = -1;
+        state.slots[best].page = -1;
+        --state.residentPages;
+        ++g_stats.pageEvictions;
+        state.indirectionDirty = true;
+    }
+    return best;
+}
+
+static bool StorePage(VirtualTextureState& state, uint32_t page, const unsigned char* data, bool pinned) {
+    const int slot = AllocateSlot(state);
+    if (slot < 0) return false;
+    UploadPage(state, slot, data);
+    state.slots[slot] = { static_cast<int32_t>(page), state.pageWanted[page], pinned };
+    state.pageSlots[page] = slot;
+    ++state.residentPages;
+    ++g_stats.pageLoads;
+    state.indirectionDirty = true;
+    return true;
+}
+
+// Every page points at itself when resident, else at whatever its parent points at
+static void UpdateIndirection(VirtualTextureState& state) {
+    const int levelCount = static_cast<int>(state.levels.size());
+    for (int l = levelCount - 1; l >= 0; --l) {
+        const VirtualLevel& level = state.levels[l];
+        for (int y = 0; y < level.pagesY; ++y) {
+            for (int x = 0; x < level.pagesX; ++x) {
+                unsigned char* entry =
+                    state.indirectionTexels.data() +
+                    (static_cast<size_t>(level.atlasY + y) * state.atlasWidth + level.atlasX + x) * 4;
+                const int slot = state.pageSlots[PageIndex(state, l, x, y)];
+                if (slot >= 0) {
+                    entry[0] = static_cast<unsigned char>(slot % state.slotsPerSide);
+                    entry[1] = static_cast<unsigned char>(slot / state.slotsPerSide);
+                    entry[2] = static_cast<unsigned char>(l);
+                    entry[3] = 255;
+                } else if (l + 1 < levelCount) {
+                    const VirtualLevel& parent = state.levels[l + 1];
+                    const int px = std::min(x >> 1, parent.pagesX - 1), py = std::min(y >> 1, parent.pagesY - 1);
+                    std::memcpy(entry,
+                                state.indirectionTexels.data() +
+                                    (static_cast<size_t>(parent.atlasY + py) * state.atlasWidth + parent.atlasX + px) * 4,
+                                4);
+                } else {
+                    std::memset(entry, 0, 4);
+                }
+            }
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, state.indirection);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, state.atlasWidth, state.atlasHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                    state.indirectionTexels.data());
+    state.indirectionDirty = false;
+}
+
+// (Re)creates the physical cache for `slotsPerSide`^2 slots and puts the single-page levels in
+static void CreatePageCache(VirtualTextureState& state, int slotsPerSide) {
+    DeleteTrackedTexture(GpuMemoryKind::MaterialTexture, state.physical);
+    state.slotsPerSide = slotsPerSide;
+    state.slots.assign(static_cast<size_t>(slotsPerSide) * slotsPerSide, CacheSlot());
+    state.pageSlots.assign(state.pageOffsets.size(), -1);
+    state.residentPages = 0;
+
+    const int size = slotsPerSide * VT_PAGE_STRIDE;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glGenTextures(1, &state.physical);
+    glBindTexture(GL_TEXTURE_2D, state.physical);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    if (IsCompressedFormat(state.format))
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0, state.internalFormat, size, size, 0,
+                               static_cast<GLsizei>(TexelLevelSize(state.format, size, size)), nullptr);
+    else
+        glTexImage2D(GL_TEXTURE_2D, 0, state.internalFormat, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    TrackTextureMemory(GpuMemoryKind::MaterialTexture, GL_TEXTURE_2D, state.physical, "virtual pages: " + state.name);
+    SetGpuMemoryState(GpuMemoryKind::MaterialTexture, state.physical, "page cache");
+
+    for (int l = 0; l < static_cast<int>(state.levels.size()); ++l) {
+        if (state.levels[l].pagesX * state.levels[l].pagesY != 1) continue;
+        const uint32_t page = static_cast<uint32_t>(state.levels[l].firstPage);
+        StorePage(state, page, state.file.data() + state.pageOffsets[page], true);
+    }
+    state.indirectionDirty = true;
+}
+
+static void CreateGpuResources(VirtualTextureState& state) {
+    TextureOptions options = state.options;
+    options.compression = IsCompressedFormat(state.format) ? static_cast<TextureCompression>(state.format)
+                                                          : TextureCompression::None;
+    state.internalFormat = TextureInternalFormat(options, 4);
+    state.pageLoading.assign(state.pageOffsets.size(), 0);
+    state.pageWanted.assign(state.pageOffsets.size(), 0);
+    state.indirectionTexels.assign(static_cast<size_t>(state.atlasWidth) * state.atlasHeight * 4, 0);
+
+    glGenTextures(1, &state.indirection);
+    glBindTexture(GL_TEXTURE_2D, state.indirection);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, state.atlasWidth, state.atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 nullptr);
+    TrackTextureMemory(GpuMemoryKind::MaterialTexture, GL_TEXTURE_2D, state.indirection,
+                       "virtual indirection: " + state.name);
+
+    GLint viewport[4] = {};
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    CreatePageCache(state, SlotsPerSide(state, g_viewWidth ? g_viewWidth : viewport[2],
+                                        g_viewHeight ? g_viewHeight : viewport[3]));
+    UpdateIndirection(state);
+}
+
+static void DestroyState(VirtualTextureState& state) {
+    state.released.store(true, std::memory_order_relaxed);
+    DeleteTrackedTexture(GpuMemoryKind::MaterialTexture, state.physical);
+    DeleteTrackedTexture(GpuMemoryKind::MaterialTexture, state.indirection);
+    g_states.erase(std::remove_if(g_states.begin(), g_states.end(),
+                                  [&](const std::shared_ptr<VirtualTextureState>& s) { return s.get() == &state; }),
+                   g_states.end());
+}
+
+void RequestVirtualTexture(VirtualTexture& vt, const std::vector<std::string>& channelPaths,
+                           const TextureOptions& options) {
+    if (vt.pending) DestroyState(*vt.pending); // superseded before it was ready
+    auto state = std::make_shared<VirtualTextureState>();
+    state->owner = &vt;
+    state->paths = channelPaths;
+    for (size_t c = 0; c < channelPaths.size(); ++c)
+        state->name += (c ? ", " : "") + (channelPaths[c].empty() ? std::string("-") : channelPaths[c]);
+    state->options = options;
+    state->options.compression = EffectiveTextureCompression(options);
+    if (DefaultMipFilter() == MipFilter::Box) state->options.mips.filter = MipFilter::Box;
+    state->queued = std::chrono::steady_clock::now();
+    vt.pending = state;
+    g_states.push_back(state);
+    RunAsync([state]() {
+        state->error = CaptureJobError([&]() { PrepareTiledFile(*state); });
+        if (!state->error.empty()) state->ok = false;
+        state->built.store(true, std::memory_order_release);
+    });
+}
+
+void ReleaseVirtualTexture(VirtualTexture& vt) {
+    if (vt.pending) DestroyState(*vt.pending);
+    if (vt.state) DestroyState(*vt.state);
+    vt.pending.reset();
+    vt.state.reset();
+}
+
+// ─────────────────────────────────────────────
+// Feedback pass
+// ─────
+GLuint InitVirtualTextures() {
+    std::string vertexSource = ReadTextFile("shaders/basic.vert");
+    std::string fragSource = ReadTextFile("shaders/vt_feedback.frag");
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertexSource.c_str());
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragSource.c_str());
+    g_feedbackProgram = LinkProgram(vs, fs);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint success = 0;
+    glGetProgramiv(g_feedbackProgram, GL_LINK_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetProgramInfoLog(g_feedbackProgram, 512, NULL, infoLog);
+        std::cout << "VIRTUAL TEXTURE FEEDBACK SHADER LINKING FAILED: " << infoLog << std::endl;
+    }
+    g_feedbackScaleLoc = ULoc(g_feedbackProgram, "uFeedbackScale");
+    return g_feedbackProgram;
+}
+
+bool VirtualTexturesActive() {
+    for (const auto& state : g_states)
+        if (state->physical) return true;
+    return false;
+}
+
+static void ResizeFeedbackTarget(int width, int height) {
+    if (width == g_feedbackWidth && height == g_feedbackHeight && g_feedbackFbo) return;
+    g_feedbackWidth = width;
+    g_feedbackHeight = height;
+    if (!g_feedbackFbo) {
+        glGenFramebuffers(1, &g_feedbackFbo);
+        glGenTextures(1, &g_feedbackColor);
+        glGenRenderbuffers(1, &g_feedbackDepth);
+    }
+    glBindTexture(GL_TEXTURE_2D, g_feedbackColor);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT, nullptr);
+    glBindRenderbuffer(GL_RENDERBUFFER, g_feedbackDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, g_feedbackFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, g_feedbackColor, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, g_feedbackDepth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "Virtual texture feedback framebuffer incomplete" << std::endl;
+}
+
+void BeginVirtualTextureFeedback(int framebufferWidth, int framebufferHeight) {
+    g_viewWidth = framebufferWidth;
+    g_viewHeight = framebufferHeight;
+    ResizeFeedbackTarget(std::max(1, (framebufferWidth + VT_FEEDBACK_DIVISOR - 1) / VT_FEEDBACK_DIVISOR),
+                         std::max(1, (framebufferHeight + VT_FEEDBACK_DIVISOR - 1) / VT_FEEDBACK_DIVISOR));
+    glBindFramebuffer(GL_FRAMEBUFFER, g_feedbackFbo);
+    glViewport(0, 0, g_feedbackWidth, g_feedbackHeight);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, g_clearColor);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // alpha 0 = nothing drawn there
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glUseProgram(g_feedbackProgram);
+    glUniform1f(g_feedbackScaleLoc, 1.0f / VT_FEEDBACK_DIVISOR);
+}
+
+void EndVirtualTextureFeedback() {
+    // Read into the next ring buffer unless its last readback hasn't been consumed yet
+    FeedbackReadback& readback = g_readbacks[g_nextReadback];
+    if (!readback.fence) {
+        const size_t size = static_cast<size_t>(g_feedbackWidth) * g_feedbackHeight * 4 * sizeof(uint16_t);
+        if (!readback.buffer) glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        if (readback.size != size) {
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+            readback.size = size;
+        }
+        glReadPixels(0, 0, g_feedbackWidth, g_feedbackHeight, GL_RGBA, GL_UNSIGNED_SHORT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.width = g_feedbackWidth;
+        readback.height = g_feedbackHeight;
+        readback.frame = ++g_feedbackFrame;
+        g_nextReadback = (g_nextReadback + 1) % FEEDBACK_RING_SIZE;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, g_viewWidth, g_viewHeight);
+    glClearColor(g_clearColor[0], g_clearColor[1], g_clearColor[2], g_clearColor[3]);
+}
+
+// Marks the page under (u, v) at `level` and its ancestors as wanted in `frame`
+static void MarkWanted(VirtualTextureState& state, int level, float u, float v, uint64_t frame,
+                       std::vector<uint32_t>& wanted) {
+    for (int l = level; l < static_cast<int>(state.levels.size()); ++l) {
+        const VirtualLevel& info = state.levels[l];
+        const int x = std::min(static_cast<int>(u * info.width) / VT_PAGE_SIZE, info.pagesX - 1);
+        const int y = std::min(static_cast<int>(v * info.height) / VT_PAGE_SIZE, info.pagesY - 1);
+        const size_t page = PageIndex(state, l, x, y);
+        if (state.pageWanted[page] == frame) return; // and so are its ancestors
+        state.pageWanted[page] = frame;
+        wanted.push_back(static_cast<uint32_t>(page));
+    }
+}
+
+static int PageLevel(const VirtualTextureState& state, uint32_t page) {
+    int level = 0;
+    while (level + 1 < static_cast<int>(state.levels.size()) && state.levels[level + 1].firstPage <= page) ++level;
+    return level;
+}
+
+// Feedback texels: R, G = fract(UV), B = -log2(UV footprint) / 32, A = 1 where drawn
+static void ProcessFeedback(const std::shared_ptr<VirtualTextureState>& shared, const uint16_t* texels, int width,
+                            int height, uint64_t frame) {
+    VirtualTextureState& state = *shared;
+    const float logSize = std::log2(static_cast<float>(std::max(state.width, state.height)));
+    const float maxLevel = static_cast<float>(state.levels.size() - 1);
+    std::vector<uint32_t> wanted;
+    for (size_t i = 0, count = static_cast<size_t>(width) * height; i < count; ++i) {
+        const uint16_t* t = texels + i * 4;
+        if (t[3] == 0) continue;
+        // Same level choice as SampleVirtual in basic.frag
+        const float lod = -t[2] * (32.0f / 65535.0f) + logSize;
+        const int level = static_cast<int>(std::min(std::max(std::floor(lod + 0.5f), 0.0f), maxLevel));
+        MarkWanted(state, level, t[0] / 65535.0f, t[1] / 65535.0f, frame, wanted);
+    }
+    state.lastFeedback = frame;
+
+    // Resident pages are touched; missing ones are read coarse levels first, so the
+    // fallbacks sharpen step by step
+    std::vector<uint32_t> missing;
+    for (uint32_t page : wanted) {
+        const int slot = state.pageSlots[page];
+        if (slot >= 0)
+            state.slots[slot].lastSeen = frame;
+        else if (!state.pageLoading[page])
+            missing.push_back(page);
+    }
+    std::stable_sort(missing.begin(), missing.end(),
+                     [&](uint32_t a, uint32_t b) { return PageLevel(state, a) > PageLevel(state, b); });
+    for (uint32_t page : missing) {
+        if (state.loadsInFlight >= VT_MAX_LOADS_IN_FLIGHT) break; // the next feedback asks again
+        state.pageLoading[page] = 1;
+        ++state.loadsInFlight;
+        RunAsync([shared, page]() {
+            if (shared->released.load(std::memory_order_relaxed)) return;
+            // Touching the mapping here puts the disk read on the worker, not the GL thread
+            const unsigned char* src = shared->file.data() + shared->pageOffsets[page];
+            LoadedPage loaded;
+            loaded.page = page;
+            // Handed back empty on failure, so the page is not stuck "in flight" and is asked for again
+            loaded.error = CaptureJobError([&]() { loaded.data.assign(src, src + shared->pageBytes); });
+            std::lock_guard<std::mutex> lock(shared->loadMutex);
+            shared->loaded.push_back(std::move(loaded));
+        });
+    }
+}
+
+// Oldest completed readbacks first, without waiting on the GPU
+static void ReadFeedback() {
+    for (size_t i = 0; i < FEEDBACK_RING_SIZE; ++i) {
+        FeedbackReadback& readback = g_readbacks[(g_nextReadback + i) % FEEDBACK_RING_SIZE];
+        if (!readback.fence) continue;
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(readback.size),
+                                              GL_MAP_READ_BIT);
+        if (mapped) {
+            for (const auto& state : g_states)
+                if (state->physical)
+                    ProcessFeedback(state, static_cast<const uint16_t*>(mapped), readback.width, readback.height,
+                                    readback.frame);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+}
+
+// Loaded pages into the cache, up to VT_MAX_UPLOADS_PER_FRAME
+static void UploadLoadedPages(VirtualTextureState& state) {
+    std::vector<LoadedPage> pages;
+    {
+        std::lock_guard<std::mutex> lock(state.loadMutex);
+        const size_t count = std::min(state.loaded.size(), VT_MAX_UPLOADS_PER_FRAME);
+        pages.assign(std::make_move_iterator(state.loaded.begin()),
+                     std::make_move_iterator(state.loaded.begin() + count));
+        state.loaded.erase(state.loaded.begin(), state.loaded.begin() + count);
+    }
+    if (pages.empty()) return;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (const LoadedPage& page : pages) {
+        --state.loadsInFlight;
+        state.pageLoading[page.page] = 0;
+        if (!page.error.empty())
+            std::cerr << "Virtual texture page read failed: " << state.name << ": " << page.error << std::endl;
+        else if (state.pageSlots[page.page] < 0)
+            StorePage(state, page.page, page.data.data(), false);
+    }
+}
+
+void UpdateVirtualTextures() {
+    // Finished builds replace what their owner shows
+    const auto states = g_states;
+    for (const auto& state : states) {
+        if (state->physical || !state->built.load(std::memory_order_acquire)) continue;
+        VirtualTexture& vt = *state->owner;
+        vt.pending.reset();
+        if (!state->ok) {
+            std::cerr << "Virtual texture failed, keeping the previous map: " << state->name
+                      << (state->error.empty() ? "" : ": " + state->error) << std::endl;
+            DestroyState(*state);
+            continue;
+        }
+        CreateGpuResources(*state);
+        if (vt.state) DestroyState(*vt.state);
+        vt.state = state;
+        std::cout << "Virtual texture " << state->name << ": " << state->width << "x" << state->height << ", "
+                  << state->levels.size() << " levels, " << state->pageOffsets.size() << " pages, "
+                  << state->slots.size() << "-page cache, visible after "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - state->queued).count() << " s"
+                  << std::endl;
+    }
+
+    ReadFeedback();
+    for (const auto& state : g_states) {
+        if (!state->physical) continue;
+        // The cache follows the framebuffer: grow at once, shrink once it is well oversized
+        if (g_viewWidth > 0) {
+            const int side = SlotsPerSide(*state, g_viewWidth, g_viewHeight);
+            if (side > state->slotsPerSide || side * 4 < state->slotsPerSide * 3) CreatePageCache(*state, side);
+        }
+        UploadLoadedPages(*state);
+        if (state->indirectionDirty) UpdateIndirection(*state);
+    }
+}
+
+void BindVirtualTexture(const VirtualTexture& vt, GLuint program, const std::string& name, int unit) {
+    const GLint sizeLoc = glGetUniformLocation(program, (name + ".size").c_str());
+    if (!vt.ready()) {
+        glUniform4f(sizeLoc, 0.0f, 0.0f, 0.0f, 0.0f);
+        return;
+    }
+    const VirtualTextureState& state = *vt.state;
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, state.physical);
+    glActiveTexture(GL_TEXTURE0 + unit + 1);
+    glBindTexture(GL_TEXTURE_2D, state.indirection);
+    glUniform1i(glGetUniformLocation(program, (name + "Pages").c_str()), unit);
+    glUniform1i(glGetUniformLocation(program, (name + "Indirection").c_str()), unit + 1);
+
+    glUniform4f(sizeLoc, static_cast<float>(state.width), static_cast<float>(state.height),
+                static_cast<float>(state.levels.size()),
+                std::log2(static_cast<float>(std::max(state.width, state.height))));
+    glUniform4f(glGetUniformLocation(program, (name + ".layout").c_str()),
+                1.0f / (state.slotsPerSide * VT_PAGE_STRIDE), static_cast<float>(VT_PAGE_SIZE),
+                static_cast<float>(VT_PAGE_BORDER), static_cast<float>(VT_PAGE_STRIDE));
+    GLint levels[VT_MAX_LEVELS * 4] = {};
+    for (size_t l = 0; l < state.levels.size(); ++l) {
+        levels[l * 4 + 0] = state.levels[l].atlasX;
+        levels[l * 4 + 1] = state.levels[l].atlasY;
+        levels[l * 4 + 2] = state.levels[l].pagesX;
+        levels[l * 4 + 3] = state.levels[l].pagesY;
+    }
+    glUniform4iv(glGetUniformLocation(program, (name + ".levels").c_str()), VT_MAX_LEVELS, levels);
+}
+
+VirtualTextureStats GetVirtualTextureStats() {
+    VirtualTextureStats stats = g_stats;
+    for (const auto& state : g_states) {
+        if (!state->physical) continue;
+        ++stats.textures;
+        stats.residentPages += state->residentPages;
+        stats.slots += state->slots.size();
+        stats.cacheBytes += TexelLevelSize(state->format, state->slotsPerSide * VT_PAGE_STRIDE,
+                                           state->slotsPerSide * VT_PAGE_STRIDE) +
+                            state->indirectionTexels.size();
+    }
+    return stats;
+}
+
+void ShutdownVirtualTextures() {
+    while (!g_states.empty()) {
+        VirtualTexture* owner = g_states.back()->owner;
+        DestroyState(*g_states.back());
+        if (owner) {
+            owner->state.reset();
+            owner->pending.reset();
+        }
+    }
+    for (FeedbackReadback& readback : g_readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        if (readback.buffer) glDeleteBuffers(1, &readback.buffer);
+        readback = FeedbackReadback();
+    }
+    if (g_feedbackFbo) glDeleteFramebuffers(1, &g_feedbackFbo);
+    if (g_feedbackColor) glDeleteTextures(1, &g_feedbackColor);
+    if (g_feedbackDepth) glDeleteRenderbuffers(1, &g_feedbackDepth);
+    if (g_feedbackProgram) glDeleteProgram(g_feedbackProgram);
+    g_feedbackFbo = g_feedbackColor = g_feedbackDepth = g_feedbackProgram = 0;
+    g_feedbackWidth = g_feedbackHeight = 0;
+}
@@ -0,0 +1,89 @@
+// virtual_texture.h
+#pragma once
+#include <glad/glad.h>
+#include "texture_loader.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ─────────────────────────────────────────────
+// Virtual textures
+// ─────
+// Maps too large for the GPU memory budget (scanned 16K materials) are never
+// uploaded whole. Their mip chain is cut into pages of VT_PAGE_SIZE^2 texels plus
+// a VT_PAGE_BORDER copied from the neighbours (bilinear filtering across page
+// edges), block-compressed like the regular maps and stored in a tiled file next
+// to the image ("rock.png" -> "rock.pbrvt"), built once on the job system.
+// The GPU holds a physical page cache (one texture, pages side by side) and an
+// indirection atlas with one texel per page of every level, naming the cache slot
+// that holds it or, for pages not resident, the nearest coarser one that is.
+// A feedback pass renders the scene's UVs and texel footprints at
+// 1/VT_FEEDBACK_DIVISOR of the framebuffer; the readback (a PBO, a frame or two
+// later) says which pages the view needs. Missing ones are read from the
+// memory-mapped file by background jobs and uploaded a few per frame; the least
+// recently seen pages make room. Levels that fit one page stay resident, so every
+// texel always has something to show. The cache is sized from the framebuffer,
+// so memory follows the screen resolution rather than the source resolution.
+// basic.frag samples through SampleVirtual; there is no filtering between levels.
+const int VT_PAGE_SIZE = 128;
+const int VT_PAGE_BORDER = 4;                                  // a whole 4x4 block, so pages compress independently
+const int VT_PAGE_STRIDE = VT_PAGE_SIZE + 2 * VT_PAGE_BORDER;  // 136 texels per cache slot side
+const int VT_MAX_LEVELS = 16;                                  // matches VirtualTextureInfo.levels in basic.frag
+const int VT_FEEDBACK_DIVISOR = 8;                             // a page covers >= 128 pixels, so 1/8 still sees it
+const size_t VT_MAX_LOADS_IN_FLIGHT = 64;
+const size_t VT_MAX_UPLOADS_PER_FRAME = 32;
+
+struct VirtualTextureState; // file, page table and cache slots (virtual_texture.cpp)
+
+// One virtual map. Replacing it (a second request) keeps the current pages on screen
+// until the new one is ready.
+struct VirtualTexture {
+    std::shared_ptr<VirtualTextureState> state;   // the one being shown
+    std::shared_ptr<VirtualTextureState> pending; // still building its tiled file
+
+    bool ready() const;
+};
+
+// Maps whose larger side reaches PBR_VIRTUAL_TEXTURE_SIZE (8192 by default; 0 turns
+// virtual texturing off) go through a virtual texture instead of the registry. A .pbrvt
+// picked directly always does. Only reads the image headers.
+bool WantsVirtualTexture(const std::vector<std::string>& channelPaths);
+
+// Builds or opens the tiled file in the background; one path, or one per packed channel
+// like RequestPackedTexture2D. `options` pick the page encoding and mip filter.
+void RequestVirtualTexture(VirtualTexture& vt, const std::vector<std::string>& channelPaths,
+                           const TextureOptions& options);
+void ReleaseVirtualTexture(VirtualTexture& vt);
+
+// Compiles the feedback shader (basic.vert + shaders/vt_feedback.frag) and returns its
+// program, so the caller can look up and set the vertex uniforms it shares with basic.vert
+GLuint InitVirtualTextures();
+
+// Feedback pass, when any virtual texture is ready: Begin binds the (resized) feedback
+// framebuffer and program; draw the scene with the same transforms; End queues the
+// readback and rebinds the default framebuffer with a (w, h) viewport
+bool VirtualTexturesActive();
+void BeginVirtualTextureFeedback(int framebufferWidth, int framebufferHeight);
+void EndVirtualTextureFeedback();
+
+// Once per frame on the GL thread: finishes builds, turns the oldest completed feedback
+// into page loads and uploads up to VT_MAX_UPLOADS_PER_FRAME loaded pages
+void UpdateVirtualTextures();
+
+// Binds the cache and indirection atlas to units `unit` and `unit + 1` and sets the
+// `<name>Pages` / `<name>Indirection` samplers and `<name>` VirtualTextureInfo of `program`.
+// Not ready: `<name>.size` is zeroed, which basic.frag reads as "sample the regular map".
+void BindVirtualTexture(const VirtualTexture& vt, GLuint program, const std::string& name, int unit);
+
+struct VirtualTextureStats {
+    size_t textures = 0;      // ready virtual textures
+    size_t residentPages = 0; // pages in the caches
+    size_t slots = 0;         // cache slots over all textures
+    size_t cacheBytes = 0;    // physical caches + indirection atlases
+    size_t pageLoads = 0;     // pages read and uploaded so far
+    size_t pageEvictions = 0; // pages dropped for a newer one
+};
+VirtualTextureStats GetVirtualTextureStats();
+
+void ShutdownVirtualTextures(); // frees every virtual texture and the feedback pass